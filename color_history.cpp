@@ -0,0 +1,187 @@
+#include "color_history.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// =======================================================
+// File layout
+// =======================================================
+
+// an 8-byte header, then one record per pick in the order they were made (native byte order)
+static const char HISTORY_MAGIC[8] = { 'R', 'G', 'B', 'H', 'I', 'S', '1', '\0' };
+
+struct HistoryRecord
+{
+    float color[4];
+    int64_t timeMs;
+    uint32_t dropped;  // undone entries the pick replaced; replay drops them again
+    uint32_t reserved;
+};
+static_assert(sizeof(HistoryRecord) == 32, "history records are 32 bytes on disk");
+
+static int64_t nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// =======================================================
+// Ring
+// =======================================================
+
+ColorHistory::~ColorHistory()
+{
+    close();
+}
+
+void ColorHistory::record(const HistoryEntry& entry, int dropped)
+{
+    count -= dropped;
+    if (count == HISTORY_CAPACITY)
+    {
+        first = (first + 1) % HISTORY_CAPACITY;
+        --count;
+    }
+    entries[(first + count) % HISTORY_CAPACITY] = entry;
+    current = count++;
+}
+
+void ColorHistory::push(glm::vec4 color)
+{
+    HistoryEntry entry = { color, nowMs() };
+    int dropped = count - (current + 1);
+    record(entry, dropped);
+    if (fd < 0)
+        return;
+    HistoryRecord r = { { color.r, color.g, color.b, color.a }, entry.timeMs, (uint32_t)dropped, 0 };
+    // O_APPEND: one write per pick, never a rewrite
+    if (write(fd, &r, sizeof(r)) != (ssize_t)sizeof(r))
+    {
+        std::cout << "ERROR::HISTORY::WRITE_FAILED, no longer saving picks" << std::endl;
+        close();
+    }
+}
+
+const HistoryEntry* ColorHistory::undo()
+{
+    if (current <= 0)
+        return nullptr;
+    return &at(--current);
+}
+
+const HistoryEntry* ColorHistory::redo()
+{
+    if (current + 1 >= count)
+        return nullptr;
+    return &at(++current);
+}
+
+// =======================================================
+// Persistence
+// =======================================================
+
+bool ColorHistory::open(const std::string& path)
+{
+    close();
+    first = 0;
+    count = 0;
+    current = -1;
+    if (path.empty())
+        return true;
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        std::cout << "ERROR::HISTORY::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    size_t records = 0;
+    bool valid = true;
+    if (st.st_size == 0)
+        valid = write(fd, HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) == (ssize_t)sizeof(HISTORY_MAGIC);
+    else
+    {
+        // a partial record at the end is a pick interrupted while being written: cut it off
+        std::vector<char> data((size_t)st.st_size);
+        valid = pread(fd, data.data(), data.size(), 0) == (ssize_t)data.size() && data.size() >= sizeof(HISTORY_MAGIC) &&
+            memcmp(data.data(), HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) == 0;
+        if (valid)
+        {
+            records = (data.size() - sizeof(HISTORY_MAGIC)) / sizeof(HistoryRecord);
+            for (size_t i = 0; i < records; ++i)
+            {
+                HistoryRecord r;
+                memcpy(&r, data.data() + sizeof(HISTORY_MAGIC) + i * sizeof(HistoryRecord), sizeof(r));
+                int dropped = (int)std::min<uint32_t>(r.dropped, (uint32_t)count);
+                record({ glm::vec4(r.color[0], r.color[1], r.color[2], r.color[3]), r.timeMs }, dropped);
+            }
+            size_t whole = sizeof(HISTORY_MAGIC) + records * sizeof(HistoryRecord);
+            if (whole != data.size() && ftruncate(fd, (off_t)whole) != 0)
+                valid = false;
+        }
+        else
+            std::cout << "ERROR::HISTORY::NOT_A_HISTORY_FILE " << path << std::endl;
+    }
+    ::close(fd);
+    fd = -1;
+    if (!valid)
+    {
+        first = 0;
+        count = 0;
+        current = -1;
+        return false;
+    }
+    if (records > HISTORY_COMPACT_RECORDS && !rewrite(path))
+        return false;
+
+    fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+    if (fd < 0)
+    {
+        std::cout << "ERROR::HISTORY::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// replaces the file with one holding only the ring, written aside and renamed over it
+bool ColorHistory::rewrite(const std::string& path)
+{
+    std::string temp = path + ".tmp";
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (!f)
+    {
+        std::cout << "ERROR::HISTORY::CANNOT_COMPACT " << path << std::endl;
+        return false;
+    }
+    bool ok = fwrite(HISTORY_MAGIC, sizeof(HISTORY_MAGIC), 1, f) == 1;
+    for (int i = 0; i < count && ok; ++i)
+    {
+        const HistoryEntry& e = at(i);
+        HistoryRecord r = { { e.color.r, e.color.g, e.color.b, e.color.a }, e.timeMs, 0, 0 };
+        ok = fwrite(&r, sizeof(r), 1, f) == 1;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0)
+    {
+        std::cout << "ERROR::HISTORY::CANNOT_COMPACT " << path << std::endl;
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ColorHistory::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// =======================================================
+// Picked color history: undo/redo ring buffer, persisted
+// =======================================================
+
+// picks kept; the oldest is overwritten once the ring is full
+#define HISTORY_CAPACITY 256
+// the file is rewritten with just the ring when it holds more records than this
+#define HISTORY_COMPACT_RECORDS (HISTORY_CAPACITY * 16)
+
+struct HistoryEntry
+{
+    glm::vec4 color;  // sRGB + alpha, as shown in the output box
+    int64_t timeMs;   // wall clock, milliseconds since the Unix epoch
+};
+
+// The colors picked so far, with a cursor that undo and redo move. Entries live in a fixed
+// ring inside the object, so recording a pick never allocates; a pick made after undoing
+// drops the undone entries, like an editor's undo stack.
+//
+// Each pick is also appended to a binary file as one 32-byte record (see color_history.cpp),
+// so the file is never rewritten on the hot path and a crash loses at most the pick being
+// written. open() replays the file, which restores the ring; the cursor starts at the newest
+// entry, since undo and redo themselves aren't recorded.
+class ColorHistory
+{
+public:
+    ~ColorHistory();
+
+    // replays the history file, creating it if missing, and appends to it from then on. An
+    // empty path keeps the history in memory only. False (with the history empty) if the file
+    // can't be used
+    bool open(const std::string& path);
+    void close();
+
+    // records a pick as the current entry
+    void push(glm::vec4 color);
+    // moves the cursor one entry back or forward; the entry now current, or nullptr at either end
+    const HistoryEntry* undo();
+    const HistoryEntry* redo();
+
+    // entries up to and including the current one
+    int depth() const { return current + 1; }
+    // i-th entry back from the current one (0 is current), i < depth()
+    const HistoryEntry& recent(int i) const { return at(current - i); }
+
+private:
+    const HistoryEntry& at(int i) const { return entries[(first + i) % HISTORY_CAPACITY]; }
+    void record(const HistoryEntry& entry, int dropped);
+    bool rewrite(const std::string& path);
+
+    std::array<HistoryEntry, HISTORY_CAPACITY> entries;
+    int first = 0;     // ring slot of the oldest entry
+    int count = 0;     // entries held, including the undone ones after the cursor
+    int current = -1;  // index of the current entry from the oldest; -1 when empty
+    int fd = -1;
+};
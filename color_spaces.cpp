@@ -0,0 +1,799 @@
+#include "color_spaces.hpp"
+#include "simd_math.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// =======================================================
+// Constants
+// =======================================================
+
+// linear sRGB <-> XYZ (D65), IEC 61966-2-1
+static const double RGB_TO_XYZ[9] = {
+    0.4124564, 0.3575761, 0.1804375,
+    0.2126729, 0.7151522, 0.0721750,
+    0.0193339, 0.1191920, 0.9503041 };
+static const double XYZ_TO_RGB[9] = {
+     3.2404542, -1.5371385, -0.4985314,
+    -0.9692660,  1.8760108,  0.0415560,
+     0.0556434, -0.2040259,  1.0572252 };
+// D65 reference white, the row sums of RGB_TO_XYZ
+static const double WHITE[3] = { 0.9504700, 1.0, 1.0888300 };
+
+// OKLab (Ottosson 2020): linear sRGB -> cone response, and cube-rooted cones -> Lab
+static const double RGB_TO_LMS[9] = {
+    0.4122214708, 0.5363325363, 0.0514459929,
+    0.2119034982, 0.6806995451, 0.1073969566,
+    0.0883024619, 0.2817188376, 0.6299787005 };
+static const double LMS_TO_OKLAB[9] = {
+    0.2104542553,  0.7936177850, -0.0040720468,
+    1.9779984951, -2.4285922050,  0.4505937099,
+    0.0259040371,  0.7827717662, -0.8086757660 };
+static const double OKLAB_TO_LMS[9] = {
+    1.0,  0.3963377774,  0.2158037573,
+    1.0, -0.1055613458, -0.0638541728,
+    1.0, -0.0894841775, -1.2914855480 };
+static const double LMS_TO_RGB[9] = {
+     4.0767416621, -3.3077115913,  0.2309699292,
+    -1.2684380046,  2.6097574011, -0.3413193965,
+    -0.0041960863, -0.7034186147,  1.7076147010 };
+
+// CIELAB's linear segment: f(t) switches from the cube root at (6/29)^3
+static const double LAB_DELTA = 6.0 / 29.0;
+
+static const double PI = 3.14159265358979323846;
+
+// =======================================================
+// Scalar reference conversions
+// =======================================================
+
+const char* colorSpaceName(ColorSpace space)
+{
+    switch (space)
+    {
+    case ColorSpace::SRGB: return "sRGB";
+    case ColorSpace::LinearRGB: return "linear RGB";
+    case ColorSpace::XYZ: return "XYZ";
+    case ColorSpace::Lab: return "Lab";
+    case ColorSpace::LCh: return "LCh";
+    case ColorSpace::OKLab: return "OKLab";
+    case ColorSpace::OKLCh: return "OKLCh";
+    case ColorSpace::HSL: return "HSL";
+    case ColorSpace::HSV: return "HSV";
+    }
+    return "?";
+}
+
+static glm::vec3 mul(const double m[9], double x, double y, double z)
+{
+    return glm::vec3(
+        (float)(m[0] * x + m[1] * y + m[2] * z),
+        (float)(m[3] * x + m[4] * y + m[5] * z),
+        (float)(m[6] * x + m[7] * y + m[8] * z));
+}
+
+// the sRGB curve, extended linearly below zero so out-of-gamut values survive a round trip
+static double decodeSrgb(double c)
+{
+    if (c <= 0.04045) return c / 12.92;
+    return std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+static double encodeSrgb(double c)
+{
+    if (c <= 0.0031308) return c * 12.92;
+    return 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+}
+
+glm::vec3 linearRgbToXyz(glm::vec3 rgb)
+{
+    return mul(RGB_TO_XYZ, rgb.x, rgb.y, rgb.z);
+}
+
+glm::vec3 xyzToLinearRgb(glm::vec3 xyz)
+{
+    return mul(XYZ_TO_RGB, xyz.x, xyz.y, xyz.z);
+}
+
+static double labF(double t)
+{
+    if (t > LAB_DELTA * LAB_DELTA * LAB_DELTA) return std::cbrt(t);
+    return t / (3.0 * LAB_DELTA * LAB_DELTA) + 4.0 / 29.0;
+}
+
+static double labFInverse(double t)
+{
+    if (t > LAB_DELTA) return t * t * t;
+    return 3.0 * LAB_DELTA * LAB_DELTA * (t - 4.0 / 29.0);
+}
+
+glm::vec3 xyzToLab(glm::vec3 xyz)
+{
+    double fx = labF(xyz.x / WHITE[0]);
+    double fy = labF(xyz.y / WHITE[1]);
+    double fz = labF(xyz.z / WHITE[2]);
+    return glm::vec3((float)(116.0 * fy - 16.0), (float)(500.0 * (fx - fy)), (float)(200.0 * (fy - fz)));
+}
+
+glm::vec3 labToXyz(glm::vec3 lab)
+{
+    double fy = (lab.x + 16.0) / 116.0;
+    double fx = fy + lab.y / 500.0;
+    double fz = fy - lab.z / 200.0;
+    return glm::vec3((float)(WHITE[0] * labFInverse(fx)), (float)(WHITE[1] * labFInverse(fy)), (float)(WHITE[2] * labFInverse(fz)));
+}
+
+glm::vec3 linearRgbToOklab(glm::vec3 rgb)
+{
+    const double* m = RGB_TO_LMS;
+    double l = std::cbrt(m[0] * rgb.x + m[1] * rgb.y + m[2] * rgb.z);
+    double mm = std::cbrt(m[3] * rgb.x + m[4] * rgb.y + m[5] * rgb.z);
+    double s = std::cbrt(m[6] * rgb.x + m[7] * rgb.y + m[8] * rgb.z);
+    return mul(LMS_TO_OKLAB, l, mm, s);
+}
+
+glm::vec3 oklabToLinearRgb(glm::vec3 lab)
+{
+    const double* m = OKLAB_TO_LMS;
+    double l = m[0] * lab.x + m[1] * lab.y + m[2] * lab.z;
+    double mm = m[3] * lab.x + m[4] * lab.y + m[5] * lab.z;
+    double s = m[6] * lab.x + m[7] * lab.y + m[8] * lab.z;
+    return mul(LMS_TO_RGB, l * l * l, mm * mm * mm, s * s * s);
+}
+
+glm::vec3 labToLch(glm::vec3 lab)
+{
+    double h = std::atan2((double)lab.z, (double)lab.y) * 180.0 / PI;
+    if (h < 0.0) h += 360.0;
+    return glm::vec3(lab.x, (float)std::sqrt((double)lab.y * lab.y + (double)lab.z * lab.z), (float)h);
+}
+
+glm::vec3 lchToLab(glm::vec3 lch)
+{
+    double h = lch.z * PI / 180.0;
+    return glm::vec3(lch.x, (float)(lch.y * std::cos(h)), (float)(lch.y * std::sin(h)));
+}
+
+glm::vec3 srgbToHsl(glm::vec3 rgb)
+{
+    float mx = std::max(rgb.r, std::max(rgb.g, rgb.b));
+    float mn = std::min(rgb.r, std::min(rgb.g, rgb.b));
+    double l = (mx + mn) * 0.5;
+    double d = (double)mx - mn;
+    if (d <= 0.0) return glm::vec3(0.0f, 0.0f, (float)l);
+
+    double s = d / (1.0 - std::fabs(2.0 * l - 1.0));
+    double h;
+    if (mx == rgb.r) h = (rgb.g - rgb.b) / d;
+    else if (mx == rgb.g) h = (rgb.b - rgb.r) / d + 2.0;
+    else h = (rgb.r - rgb.g) / d + 4.0;
+    h *= 60.0;
+    if (h < 0.0) h += 360.0;
+    return glm::vec3((float)h, (float)s, (float)l);
+}
+
+// branch-free form: channel n is l - a * clamp(min(k - 3, 9 - k), -1, 1), k = (n + h / 30) mod 12
+static double hslChannel(double n, double h, double s, double l)
+{
+    double k = std::fmod(n + h / 30.0, 12.0);
+    if (k < 0.0) k += 12.0;
+    double a = s * std::min(l, 1.0 - l);
+    return l - a * std::max(-1.0, std::min(std::min(k - 3.0, 9.0 - k), 1.0));
+}
+
+glm::vec3 hslToSrgb(glm::vec3 hsl)
+{
+    return glm::vec3(
+        (float)hslChannel(0.0, hsl.x, hsl.y, hsl.z),
+        (float)hslChannel(8.0, hsl.x, hsl.y, hsl.z),
+        (float)hslChannel(4.0, hsl.x, hsl.y, hsl.z));
+}
+
+glm::vec3 srgbToHsv(glm::vec3 rgb)
+{
+    float mx = std::max(rgb.r, std::max(rgb.g, rgb.b));
+    float mn = std::min(rgb.r, std::min(rgb.g, rgb.b));
+    double d = (double)mx - mn;
+    if (d <= 0.0) return glm::vec3(0.0f, 0.0f, mx);
+
+    double h;
+    if (mx == rgb.r) h = (rgb.g - rgb.b) / d;
+    else if (mx == rgb.g) h = (rgb.b - rgb.r) / d + 2.0;
+    else h = (rgb.r - rgb.g) / d + 4.0;
+    h *= 60.0;
+    if (h < 0.0) h += 360.0;
+    return glm::vec3((float)h, mx > 0.0f ? (float)(d / mx) : 0.0f, mx);
+}
+
+// the picker's own conversion, a sector per 60 degrees of hue
+glm::vec3 HSVtoRGB(float H, float S, float V)
+{
+    float C = V * S;
+    float X = C * (1.0f - fabsf(fmodf(H / 60.0f, 2.0f) - 1.0f));
+    float m = V - C;
+    float r, g, b;
+    if (H >= 0 && H < 60) { r = C; g = X; b = 0; }
+    else if (H >= 60 && H < 120) { r = X; g = C; b = 0; }
+    else if (H >= 120 && H < 180) { r = 0; g = C; b = X; }
+    else if (H >= 180 && H < 240) { r = 0; g = X; b = C; }
+    else if (H >= 240 && H < 300) { r = X; g = 0; b = C; }
+    else { r = C; g = 0; b = X; }
+    return glm::vec3(r + m, g + m, b + m);
+}
+
+// =======================================================
+// Conversion plans
+// =======================================================
+
+// a conversion is a short list of stages; the batch versions run each stage over a whole
+// block of colors before the next, so the per-space dispatch happens once per block
+enum ConversionStage
+{
+    STAGE_SRGB_DECODE, STAGE_SRGB_ENCODE,
+    STAGE_XYZ_TO_RGB, STAGE_RGB_TO_XYZ,
+    STAGE_LAB_TO_XYZ, STAGE_XYZ_TO_LAB,
+    STAGE_OKLAB_TO_RGB, STAGE_RGB_TO_OKLAB,
+    STAGE_POLAR_TO_RECT, STAGE_RECT_TO_POLAR,
+    STAGE_HSL_TO_SRGB, STAGE_SRGB_TO_HSL,
+    STAGE_HSV_TO_SRGB, STAGE_SRGB_TO_HSV
+};
+
+// fills stages with the path from one space to the other, returns the count (at most 6);
+// everything goes through linear RGB except the polar/rectangular and HSL/HSV/sRGB pairs
+static int planConversion(ColorSpace from, ColorSpace to, ConversionStage* stages)
+{
+    int n = 0;
+    if (from == to) return 0;
+    if ((from == ColorSpace::Lab && to == ColorSpace::LCh) || (from == ColorSpace::OKLab && to == ColorSpace::OKLCh))
+    {
+        stages[n++] = STAGE_RECT_TO_POLAR;
+        return n;
+    }
+    if ((from == ColorSpace::LCh && to == ColorSpace::Lab) || (from == ColorSpace::OKLCh && to == ColorSpace::OKLab))
+    {
+        stages[n++] = STAGE_POLAR_TO_RECT;
+        return n;
+    }
+    if (from == ColorSpace::SRGB && to == ColorSpace::HSL)
+    {
+        stages[n++] = STAGE_SRGB_TO_HSL;
+        return n;
+    }
+    if (from == ColorSpace::HSL && to == ColorSpace::SRGB)
+    {
+        stages[n++] = STAGE_HSL_TO_SRGB;
+        return n;
+    }
+    if (from == ColorSpace::SRGB && to == ColorSpace::HSV)
+    {
+        stages[n++] = STAGE_SRGB_TO_HSV;
+        return n;
+    }
+    if (from == ColorSpace::HSV && to == ColorSpace::SRGB)
+    {
+        stages[n++] = STAGE_HSV_TO_SRGB;
+        return n;
+    }
+
+    switch (from)
+    {
+    case ColorSpace::SRGB: stages[n++] = STAGE_SRGB_DECODE; break;
+    case ColorSpace::LinearRGB: break;
+    case ColorSpace::XYZ: stages[n++] = STAGE_XYZ_TO_RGB; break;
+    case ColorSpace::LCh: stages[n++] = STAGE_POLAR_TO_RECT;
+        // fall through
+    case ColorSpace::Lab: stages[n++] = STAGE_LAB_TO_XYZ; stages[n++] = STAGE_XYZ_TO_RGB; break;
+    case ColorSpace::OKLCh: stages[n++] = STAGE_POLAR_TO_RECT;
+        // fall through
+    case ColorSpace::OKLab: stages[n++] = STAGE_OKLAB_TO_RGB; break;
+    case ColorSpace::HSL: stages[n++] = STAGE_HSL_TO_SRGB; stages[n++] = STAGE_SRGB_DECODE; break;
+    case ColorSpace::HSV: stages[n++] = STAGE_HSV_TO_SRGB; stages[n++] = STAGE_SRGB_DECODE; break;
+    }
+    switch (to)
+    {
+    case ColorSpace::SRGB: stages[n++] = STAGE_SRGB_ENCODE; break;
+    case ColorSpace::LinearRGB: break;
+    case ColorSpace::XYZ: stages[n++] = STAGE_RGB_TO_XYZ; break;
+    case ColorSpace::Lab: stages[n++] = STAGE_RGB_TO_XYZ; stages[n++] = STAGE_XYZ_TO_LAB; break;
+    case ColorSpace::LCh: stages[n++] = STAGE_RGB_TO_XYZ; stages[n++] = STAGE_XYZ_TO_LAB; stages[n++] = STAGE_RECT_TO_POLAR; break;
+    case ColorSpace::OKLab: stages[n++] = STAGE_RGB_TO_OKLAB; break;
+    case ColorSpace::OKLCh: stages[n++] = STAGE_RGB_TO_OKLAB; stages[n++] = STAGE_RECT_TO_POLAR; break;
+    case ColorSpace::HSL: stages[n++] = STAGE_SRGB_ENCODE; stages[n++] = STAGE_SRGB_TO_HSL; break;
+    case ColorSpace::HSV: stages[n++] = STAGE_SRGB_ENCODE; stages[n++] = STAGE_SRGB_TO_HSV; break;
+    }
+    return n;
+}
+
+static glm::vec3 applyStage(ConversionStage stage, glm::vec3 c)
+{
+    switch (stage)
+    {
+    case STAGE_SRGB_DECODE: return glm::vec3((float)decodeSrgb(c.x), (float)decodeSrgb(c.y), (float)decodeSrgb(c.z));
+    case STAGE_SRGB_ENCODE: return glm::vec3((float)encodeSrgb(c.x), (float)encodeSrgb(c.y), (float)encodeSrgb(c.z));
+    case STAGE_XYZ_TO_RGB: return xyzToLinearRgb(c);
+    case STAGE_RGB_TO_XYZ: return linearRgbToXyz(c);
+    case STAGE_LAB_TO_XYZ: return labToXyz(c);
+    case STAGE_XYZ_TO_LAB: return xyzToLab(c);
+    case STAGE_OKLAB_TO_RGB: return oklabToLinearRgb(c);
+    case STAGE_RGB_TO_OKLAB: return linearRgbToOklab(c);
+    case STAGE_POLAR_TO_RECT: return lchToLab(c);
+    case STAGE_RECT_TO_POLAR: return labToLch(c);
+    case STAGE_HSL_TO_SRGB: return hslToSrgb(c);
+    case STAGE_SRGB_TO_HSL: return srgbToHsl(c);
+    case STAGE_HSV_TO_SRGB: return HSVtoRGB(c.x, c.y, c.z);
+    case STAGE_SRGB_TO_HSV: return srgbToHsv(c);
+    }
+    return c;
+}
+
+glm::vec3 convertColor(ColorSpace from, ColorSpace to, glm::vec3 c)
+{
+    ConversionStage stages[6];
+    int stageCount = planConversion(from, to, stages);
+    for (int s = 0; s < stageCount; ++s)
+        c = applyStage(stages[s], c);
+    return c;
+}
+
+// =======================================================
+// SSE2 kernels (four colors per call, one register per channel)
+// =======================================================
+
+#ifdef RGBPICK_SSE2
+
+struct Matrix4
+{
+    __m128 m[9];
+    explicit Matrix4(const double src[9])
+    {
+        for (int i = 0; i < 9; ++i) m[i] = _mm_set1_ps((float)src[i]);
+    }
+};
+
+static inline void mul_ps(const Matrix4& m, __m128& x, __m128& y, __m128& z)
+{
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.m[0], x), _mm_mul_ps(m.m[1], y)), _mm_mul_ps(m.m[2], z));
+    __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.m[3], x), _mm_mul_ps(m.m[4], y)), _mm_mul_ps(m.m[5], z));
+    __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.m[6], x), _mm_mul_ps(m.m[7], y)), _mm_mul_ps(m.m[8], z));
+    x = a; y = b; z = c;
+}
+
+static inline __m128 decodeSrgb_ps(__m128 c)
+{
+    __m128 lin = _mm_mul_ps(c, _mm_set1_ps(1.0f / 12.92f));
+    __m128 curve = pow_ps(_mm_mul_ps(_mm_add_ps(c, _mm_set1_ps(0.055f)), _mm_set1_ps(1.0f / 1.055f)), 2.4f);
+    return select_ps(_mm_cmple_ps(c, _mm_set1_ps(0.04045f)), lin, curve);
+}
+
+static inline __m128 encodeSrgb_ps(__m128 c)
+{
+    __m128 lin = _mm_mul_ps(c, _mm_set1_ps(12.92f));
+    __m128 curve = _mm_sub_ps(_mm_mul_ps(pow_ps(c, 1.0f / 2.4f), _mm_set1_ps(1.055f)), _mm_set1_ps(0.055f));
+    return select_ps(_mm_cmple_ps(c, _mm_set1_ps(0.0031308f)), lin, curve);
+}
+
+static inline __m128 labF_ps(__m128 t)
+{
+    const float d = (float)LAB_DELTA;
+    __m128 lin = _mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(1.0f / (3.0f * d * d))), _mm_set1_ps(4.0f / 29.0f));
+    return select_ps(_mm_cmpgt_ps(t, _mm_set1_ps(d * d * d)), cbrt_ps(t), lin);
+}
+
+static inline __m128 labFInverse_ps(__m128 t)
+{
+    const float d = (float)LAB_DELTA;
+    __m128 lin = _mm_mul_ps(_mm_set1_ps(3.0f * d * d), _mm_sub_ps(t, _mm_set1_ps(4.0f / 29.0f)));
+    return select_ps(_mm_cmpgt_ps(t, _mm_set1_ps(d)), _mm_mul_ps(_mm_mul_ps(t, t), t), lin);
+}
+
+// XYZ in x/y/z -> L/a/b in place
+static inline void xyzToLab_ps(__m128& x, __m128& y, __m128& z)
+{
+    __m128 fx = labF_ps(_mm_mul_ps(x, _mm_set1_ps((float)(1.0 / WHITE[0]))));
+    __m128 fy = labF_ps(y);
+    __m128 fz = labF_ps(_mm_mul_ps(z, _mm_set1_ps((float)(1.0 / WHITE[2]))));
+    x = _mm_sub_ps(_mm_mul_ps(fy, _mm_set1_ps(116.0f)), _mm_set1_ps(16.0f));
+    y = _mm_mul_ps(_mm_sub_ps(fx, fy), _mm_set1_ps(500.0f));
+    z = _mm_mul_ps(_mm_sub_ps(fy, fz), _mm_set1_ps(200.0f));
+}
+
+static inline void labToXyz_ps(__m128& l, __m128& a, __m128& b)
+{
+    __m128 fy = _mm_mul_ps(_mm_add_ps(l, _mm_set1_ps(16.0f)), _mm_set1_ps(1.0f / 116.0f));
+    __m128 fx = _mm_add_ps(fy, _mm_mul_ps(a, _mm_set1_ps(1.0f / 500.0f)));
+    __m128 fz = _mm_sub_ps(fy, _mm_mul_ps(b, _mm_set1_ps(1.0f / 200.0f)));
+    l = _mm_mul_ps(labFInverse_ps(fx), _mm_set1_ps((float)WHITE[0]));
+    a = labFInverse_ps(fy);
+    b = _mm_mul_ps(labFInverse_ps(fz), _mm_set1_ps((float)WHITE[2]));
+}
+
+// (a, b) -> (C, h in degrees) in place
+static inline void toPolar_ps(__m128& a, __m128& b)
+{
+    __m128 c = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)));
+    __m128 h = _mm_mul_ps(atan2_ps(b, a), _mm_set1_ps((float)(180.0 / PI)));
+    h = _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, _mm_setzero_ps()), _mm_set1_ps(360.0f)));
+    a = c;
+    b = h;
+}
+
+static inline void fromPolar_ps(__m128& c, __m128& h)
+{
+    __m128 s, co;
+    sincos_ps(_mm_mul_ps(h, _mm_set1_ps((float)(PI / 180.0))), &s, &co);
+    __m128 a = _mm_mul_ps(c, co);
+    h = _mm_mul_ps(c, s);
+    c = a;
+}
+
+static inline void srgbToHsl_ps(__m128& r, __m128& g, __m128& b)
+{
+    __m128 mx = _mm_max_ps(r, _mm_max_ps(g, b));
+    __m128 mn = _mm_min_ps(r, _mm_min_ps(g, b));
+    __m128 d = _mm_sub_ps(mx, mn);
+    __m128 l = _mm_mul_ps(_mm_add_ps(mx, mn), _mm_set1_ps(0.5f));
+    __m128 gray = _mm_cmple_ps(d, _mm_setzero_ps());
+    __m128 safeD = select_ps(gray, _mm_set1_ps(1.0f), d);
+
+    __m128 denom = _mm_sub_ps(_mm_set1_ps(1.0f), abs_ps(_mm_sub_ps(_mm_add_ps(l, l), _mm_set1_ps(1.0f))));
+    __m128 s = _mm_andnot_ps(gray, _mm_div_ps(d, _mm_max_ps(denom, _mm_set1_ps(1e-30f))));
+
+    // same priority as the scalar version: red, then green, then blue holds the max
+    __m128 hr = _mm_div_ps(_mm_sub_ps(g, b), safeD);
+    __m128 hg = _mm_add_ps(_mm_div_ps(_mm_sub_ps(b, r), safeD), _mm_set1_ps(2.0f));
+    __m128 hb = _mm_add_ps(_mm_div_ps(_mm_sub_ps(r, g), safeD), _mm_set1_ps(4.0f));
+    __m128 h = select_ps(_mm_cmpeq_ps(mx, r), hr, select_ps(_mm_cmpeq_ps(mx, g), hg, hb));
+    h = _mm_mul_ps(h, _mm_set1_ps(60.0f));
+    h = _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, _mm_setzero_ps()), _mm_set1_ps(360.0f)));
+
+    r = _mm_andnot_ps(gray, h);
+    g = s;
+    b = l;
+}
+
+static inline __m128 hslChannel_ps(float n, __m128 h30, __m128 a, __m128 l)
+{
+    __m128 k = _mm_add_ps(_mm_set1_ps(n), h30);
+    k = _mm_sub_ps(k, _mm_mul_ps(floor_ps(_mm_mul_ps(k, _mm_set1_ps(1.0f / 12.0f))), _mm_set1_ps(12.0f)));
+    __m128 t = _mm_min_ps(_mm_sub_ps(k, _mm_set1_ps(3.0f)), _mm_sub_ps(_mm_set1_ps(9.0f), k));
+    t = _mm_max_ps(_mm_set1_ps(-1.0f), _mm_min_ps(t, _mm_set1_ps(1.0f)));
+    return _mm_sub_ps(l, _mm_mul_ps(a, t));
+}
+
+static inline void hslToSrgb_ps(__m128& h, __m128& s, __m128& l)
+{
+    __m128 h30 = _mm_mul_ps(h, _mm_set1_ps(1.0f / 30.0f));
+    __m128 a = _mm_mul_ps(s, _mm_min_ps(l, _mm_sub_ps(_mm_set1_ps(1.0f), l)));
+    __m128 r = hslChannel_ps(0.0f, h30, a, l);
+    __m128 g = hslChannel_ps(8.0f, h30, a, l);
+    __m128 b = hslChannel_ps(4.0f, h30, a, l);
+    h = r; s = g; l = b;
+}
+
+static inline void srgbToHsv_ps(__m128& r, __m128& g, __m128& b)
+{
+    __m128 mx = _mm_max_ps(r, _mm_max_ps(g, b));
+    __m128 d = _mm_sub_ps(mx, _mm_min_ps(r, _mm_min_ps(g, b)));
+    __m128 gray = _mm_cmple_ps(d, _mm_setzero_ps());
+    __m128 safeD = select_ps(gray, _mm_set1_ps(1.0f), d);
+    __m128 s = _mm_andnot_ps(gray, _mm_div_ps(d, _mm_max_ps(mx, _mm_set1_ps(1e-30f))));
+
+    __m128 hr = _mm_div_ps(_mm_sub_ps(g, b), safeD);
+    __m128 hg = _mm_add_ps(_mm_div_ps(_mm_sub_ps(b, r), safeD), _mm_set1_ps(2.0f));
+    __m128 hb = _mm_add_ps(_mm_div_ps(_mm_sub_ps(r, g), safeD), _mm_set1_ps(4.0f));
+    __m128 h = select_ps(_mm_cmpeq_ps(mx, r), hr, select_ps(_mm_cmpeq_ps(mx, g), hg, hb));
+    h = _mm_mul_ps(h, _mm_set1_ps(60.0f));
+    h = _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, _mm_setzero_ps()), _mm_set1_ps(360.0f)));
+
+    r = _mm_andnot_ps(gray, h);
+    g = s;
+    b = mx;
+}
+
+// branch-free form: channel n is v - v * s * clamp(min(k, 4 - k), 0, 1), k = (n + h / 60) mod 6
+static inline __m128 hsvChannel_ps(float n, __m128 h60, __m128 vs, __m128 v)
+{
+    __m128 k = _mm_add_ps(_mm_set1_ps(n), h60);
+    k = _mm_sub_ps(k, _mm_mul_ps(floor_ps(_mm_mul_ps(k, _mm_set1_ps(1.0f / 6.0f))), _mm_set1_ps(6.0f)));
+    __m128 t = _mm_min_ps(k, _mm_sub_ps(_mm_set1_ps(4.0f), k));
+    t = _mm_max_ps(_mm_setzero_ps(), _mm_min_ps(t, _mm_set1_ps(1.0f)));
+    return _mm_sub_ps(v, _mm_mul_ps(vs, t));
+}
+
+static inline void hsvToSrgb_ps(__m128& h, __m128& s, __m128& v)
+{
+    __m128 h60 = _mm_mul_ps(h, _mm_set1_ps(1.0f / 60.0f));
+    __m128 vs = _mm_mul_ps(v, s);
+    __m128 r = hsvChannel_ps(5.0f, h60, vs, v);
+    __m128 g = hsvChannel_ps(3.0f, h60, vs, v);
+    __m128 b = hsvChannel_ps(1.0f, h60, vs, v);
+    h = r; s = g; v = b;
+}
+
+#endif
+
+// =======================================================
+// Batch conversions
+// =======================================================
+
+// runs one stage in place over count colors
+static void runStage(ConversionStage stage, float* x, float* y, float* z, size_t count)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    static const Matrix4 rgbToXyz(RGB_TO_XYZ), xyzToRgb(XYZ_TO_RGB);
+    static const Matrix4 rgbToLms(RGB_TO_LMS), lmsToOklab(LMS_TO_OKLAB), oklabToLms(OKLAB_TO_LMS), lmsToRgb(LMS_TO_RGB);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(x + i);
+        __m128 b = _mm_loadu_ps(y + i);
+        __m128 c = _mm_loadu_ps(z + i);
+        switch (stage)
+        {
+        case STAGE_SRGB_DECODE: a = decodeSrgb_ps(a); b = decodeSrgb_ps(b); c = decodeSrgb_ps(c); break;
+        case STAGE_SRGB_ENCODE: a = encodeSrgb_ps(a); b = encodeSrgb_ps(b); c = encodeSrgb_ps(c); break;
+        case STAGE_XYZ_TO_RGB: mul_ps(xyzToRgb, a, b, c); break;
+        case STAGE_RGB_TO_XYZ: mul_ps(rgbToXyz, a, b, c); break;
+        case STAGE_LAB_TO_XYZ: labToXyz_ps(a, b, c); break;
+        case STAGE_XYZ_TO_LAB: xyzToLab_ps(a, b, c); break;
+        case STAGE_OKLAB_TO_RGB:
+            mul_ps(oklabToLms, a, b, c);
+            a = _mm_mul_ps(_mm_mul_ps(a, a), a);
+            b = _mm_mul_ps(_mm_mul_ps(b, b), b);
+            c = _mm_mul_ps(_mm_mul_ps(c, c), c);
+            mul_ps(lmsToRgb, a, b, c);
+            break;
+        case STAGE_RGB_TO_OKLAB:
+            mul_ps(rgbToLms, a, b, c);
+            a = cbrt_ps(a); b = cbrt_ps(b); c = cbrt_ps(c);
+            mul_ps(lmsToOklab, a, b, c);
+            break;
+        case STAGE_POLAR_TO_RECT: fromPolar_ps(b, c); break;
+        case STAGE_RECT_TO_POLAR: toPolar_ps(b, c); break;
+        case STAGE_HSL_TO_SRGB: hslToSrgb_ps(a, b, c); break;
+        case STAGE_SRGB_TO_HSL: srgbToHsl_ps(a, b, c); break;
+        case STAGE_HSV_TO_SRGB: hsvToSrgb_ps(a, b, c); break;
+        case STAGE_SRGB_TO_HSV: srgbToHsv_ps(a, b, c); break;
+        }
+        _mm_storeu_ps(x + i, a);
+        _mm_storeu_ps(y + i, b);
+        _mm_storeu_ps(z + i, c);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        glm::vec3 c = applyStage(stage, glm::vec3(x[i], y[i], z[i]));
+        x[i] = c.x;
+        y[i] = c.y;
+        z[i] = c.z;
+    }
+}
+
+void convertColorsBatch(ColorSpace from, ColorSpace to, const float* const in[3], float* const out[3], size_t n)
+{
+    ConversionStage stages[6];
+    int stageCount = planConversion(from, to, stages);
+
+    // the first stage could read straight from in, but copying the block into out first keeps
+    // every stage in place; the copy is cheap next to any stage
+    const size_t BLOCK = 1024;
+    for (size_t start = 0; start < n; start += BLOCK)
+    {
+        size_t count = std::min(BLOCK, n - start);
+        float* x = out[0] + start;
+        float* y = out[1] + start;
+        float* z = out[2] + start;
+        if (out[0] != in[0]) std::copy(in[0] + start, in[0] + start + count, x);
+        if (out[1] != in[1]) std::copy(in[1] + start, in[1] + start + count, y);
+        if (out[2] != in[2]) std::copy(in[2] + start, in[2] + start + count, z);
+        for (int s = 0; s < stageCount; ++s)
+            runStage(stages[s], x, y, z, count);
+    }
+}
+
+void convertColorsInterleaved(ColorSpace from, ColorSpace to, const float* in, float* out, size_t n)
+{
+    // deinterleave blocks that stay in L1, convert them planar, interleave back
+    const size_t BLOCK = 256;
+    float planes[3][BLOCK];
+    float* const p[3] = { planes[0], planes[1], planes[2] };
+    for (size_t start = 0; start < n; start += BLOCK)
+    {
+        size_t count = std::min(BLOCK, n - start);
+        const float* src = in + start * 3;
+        for (size_t i = 0; i < count; ++i)
+        {
+            planes[0][i] = src[i * 3 + 0];
+            planes[1][i] = src[i * 3 + 1];
+            planes[2][i] = src[i * 3 + 2];
+        }
+        convertColorsBatch(from, to, p, p, count);
+        float* dst = out + start * 3;
+        for (size_t i = 0; i < count; ++i)
+        {
+            dst[i * 3 + 0] = planes[0][i];
+            dst[i * 3 + 1] = planes[1][i];
+            dst[i * 3 + 2] = planes[2][i];
+        }
+    }
+}
+
+// =======================================================
+// Accuracy against published values
+// =======================================================
+
+struct ReferenceColor
+{
+    ColorSpace from, to;
+    float in[3], expected[3];
+    float tolerance;  // per channel, in the units of the target space
+};
+
+// sRGB -> XYZ / Lab / LCh: Lindbloom's calculator (sRGB, D65, no adaptation); OKLab: the XYZ
+// test pairs of Ottosson's OKLab post (3 decimals) and the sRGB primaries from CSS Color 4;
+// HSL: exact by construction
+static const ReferenceColor REFERENCE_COLORS[] = {
+    { ColorSpace::SRGB, ColorSpace::XYZ, { 1, 1, 1 }, { 0.950470f, 1.000000f, 1.088830f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::XYZ, { 1, 0, 0 }, { 0.412456f, 0.212673f, 0.019334f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::XYZ, { 0, 1, 0 }, { 0.357576f, 0.715152f, 0.119192f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::XYZ, { 0, 0, 1 }, { 0.180437f, 0.072175f, 0.950304f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::XYZ, { 0.5f, 0.5f, 0.5f }, { 0.203440f, 0.214041f, 0.233054f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::Lab, { 1, 1, 1 }, { 100.0f, 0.0f, 0.0f }, 0.01f },
+    { ColorSpace::SRGB, ColorSpace::Lab, { 1, 0, 0 }, { 53.2408f, 80.0925f, 67.2032f }, 0.01f },
+    { ColorSpace::SRGB, ColorSpace::Lab, { 0, 1, 0 }, { 87.7347f, -86.1827f, 83.1793f }, 0.01f },
+    { ColorSpace::SRGB, ColorSpace::Lab, { 0, 0, 1 }, { 32.2970f, 79.1875f, -107.8602f }, 0.01f },
+    { ColorSpace::SRGB, ColorSpace::Lab, { 0.5f, 0.5f, 0.5f }, { 53.3889f, 0.0f, 0.0f }, 0.01f },
+    { ColorSpace::SRGB, ColorSpace::LCh, { 1, 0, 0 }, { 53.2408f, 104.5518f, 39.9990f }, 0.01f },
+    { ColorSpace::XYZ, ColorSpace::OKLab, { 0.950f, 1.000f, 1.089f }, { 1.000f, 0.000f, 0.000f }, 2e-3f },
+    { ColorSpace::XYZ, ColorSpace::OKLab, { 1.000f, 0.000f, 0.000f }, { 0.450f, 1.236f, -0.019f }, 2e-3f },
+    { ColorSpace::XYZ, ColorSpace::OKLab, { 0.000f, 1.000f, 0.000f }, { 0.922f, -0.671f, 0.263f }, 2e-3f },
+    { ColorSpace::XYZ, ColorSpace::OKLab, { 0.000f, 0.000f, 1.000f }, { 0.153f, -1.415f, -0.449f }, 2e-3f },
+    { ColorSpace::SRGB, ColorSpace::OKLab, { 1, 0, 0 }, { 0.627955f, 0.224863f, 0.125846f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::OKLab, { 0, 1, 0 }, { 0.866440f, -0.233888f, 0.179498f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::OKLab, { 0, 0, 1 }, { 0.452014f, -0.032457f, -0.311528f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::HSL, { 1, 0.5f, 0 }, { 30.0f, 1.0f, 0.5f }, 1e-4f },
+    { ColorSpace::SRGB, ColorSpace::HSL, { 0.2f, 0.4f, 0.6f }, { 210.0f, 0.5f, 0.4f }, 1e-4f },
+};
+
+// each color runs through the scalar conversion and a full SIMD batch of copies
+static bool checkReferenceColors()
+{
+    bool ok = true;
+    float maxError = 0.0f;
+    for (const ReferenceColor& r : REFERENCE_COLORS)
+    {
+        float planes[3][4];
+        for (int k = 0; k < 3; ++k)
+            std::fill(planes[k], planes[k] + 4, r.in[k]);
+        float* const p[3] = { planes[0], planes[1], planes[2] };
+        convertColorsBatch(r.from, r.to, p, p, 4);
+        glm::vec3 scalar = convertColor(r.from, r.to, glm::vec3(r.in[0], r.in[1], r.in[2]));
+        float error = 0.0f;
+        for (int k = 0; k < 3; ++k)
+            error = std::max({ error, std::fabs(scalar[k] - r.expected[k]), std::fabs(planes[k][0] - r.expected[k]) });
+        maxError = std::max(maxError, error / r.tolerance);
+        if (error > r.tolerance)
+        {
+            char line[320];
+            snprintf(line, sizeof(line), "ERROR::COLOR_SPACES::REFERENCE %s -> %s of (%g, %g, %g): got (%g, %g, %g), batch (%g, %g, %g), expected (%g, %g, %g)",
+                colorSpaceName(r.from), colorSpaceName(r.to), r.in[0], r.in[1], r.in[2], scalar.x, scalar.y, scalar.z,
+                planes[0][0], planes[1][0], planes[2][0], r.expected[0], r.expected[1], r.expected[2]);
+            std::cout << line << std::endl;
+            ok = false;
+        }
+    }
+    char line[128];
+    snprintf(line, sizeof(line), "reference values (%zu colors): worst error %.2f of tolerance",
+        sizeof(REFERENCE_COLORS) / sizeof(REFERENCE_COLORS[0]), maxError);
+    std::cout << line << std::endl;
+    return ok;
+}
+
+// sRGB -> space -> sRGB over a 33^3 grid of the sRGB cube, scalar and batch; tolerance is the
+// largest sRGB channel error accepted
+static bool checkRoundTrip(ColorSpace space, float tolerance)
+{
+    const int STEPS = 33;
+    const size_t n = STEPS * STEPS * STEPS;
+    std::vector<float> src(n * 3), dst(n * 3);
+    for (size_t i = 0; i < n; ++i)
+    {
+        src[i] = (i % STEPS) / (STEPS - 1.0f);
+        src[n + i] = (i / STEPS % STEPS) / (STEPS - 1.0f);
+        src[2 * n + i] = (i / (STEPS * STEPS)) / (STEPS - 1.0f);
+    }
+    const float* in[3] = { src.data(), src.data() + n, src.data() + 2 * n };
+    float* out[3] = { dst.data(), dst.data() + n, dst.data() + 2 * n };
+    convertColorsBatch(ColorSpace::SRGB, space, in, out, n);
+    convertColorsBatch(space, ColorSpace::SRGB, out, out, n);
+    float scalarError = 0.0f, batchError = 0.0f;
+    for (size_t i = 0; i < n; ++i)
+    {
+        glm::vec3 c(in[0][i], in[1][i], in[2][i]);
+        glm::vec3 back = convertColor(space, ColorSpace::SRGB, convertColor(ColorSpace::SRGB, space, c));
+        for (int k = 0; k < 3; ++k)
+        {
+            scalarError = std::max(scalarError, std::fabs(back[k] - c[k]));
+            batchError = std::max(batchError, std::fabs(out[k][i] - c[k]));
+        }
+    }
+    bool ok = scalarError <= tolerance && batchError <= tolerance;
+    char line[160];
+    snprintf(line, sizeof(line), "%ssRGB -> %s -> sRGB round trip (33^3 grid): max error scalar %.2e, batch %.2e (bound %.0e)",
+        ok ? "" : "ERROR::COLOR_SPACES::ROUND_TRIP ", colorSpaceName(space), scalarError, batchError, tolerance);
+    std::cout << line << std::endl;
+    return ok;
+}
+
+bool checkColorSpaces()
+{
+    bool ok = checkReferenceColors();
+    ok = checkRoundTrip(ColorSpace::HSL, 1e-5f) && ok;
+    // the cube root and the polar step in float lose more than HSL does
+    ok = checkRoundTrip(ColorSpace::LCh, 5e-5f) && ok;
+    return ok;
+}
+
+// =======================================================
+// Throughput report
+// =======================================================
+
+// keeps the scalar loop from being optimized away
+static volatile float benchmarkSink;
+
+bool benchmarkColorSpaces()
+{
+    bool ok = checkColorSpaces();
+    typedef std::chrono::steady_clock Clock;
+    const size_t n = 3840 * 2160;
+    const ColorSpace spaces[] = { ColorSpace::LinearRGB, ColorSpace::XYZ, ColorSpace::Lab, ColorSpace::LCh,
+                                  ColorSpace::OKLab, ColorSpace::OKLCh, ColorSpace::HSL, ColorSpace::HSV };
+
+    // a deterministic spread of in-gamut sRGB colors
+    std::vector<float> src(n * 3), dst(n * 3);
+    unsigned int seed = 12345;
+    for (float& v : src)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        v = (seed >> 8) * (1.0f / 16777216.0f);
+    }
+    const float* in[3] = { src.data(), src.data() + n, src.data() + 2 * n };
+    float* out[3] = { dst.data(), dst.data() + n, dst.data() + 2 * n };
+    float* back[3] = { src.data(), src.data() + n, src.data() + 2 * n };
+
+    auto mpxPerSecond = [&](Clock::time_point start, size_t pixels) {
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return pixels / seconds * 1e-6;
+    };
+
+    std::cout << "color space throughput, 3840x2160 planar float, Mpx/s" << std::endl;
+    std::cout << "  space         sRGB->X (batch)  X->sRGB (batch)  sRGB->X (scalar)" << std::endl;
+    for (ColorSpace space : spaces)
+    {
+        Clock::time_point t0 = Clock::now();
+        convertColorsBatch(ColorSpace::SRGB, space, in, out, n);
+        double forward = mpxPerSecond(t0, n);
+
+        t0 = Clock::now();
+        convertColorsBatch(space, ColorSpace::SRGB, out, back, n);
+        double inverse = mpxPerSecond(t0, n);
+
+        // the scalar reference only runs over a slice of the frame
+        const size_t scalarCount = n / 16;
+        t0 = Clock::now();
+        float sink = 0.0f;
+        for (size_t i = 0; i < scalarCount; ++i)
+            sink += convertColor(ColorSpace::SRGB, space, glm::vec3(in[0][i], in[1][i], in[2][i])).x;
+        double scalar = mpxPerSecond(t0, scalarCount);
+
+        char line[128];
+        benchmarkSink = sink;
+        snprintf(line, sizeof(line), "  %-12s %16.1f %16.1f %17.1f", colorSpaceName(space), forward, inverse, scalar);
+        std::cout << line << std::endl;
+    }
+    return ok;
+}
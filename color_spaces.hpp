@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// =======================================================
+// Color spaces and conversions
+// =======================================================
+//
+// Ranges used throughout:
+//   SRGB, LinearRGB  r, g, b in [0,1] for in-gamut colors (values outside are passed through)
+//   XYZ              CIE 1931, D65 white, Y = 1 for white
+//   Lab              CIELAB against D65, L in [0,100]
+//   LCh              CIELAB in polar form, L, C, h with h in degrees [0,360)
+//   OKLab            L in [0,1]
+//   OKLCh            OKLab in polar form, L, C, h with h in degrees [0,360)
+//   HSL              h in degrees [0,360), s and l in [0,1]
+//   HSV              h in degrees [0,360), s and v in [0,1] (the HSV wheel's layout)
+enum class ColorSpace { SRGB, LinearRGB, XYZ, Lab, LCh, OKLab, OKLCh, HSL, HSV };
+
+const char* colorSpaceName(ColorSpace space);
+
+// scalar reference conversions (double precision internally)
+glm::vec3 linearRgbToXyz(glm::vec3 rgb);
+glm::vec3 xyzToLinearRgb(glm::vec3 xyz);
+glm::vec3 xyzToLab(glm::vec3 xyz);
+glm::vec3 labToXyz(glm::vec3 lab);
+glm::vec3 linearRgbToOklab(glm::vec3 rgb);
+glm::vec3 oklabToLinearRgb(glm::vec3 lab);
+// rectangular <-> polar for both Lab and OKLab
+glm::vec3 labToLch(glm::vec3 lab);
+glm::vec3 lchToLab(glm::vec3 lch);
+// on sRGB-encoded values
+glm::vec3 srgbToHsl(glm::vec3 rgb);
+glm::vec3 hslToSrgb(glm::vec3 hsl);
+glm::vec3 srgbToHsv(glm::vec3 rgb);
+// H in degrees [0,360), S and V in [0,1]
+glm::vec3 HSVtoRGB(float H, float S, float V);
+
+// any space to any other; goes through linear RGB (no gamut clipping on the way)
+glm::vec3 convertColor(ColorSpace from, ColorSpace to, glm::vec3 c);
+
+// batch versions on planar (structure-of-arrays) buffers: in[k] / out[k] hold channel k of n
+// colors. out may alias in. SSE2 where available, results within about 1e-5 (relative to
+// each channel's range) of convertColor
+void convertColorsBatch(ColorSpace from, ColorSpace to, const float* const in[3], float* const out[3], size_t n);
+// same for interleaved buffers (3 floats per color); out may alias in
+void convertColorsInterleaved(ColorSpace from, ColorSpace to, const float* in, float* out, size_t n);
+
+// checks the scalar and batch conversions against published values (sRGB -> XYZ / Lab / LCh,
+// Ottosson's OKLab pairs, HSL) and the sRGB -> HSL / LCh -> sRGB round trips against a bound,
+// printing an ERROR line for each failure; false if any failed
+bool checkColorSpaces();
+// runs checkColorSpaces, then converts a 4K frame from sRGB to every space and back, printing
+// pixels/s for the batch and scalar versions (--bench-color-spaces); false if a check failed
+bool benchmarkColorSpaces();
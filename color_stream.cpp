@@ -0,0 +1,351 @@
+#include "color_stream.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =======================================================
+// Names
+// =======================================================
+
+bool parseColorSpace(const std::string& name, ColorSpace& space)
+{
+    static const struct { const char* name; ColorSpace space; } SPACES[] = {
+        { "srgb", ColorSpace::SRGB }, { "linear", ColorSpace::LinearRGB }, { "xyz", ColorSpace::XYZ },
+        { "lab", ColorSpace::Lab }, { "lch", ColorSpace::LCh }, { "oklab", ColorSpace::OKLab },
+        { "oklch", ColorSpace::OKLCh }, { "hsl", ColorSpace::HSL }, { "hsv", ColorSpace::HSV },
+    };
+    for (const auto& s : SPACES)
+        if (name == s.name)
+        {
+            space = s.space;
+            return true;
+        }
+    return false;
+}
+
+bool parseStreamFormat(const std::string& name, StreamFormat& format)
+{
+    if (name == "csv") format = StreamFormat::CSV;
+    else if (name == "hex") format = StreamFormat::Hex;
+    else if (name == "f32") format = StreamFormat::Float32;
+    else if (name == "rgb8") format = StreamFormat::RGB8;
+    else return false;
+    return true;
+}
+
+static bool isText(StreamFormat format)
+{
+    return format == StreamFormat::CSV || format == StreamFormat::Hex;
+}
+
+// =======================================================
+// Parsing and formatting one chunk
+// =======================================================
+
+namespace
+{
+// a piece of the stream on its way through the pipeline; the buffers keep their capacity
+// from one use to the next
+struct Chunk
+{
+    size_t seq = 0;
+    std::string in, out;
+    std::vector<float> values;  // interleaved
+    size_t lines = 0, bad = 0;
+    long firstBad = -1;         // line within the chunk
+};
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static const char* skipSeparators(const char* p, const char* end)
+{
+    while (p < end && (*p == ',' || *p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+// "#rrggbb" (the '#' is optional) followed only by separators
+static bool parseHex(const char* p, const char* end, float* rgb)
+{
+    if (p < end && *p == '#') ++p;
+    if (end - p < 6) return false;
+    for (int k = 0; k < 3; ++k)
+    {
+        int hi = hexDigit(p[2 * k]), lo = hexDigit(p[2 * k + 1]);
+        if (hi < 0 || lo < 0) return false;
+        rgb[k] = (hi * 16 + lo) / 255.0f;
+    }
+    return skipSeparators(p + 6, end) == end;
+}
+
+static bool parseNumbers(const char* p, const char* end, float* v)
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        p = skipSeparators(p, end);
+        std::from_chars_result r = std::from_chars(p, end, v[k]);
+        if (r.ec != std::errc()) return false;
+        p = r.ptr;
+    }
+    return skipSeparators(p, end) == end;
+}
+
+static void parseChunk(Chunk& c, StreamFormat format)
+{
+    c.values.clear();
+    c.lines = 0;
+    c.bad = 0;
+    c.firstBad = -1;
+    const char* p = c.in.data();
+    const char* end = p + c.in.size();
+    if (format == StreamFormat::Float32)
+    {
+        c.values.resize(c.in.size() / sizeof(float));
+        memcpy(c.values.data(), p, c.values.size() * sizeof(float));
+        return;
+    }
+    if (format == StreamFormat::RGB8)
+    {
+        c.values.resize(c.in.size());
+        for (size_t i = 0; i < c.in.size(); ++i)
+            c.values[i] = (unsigned char)p[i] * (1.0f / 255.0f);
+        return;
+    }
+    while (p < end)
+    {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        const char* lineEnd = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+        const char* q = skipSeparators(p, lineEnd);
+        if (q < lineEnd)
+        {
+            float rgb[3];
+            bool ok = (format == StreamFormat::Hex || *q == '#') ? parseHex(q, lineEnd, rgb) : parseNumbers(q, lineEnd, rgb);
+            if (ok)
+                c.values.insert(c.values.end(), rgb, rgb + 3);
+            else
+            {
+                if (c.firstBad < 0) c.firstBad = (long)c.lines;
+                ++c.bad;
+            }
+        }
+        ++c.lines;
+        p = eol + 1;
+    }
+}
+
+static void formatChunk(Chunk& c, StreamFormat format, int precision)
+{
+    size_t n = c.values.size() / 3;
+    const float* v = c.values.data();
+    if (format == StreamFormat::Float32)
+    {
+        c.out.assign((const char*)v, n * 3 * sizeof(float));
+        return;
+    }
+    if (format == StreamFormat::RGB8 || format == StreamFormat::Hex)
+    {
+        static const char DIGITS[] = "0123456789abcdef";
+        bool hex = format == StreamFormat::Hex;
+        c.out.resize(n * (hex ? 8 : 3));
+        char* o = &c.out[0];
+        for (size_t i = 0; i < n * 3; i += 3)
+        {
+            if (hex) *o++ = '#';
+            for (int k = 0; k < 3; ++k)
+            {
+                int b = (int)(std::min(std::max(v[i + k], 0.0f), 1.0f) * 255.0f + 0.5f);
+                if (hex)
+                {
+                    *o++ = DIGITS[b >> 4];
+                    *o++ = DIGITS[b & 15];
+                }
+                else
+                    *o++ = (char)b;
+            }
+            if (hex) *o++ = '\n';
+        }
+        return;
+    }
+    // at most sign, digits, point and a 4-character exponent per value, plus a separator
+    c.out.resize(n * 3 * (precision + 9));
+    char* o = &c.out[0];
+    for (size_t i = 0; i < n * 3; ++i)
+    {
+        o = std::to_chars(o, o + precision + 8, v[i], std::chars_format::general, precision).ptr;
+        *o++ = i % 3 == 2 ? '\n' : ',';
+    }
+    c.out.resize(o - c.out.data());
+}
+
+// =======================================================
+// Pipeline
+// =======================================================
+
+bool convertStream(FILE* in, FILE* out, const StreamOptions& options, StreamStats& stats)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    stats = StreamStats();
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    bool text = isText(options.input);
+    size_t record = options.input == StreamFormat::Float32 ? 3 * sizeof(float) : 3;
+    // text chunks are cut at a line end, binary ones at a whole color
+    size_t chunkBytes = std::max<size_t>(1, options.chunkColors) * (text ? 24 : record);
+
+    // every thread can hold a chunk, with one more waiting on each side
+    const size_t slots = threads + 2;
+    std::vector<Chunk> chunks(slots);
+    std::vector<Chunk*> freeChunks;
+    for (Chunk& c : chunks) freeChunks.push_back(&c);
+    std::deque<Chunk*> work;
+    std::vector<Chunk*> finished(slots, nullptr);  // by seq % slots; fewer than slots are in flight
+    std::mutex lock;
+    std::condition_variable changed;
+    bool readDone = false, failed = false;
+    size_t chunkCount = 0;
+
+    auto convert = [&]() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            changed.wait(guard, [&]() { return !work.empty() || readDone || failed; });
+            if (work.empty() || failed) return;
+            Chunk* c = work.front();
+            work.pop_front();
+            guard.unlock();
+            parseChunk(*c, options.input);
+            convertColorsInterleaved(options.from, options.to, c->values.data(), c->values.data(), c->values.size() / 3);
+            formatChunk(*c, options.output, options.precision);
+            guard.lock();
+            finished[c->seq % slots] = c;
+            changed.notify_all();
+        }
+    };
+
+    auto write = [&]() {
+        size_t next = 0, linesBefore = 0;
+        bool reported = false;
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            changed.wait(guard, [&]() { return finished[next % slots] || (readDone && next == chunkCount) || failed; });
+            if (failed || !finished[next % slots]) return;
+            Chunk* c = finished[next % slots];
+            finished[next % slots] = nullptr;
+            guard.unlock();
+            if (!c->out.empty() && fwrite(c->out.data(), 1, c->out.size(), out) != c->out.size())
+            {
+                std::cerr << "ERROR::CONVERT::WRITE_FAILED" << std::endl;
+                guard.lock();
+                failed = true;
+                changed.notify_all();
+                return;
+            }
+            if (c->firstBad >= 0 && !reported)
+            {
+                std::cerr << "ERROR::CONVERT::BAD_LINE " << linesBefore + c->firstBad + 1 << std::endl;
+                reported = true;
+            }
+            linesBefore += c->lines;
+            stats.colors += c->values.size() / 3;
+            stats.badLines += c->bad;
+            guard.lock();
+            freeChunks.push_back(c);
+            ++next;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back(convert);
+    std::thread writer(write);
+
+    // this thread reads; what follows the last cut is carried into the next chunk
+    std::string carry;
+    size_t seq = 0;
+    bool eof = false, readFailed = false;
+    while (!eof)
+    {
+        Chunk* c;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return !freeChunks.empty() || failed; });
+            if (failed) break;
+            c = freeChunks.back();
+            freeChunks.pop_back();
+        }
+        c->in.assign(carry);
+        carry.clear();
+        size_t cut = std::string::npos;
+        while (cut == std::string::npos && !eof)
+        {
+            size_t have = c->in.size();
+            c->in.resize(have + chunkBytes);
+            size_t got = fread(&c->in[have], 1, chunkBytes, in);
+            c->in.resize(have + got);
+            if (got < chunkBytes)
+            {
+                eof = true;
+                readFailed = ferror(in) != 0;
+            }
+            else if (text)
+            {
+                // a line longer than the chunk keeps reading into the same one
+                size_t lastLine = c->in.find_last_of('\n');
+                if (lastLine != std::string::npos) cut = lastLine + 1;
+            }
+            else
+                cut = c->in.size() - c->in.size() % record;
+        }
+        if (eof && !text && c->in.size() % record)
+        {
+            std::cerr << "ERROR::CONVERT::TRAILING_BYTES " << c->in.size() % record << std::endl;
+            c->in.resize(c->in.size() - c->in.size() % record);
+        }
+        if (cut != std::string::npos)
+        {
+            carry.assign(c->in, cut, std::string::npos);
+            c->in.resize(cut);
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if (c->in.empty())
+            freeChunks.push_back(c);
+        else
+        {
+            c->seq = seq++;
+            work.push_back(c);
+        }
+        changed.notify_all();
+    }
+    if (readFailed)
+        std::cerr << "ERROR::CONVERT::READ_FAILED" << std::endl;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        readDone = true;
+        chunkCount = seq;
+        failed = failed || readFailed;
+        changed.notify_all();
+    }
+    for (std::thread& w : workers) w.join();
+    writer.join();
+    fflush(out);
+
+    stats.chunks = seq;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return !failed;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "color_spaces.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// =======================================================
+// Streaming color conversion (rgbpick-convert)
+// =======================================================
+
+// CSV: one color per line, three numbers separated by commas and/or spaces ("#rrggbb" lines
+// are read too). Hex: "#rrggbb" per line, sRGB-style [0,1] values. Float32: three native
+// floats per color. RGB8: three bytes per color, [0,1] values scaled by 255
+enum class StreamFormat { CSV, Hex, Float32, RGB8 };
+
+struct StreamOptions
+{
+    ColorSpace from = ColorSpace::SRGB;
+    ColorSpace to = ColorSpace::SRGB;
+    StreamFormat input = StreamFormat::CSV;
+    StreamFormat output = StreamFormat::CSV;
+    size_t chunkColors = 1 << 16;  // colors per chunk (text chunks are sized to match)
+    unsigned threads = 0;          // converting threads; 0 = one per hardware thread
+    int precision = 6;             // significant digits in CSV output
+};
+
+struct StreamStats
+{
+    size_t colors = 0;
+    size_t badLines = 0;
+    size_t chunks = 0;
+    double seconds = 0.0;
+};
+
+// names as on the command line: srgb, linear, xyz, lab, lch, oklab, oklch, hsl, hsv
+bool parseColorSpace(const std::string& name, ColorSpace& space);
+// csv, hex, f32, rgb8
+bool parseStreamFormat(const std::string& name, StreamFormat& format);
+
+// Reads colors from in until EOF, converts them and writes them to out in the same order.
+// A pipeline of three stages overlaps I/O with work: the calling thread reads chunks, the
+// converting threads parse, convert (convertColorsInterleaved) and format them, and a writer
+// thread puts them out in sequence. A fixed set of chunk buffers circulates between the
+// stages, so memory stays bounded by the chunk size whatever the input size. Lines that don't
+// parse are skipped and counted. False on a read or write error
+bool convertStream(FILE* in, FILE* out, const StreamOptions& options, StreamStats& stats);
@@ -0,0 +1,150 @@
+#include "color_transfer.hpp"
+#include "simd_math.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// =======================================================
+// Reference transfer functions
+// =======================================================
+
+float srgbToLinear(float c)
+{
+    if (c <= 0.04045f) return c / 12.92f;
+    return std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float c)
+{
+    if (c <= 0.0031308f) return c * 12.92f;
+    return 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// =======================================================
+// 8-bit tables
+// =======================================================
+
+struct TransferTables
+{
+    float decode[256];
+    // linear value at which the encoded code switches from i-1 to i (threshold[0] unused)
+    float threshold[257];
+    // code for the lowest linear value of each 16-bit bucket
+    std::vector<uint8_t> bucketCode;
+
+    TransferTables() : bucketCode(65536)
+    {
+        for (int i = 0; i < 256; ++i)
+            decode[i] = (float)srgbToLinearExact(i / 255.0);
+
+        // the halfway point between two codes, mapped back to linear light and rounded up to
+        // the next float, so `c >= threshold` is exact for float inputs
+        threshold[0] = -1.0f;
+        for (int i = 1; i < 256; ++i)
+        {
+            double t = srgbToLinearExact((i - 0.5) / 255.0);
+            float f = (float)t;
+            threshold[i] = f < t ? std::nextafter(f, 2.0f) : f;
+        }
+        threshold[256] = 2.0f;
+
+        // a bucket is narrower than the distance between two thresholds, so it contains at most
+        // one of them; storing the code at its start leaves a single comparison at lookup
+        int code = 0;
+        for (int b = 0; b < 65536; ++b)
+        {
+            float start = b / 65536.0f;
+            while (start >= threshold[code + 1]) ++code;
+            bucketCode[b] = (uint8_t)code;
+        }
+    }
+
+    static double srgbToLinearExact(double c)
+    {
+        if (c <= 0.04045) return c / 12.92;
+        return std::pow((c + 0.055) / 1.055, 2.4);
+    }
+};
+
+static const TransferTables& tables()
+{
+    static TransferTables t;
+    return t;
+}
+
+float srgb8ToLinear(uint8_t c)
+{
+    return tables().decode[c];
+}
+
+static inline uint8_t encode8(const TransferTables& t, float c)
+{
+    // the negated compare also sends NaN to 0
+    if (!(c > 0.0f)) return 0;
+    if (c >= 1.0f) return 255;
+    int bucket = (int)(c * 65536.0f);
+    uint8_t code = t.bucketCode[bucket];
+    return code + (c >= t.threshold[code + 1] ? 1 : 0);
+}
+
+uint8_t linearToSrgb8(float c)
+{
+    return encode8(tables(), c);
+}
+
+void srgb8ToLinearBatch(const uint8_t* in, float* out, size_t n)
+{
+    const float* decode = tables().decode;
+    for (size_t i = 0; i < n; ++i)
+        out[i] = decode[in[i]];
+}
+
+void linearToSrgb8Batch(const float* in, uint8_t* out, size_t n)
+{
+    const TransferTables& t = tables();
+    for (size_t i = 0; i < n; ++i)
+        out[i] = encode8(t, in[i]);
+}
+
+// =======================================================
+// Float batches
+// =======================================================
+
+void srgbToLinearBatch(const float* in, float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 c = clamp01_ps(_mm_loadu_ps(in + i));
+        __m128 lin = _mm_mul_ps(c, _mm_set1_ps(1.0f / 12.92f));
+        __m128 curve = pow_ps(_mm_mul_ps(_mm_add_ps(c, _mm_set1_ps(0.055f)), _mm_set1_ps(1.0f / 1.055f)), 2.4f);
+        _mm_storeu_ps(out + i, select_ps(_mm_cmple_ps(c, _mm_set1_ps(0.04045f)), lin, curve));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float c = in[i] < 0.0f ? 0.0f : (in[i] > 1.0f ? 1.0f : in[i]);
+        out[i] = srgbToLinear(c);
+    }
+}
+
+void linearToSrgbBatch(const float* in, float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 c = clamp01_ps(_mm_loadu_ps(in + i));
+        __m128 lin = _mm_mul_ps(c, _mm_set1_ps(12.92f));
+        __m128 curve = _mm_sub_ps(_mm_mul_ps(pow_ps(c, 1.0f / 2.4f), _mm_set1_ps(1.055f)), _mm_set1_ps(0.055f));
+        _mm_storeu_ps(out + i, select_ps(_mm_cmple_ps(c, _mm_set1_ps(0.0031308f)), lin, curve));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float c = in[i] < 0.0f ? 0.0f : (in[i] > 1.0f ? 1.0f : in[i]);
+        out[i] = linearToSrgb(c);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =======================================================
+// sRGB <-> linear-light transfer functions (IEC 61966-2-1)
+// =======================================================
+
+// reference versions (std::pow), inputs/outputs in [0,1]
+float srgbToLinear(float c);
+float linearToSrgb(float c);
+
+// 8-bit versions: decoding is a 256-entry table; encoding is exact (correctly rounded for
+// every float input) using a 64K-entry table indexed by the top 16 bits of the clamped
+// linear value plus one threshold comparison
+float srgb8ToLinear(uint8_t c);
+uint8_t linearToSrgb8(float c);
+
+// batch versions for image buffers; out may alias in for the float -> float variants.
+// The float variants use SSE2 polynomial log/exp (Cephes-style) where available, max
+// error against the reference 2e-7 over [0,1]; inputs are clamped to [0,1]
+void srgb8ToLinearBatch(const uint8_t* in, float* out, size_t n);
+void linearToSrgb8Batch(const float* in, uint8_t* out, size_t n);
+void srgbToLinearBatch(const float* in, float* out, size_t n);
+void linearToSrgbBatch(const float* in, float* out, size_t n);
@@ -0,0 +1,380 @@
+#include "delta_e.hpp"
+#include "simd_math.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+static const double DEG = PI / 180.0;
+
+// =======================================================
+// Scalar reference versions
+// =======================================================
+
+float deltaE76(glm::vec3 lab1, glm::vec3 lab2)
+{
+    double dL = (double)lab1.x - lab2.x, da = (double)lab1.y - lab2.y, db = (double)lab1.z - lab2.z;
+    return (float)std::sqrt(dL * dL + da * da + db * db);
+}
+
+float deltaE94(glm::vec3 lab1, glm::vec3 lab2)
+{
+    double c1 = std::sqrt((double)lab1.y * lab1.y + (double)lab1.z * lab1.z);
+    double c2 = std::sqrt((double)lab2.y * lab2.y + (double)lab2.z * lab2.z);
+    double dL = (double)lab1.x - lab2.x;
+    double dC = c1 - c2;
+    double da = (double)lab1.y - lab2.y, db = (double)lab1.z - lab2.z;
+    // dH^2 from the rest of the Euclidean distance; rounding can push it slightly negative
+    double dH2 = std::max(0.0, da * da + db * db - dC * dC);
+    double sC = 1.0 + 0.045 * c1;
+    double sH = 1.0 + 0.015 * c1;
+    return (float)std::sqrt(dL * dL + (dC / sC) * (dC / sC) + dH2 / (sH * sH));
+}
+
+// hue angle in degrees [0, 360), 0 for achromatic colors
+static double hueDegrees(double b, double a)
+{
+    if (a == 0.0 && b == 0.0) return 0.0;
+    double h = std::atan2(b, a) / DEG;
+    return h < 0.0 ? h + 360.0 : h;
+}
+
+float deltaE2000(glm::vec3 lab1, glm::vec3 lab2)
+{
+    const double pow25_7 = 6103515625.0;  // 25^7
+    double L1 = lab1.x, a1 = lab1.y, b1 = lab1.z;
+    double L2 = lab2.x, a2 = lab2.y, b2 = lab2.z;
+
+    double cBar = 0.5 * (std::sqrt(a1 * a1 + b1 * b1) + std::sqrt(a2 * a2 + b2 * b2));
+    double cBar7 = std::pow(cBar, 7.0);
+    double g = 0.5 * (1.0 - std::sqrt(cBar7 / (cBar7 + pow25_7)));
+    double a1p = (1.0 + g) * a1, a2p = (1.0 + g) * a2;
+    double c1p = std::sqrt(a1p * a1p + b1 * b1), c2p = std::sqrt(a2p * a2p + b2 * b2);
+    double h1p = hueDegrees(b1, a1p), h2p = hueDegrees(b2, a2p);
+
+    double dLp = L2 - L1;
+    double dCp = c2p - c1p;
+    double dhp = 0.0;
+    if (c1p * c2p != 0.0)
+    {
+        dhp = h2p - h1p;
+        if (dhp > 180.0) dhp -= 360.0;
+        else if (dhp < -180.0) dhp += 360.0;
+    }
+    double dHp = 2.0 * std::sqrt(c1p * c2p) * std::sin(dhp * 0.5 * DEG);
+
+    double lBarp = 0.5 * (L1 + L2);
+    double cBarp = 0.5 * (c1p + c2p);
+    double hBarp = h1p + h2p;
+    if (c1p * c2p != 0.0)
+    {
+        if (std::fabs(h1p - h2p) <= 180.0) hBarp *= 0.5;
+        else if (hBarp < 360.0) hBarp = (hBarp + 360.0) * 0.5;
+        else hBarp = (hBarp - 360.0) * 0.5;
+    }
+
+    double t = 1.0 - 0.17 * std::cos((hBarp - 30.0) * DEG) + 0.24 * std::cos(2.0 * hBarp * DEG)
+        + 0.32 * std::cos((3.0 * hBarp + 6.0) * DEG) - 0.20 * std::cos((4.0 * hBarp - 63.0) * DEG);
+    double dTheta = 30.0 * std::exp(-((hBarp - 275.0) / 25.0) * ((hBarp - 275.0) / 25.0));
+    double cBarp7 = std::pow(cBarp, 7.0);
+    double rC = 2.0 * std::sqrt(cBarp7 / (cBarp7 + pow25_7));
+    double l50 = (lBarp - 50.0) * (lBarp - 50.0);
+    double sL = 1.0 + 0.015 * l50 / std::sqrt(20.0 + l50);
+    double sC = 1.0 + 0.045 * cBarp;
+    double sH = 1.0 + 0.015 * cBarp * t;
+    double rT = -std::sin(2.0 * dTheta * DEG) * rC;
+
+    double l = dLp / sL, c = dCp / sC, h = dHp / sH;
+    return (float)std::sqrt(l * l + c * c + h * h + rT * c * h);
+}
+
+float deltaE(DeltaE formula, glm::vec3 lab1, glm::vec3 lab2)
+{
+    switch (formula)
+    {
+    case DeltaE::CIE76: return deltaE76(lab1, lab2);
+    case DeltaE::CIE94: return deltaE94(lab1, lab2);
+    case DeltaE::CIEDE2000: return deltaE2000(lab1, lab2);
+    }
+    return 0.0f;
+}
+
+// =======================================================
+// SSE2 kernels (four pairs per call)
+// =======================================================
+
+#ifdef RGBPICK_SSE2
+
+static inline __m128 sq_ps(__m128 x)
+{
+    return _mm_mul_ps(x, x);
+}
+
+static inline __m128 de76_ps(__m128 L1, __m128 a1, __m128 b1, __m128 L2, __m128 a2, __m128 b2)
+{
+    __m128 d = _mm_add_ps(_mm_add_ps(sq_ps(_mm_sub_ps(L1, L2)), sq_ps(_mm_sub_ps(a1, a2))), sq_ps(_mm_sub_ps(b1, b2)));
+    return _mm_sqrt_ps(d);
+}
+
+static inline __m128 de94_ps(__m128 L1, __m128 a1, __m128 b1, __m128 L2, __m128 a2, __m128 b2)
+{
+    __m128 c1 = _mm_sqrt_ps(_mm_add_ps(sq_ps(a1), sq_ps(b1)));
+    __m128 c2 = _mm_sqrt_ps(_mm_add_ps(sq_ps(a2), sq_ps(b2)));
+    __m128 dL2 = sq_ps(_mm_sub_ps(L1, L2));
+    __m128 dC = _mm_sub_ps(c1, c2);
+    __m128 dH2 = _mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_add_ps(sq_ps(_mm_sub_ps(a1, a2)), sq_ps(_mm_sub_ps(b1, b2))), sq_ps(dC)));
+    __m128 sC = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.045f), c1));
+    __m128 sH = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.015f), c1));
+    return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(dL2, sq_ps(_mm_div_ps(dC, sC))), _mm_div_ps(dH2, sq_ps(sH))));
+}
+
+// x^7 / (x^7 + 25^7), square-rooted
+static inline __m128 chromaWeight_ps(__m128 c)
+{
+    __m128 c2 = sq_ps(c);
+    __m128 c7 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(c2, c2), c2), c);
+    return _mm_sqrt_ps(_mm_div_ps(c7, _mm_add_ps(c7, _mm_set1_ps(6103515625.0f))));
+}
+
+static inline __m128 hueDegrees_ps(__m128 b, __m128 a)
+{
+    __m128 h = _mm_mul_ps(atan2_ps(b, a), _mm_set1_ps((float)(1.0 / DEG)));
+    return _mm_add_ps(h, _mm_and_ps(_mm_cmplt_ps(h, _mm_setzero_ps()), _mm_set1_ps(360.0f)));
+}
+
+static inline __m128 de2000_ps(__m128 L1, __m128 a1, __m128 b1, __m128 L2, __m128 a2, __m128 b2)
+{
+    const __m128 one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+    const __m128 d180 = _mm_set1_ps(180.0f), d360 = _mm_set1_ps(360.0f);
+
+    __m128 cBar = _mm_mul_ps(half, _mm_add_ps(_mm_sqrt_ps(_mm_add_ps(sq_ps(a1), sq_ps(b1))), _mm_sqrt_ps(_mm_add_ps(sq_ps(a2), sq_ps(b2)))));
+    __m128 g1 = _mm_add_ps(one, _mm_mul_ps(half, _mm_sub_ps(one, chromaWeight_ps(cBar))));
+    __m128 a1p = _mm_mul_ps(g1, a1), a2p = _mm_mul_ps(g1, a2);
+    __m128 c1p = _mm_sqrt_ps(_mm_add_ps(sq_ps(a1p), sq_ps(b1)));
+    __m128 c2p = _mm_sqrt_ps(_mm_add_ps(sq_ps(a2p), sq_ps(b2)));
+    __m128 h1p = hueDegrees_ps(b1, a1p), h2p = hueDegrees_ps(b2, a2p);
+    __m128 chromatic = _mm_cmpneq_ps(_mm_mul_ps(c1p, c2p), zero);
+
+    __m128 dLp = _mm_sub_ps(L2, L1);
+    __m128 dCp = _mm_sub_ps(c2p, c1p);
+    // hue difference wrapped to [-180, 180], 0 when either color is achromatic
+    __m128 dhp = _mm_sub_ps(h2p, h1p);
+    dhp = _mm_sub_ps(dhp, _mm_and_ps(_mm_cmpgt_ps(dhp, d180), d360));
+    dhp = _mm_add_ps(dhp, _mm_and_ps(_mm_cmplt_ps(dhp, _mm_set1_ps(-180.0f)), d360));
+    dhp = _mm_and_ps(chromatic, dhp);
+    __m128 sinHalf, unused;
+    sincos_ps(_mm_mul_ps(dhp, _mm_set1_ps((float)(0.5 * DEG))), &sinHalf, &unused);
+    __m128 dHp = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), _mm_sqrt_ps(_mm_mul_ps(c1p, c2p))), sinHalf);
+
+    __m128 lBarp = _mm_mul_ps(half, _mm_add_ps(L1, L2));
+    __m128 cBarp = _mm_mul_ps(half, _mm_add_ps(c1p, c2p));
+    // mean hue, going the short way around the circle
+    __m128 hSum = _mm_add_ps(h1p, h2p);
+    __m128 far = _mm_cmpgt_ps(abs_ps(_mm_sub_ps(h1p, h2p)), d180);
+    __m128 wrap = select_ps(_mm_cmplt_ps(hSum, d360), d360, _mm_set1_ps(-360.0f));
+    __m128 hBarp = _mm_mul_ps(half, _mm_add_ps(hSum, _mm_and_ps(far, wrap)));
+    hBarp = select_ps(chromatic, hBarp, hSum);
+
+    // T from one sincos: cos/sin of 2h, 3h and 4h by angle addition, fixed offsets folded in
+    __m128 s1, c1;
+    sincos_ps(_mm_mul_ps(hBarp, _mm_set1_ps((float)DEG)), &s1, &c1);
+    __m128 c2 = _mm_sub_ps(sq_ps(c1), sq_ps(s1));
+    __m128 s2 = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_mul_ps(s1, c1));
+    __m128 c3 = _mm_sub_ps(_mm_mul_ps(c2, c1), _mm_mul_ps(s2, s1));
+    __m128 s3 = _mm_add_ps(_mm_mul_ps(s2, c1), _mm_mul_ps(c2, s1));
+    __m128 c4 = _mm_sub_ps(sq_ps(c2), sq_ps(s2));
+    __m128 s4 = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_mul_ps(s2, c2));
+    __m128 cos30 = _mm_add_ps(_mm_mul_ps(c1, _mm_set1_ps((float)std::cos(30.0 * DEG))), _mm_mul_ps(s1, _mm_set1_ps((float)std::sin(30.0 * DEG))));
+    __m128 cos3p6 = _mm_sub_ps(_mm_mul_ps(c3, _mm_set1_ps((float)std::cos(6.0 * DEG))), _mm_mul_ps(s3, _mm_set1_ps((float)std::sin(6.0 * DEG))));
+    __m128 cos4m63 = _mm_add_ps(_mm_mul_ps(c4, _mm_set1_ps((float)std::cos(63.0 * DEG))), _mm_mul_ps(s4, _mm_set1_ps((float)std::sin(63.0 * DEG))));
+    __m128 t = _mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(0.17f), cos30));
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(0.24f), c2));
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(0.32f), cos3p6));
+    t = _mm_sub_ps(t, _mm_mul_ps(_mm_set1_ps(0.20f), cos4m63));
+
+    __m128 hq = _mm_mul_ps(_mm_sub_ps(hBarp, _mm_set1_ps(275.0f)), _mm_set1_ps(1.0f / 25.0f));
+    __m128 dTheta = _mm_mul_ps(_mm_set1_ps(30.0f), exp_ps(_mm_sub_ps(zero, sq_ps(hq))));
+    __m128 rC = _mm_mul_ps(_mm_set1_ps(2.0f), chromaWeight_ps(cBarp));
+    __m128 l50 = sq_ps(_mm_sub_ps(lBarp, _mm_set1_ps(50.0f)));
+    __m128 sL = _mm_add_ps(one, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(0.015f), l50), _mm_sqrt_ps(_mm_add_ps(_mm_set1_ps(20.0f), l50))));
+    __m128 sC = _mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(0.045f), cBarp));
+    __m128 sH = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.015f), cBarp), t));
+    __m128 sin2Theta;
+    sincos_ps(_mm_mul_ps(dTheta, _mm_set1_ps((float)(2.0 * DEG))), &sin2Theta, &unused);
+    __m128 rT = _mm_sub_ps(zero, _mm_mul_ps(sin2Theta, rC));
+
+    __m128 l = _mm_div_ps(dLp, sL), c = _mm_div_ps(dCp, sC), h = _mm_div_ps(dHp, sH);
+    __m128 sum = _mm_add_ps(_mm_add_ps(sq_ps(l), sq_ps(c)), _mm_add_ps(sq_ps(h), _mm_mul_ps(rT, _mm_mul_ps(c, h))));
+    return _mm_sqrt_ps(_mm_max_ps(sum, zero));
+}
+
+static inline __m128 deltaE_ps(DeltaE formula, __m128 L1, __m128 a1, __m128 b1, __m128 L2, __m128 a2, __m128 b2)
+{
+    switch (formula)
+    {
+    case DeltaE::CIE76: return de76_ps(L1, a1, b1, L2, a2, b2);
+    case DeltaE::CIE94: return de94_ps(L1, a1, b1, L2, a2, b2);
+    case DeltaE::CIEDE2000: return de2000_ps(L1, a1, b1, L2, a2, b2);
+    }
+    return _mm_setzero_ps();
+}
+
+#endif
+
+// =======================================================
+// Batch versions
+// =======================================================
+
+void deltaEPairs(DeltaE formula, const float* const a[3], const float* const b[3], float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, deltaE_ps(formula,
+            _mm_loadu_ps(a[0] + i), _mm_loadu_ps(a[1] + i), _mm_loadu_ps(a[2] + i),
+            _mm_loadu_ps(b[0] + i), _mm_loadu_ps(b[1] + i), _mm_loadu_ps(b[2] + i)));
+#endif
+    for (; i < n; ++i)
+        out[i] = deltaE(formula, glm::vec3(a[0][i], a[1][i], a[2][i]), glm::vec3(b[0][i], b[1][i], b[2][i]));
+}
+
+void deltaEToReference(DeltaE formula, glm::vec3 ref, const float* const lab[3], float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    __m128 L1 = _mm_set1_ps(ref.x), a1 = _mm_set1_ps(ref.y), b1 = _mm_set1_ps(ref.z);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, deltaE_ps(formula, L1, a1, b1,
+            _mm_loadu_ps(lab[0] + i), _mm_loadu_ps(lab[1] + i), _mm_loadu_ps(lab[2] + i)));
+#endif
+    for (; i < n; ++i)
+        out[i] = deltaE(formula, ref, glm::vec3(lab[0][i], lab[1][i], lab[2][i]));
+}
+
+void deltaEMatrix(DeltaE formula, const float* const a[3], size_t n, const float* const b[3], size_t m, float* out)
+{
+    // one row per reference color; rows are independent, so whole row ranges go to each core
+    size_t minRows = std::max<size_t>(1, 4096 / std::max<size_t>(1, m));
+    parallelRanges(n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            deltaEToReference(formula, glm::vec3(a[0][i], a[1][i], a[2][i]), b, out + i * m, m);
+    }, minRows);
+}
+
+// =======================================================
+// Validation and throughput
+// =======================================================
+
+// Sharma, Wu & Dalal (2005), Table 1: Lab pairs and their CIEDE2000 differences
+static const float SHARMA_DATA[34][7] = {
+    { 50.0000f, 2.6772f, -79.7751f, 50.0000f, 0.0000f, -82.7485f, 2.0425f },
+    { 50.0000f, 3.1571f, -77.2803f, 50.0000f, 0.0000f, -82.7485f, 2.8615f },
+    { 50.0000f, 2.8361f, -74.0200f, 50.0000f, 0.0000f, -82.7485f, 3.4412f },
+    { 50.0000f, -1.3802f, -84.2814f, 50.0000f, 0.0000f, -82.7485f, 1.0000f },
+    { 50.0000f, -1.1848f, -84.8006f, 50.0000f, 0.0000f, -82.7485f, 1.0000f },
+    { 50.0000f, -0.9009f, -85.5211f, 50.0000f, 0.0000f, -82.7485f, 1.0000f },
+    { 50.0000f, 0.0000f, 0.0000f, 50.0000f, -1.0000f, 2.0000f, 2.3669f },
+    { 50.0000f, -1.0000f, 2.0000f, 50.0000f, 0.0000f, 0.0000f, 2.3669f },
+    { 50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0009f, 7.1792f },
+    { 50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0010f, 7.1792f },
+    { 50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0011f, 7.2195f },
+    { 50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0012f, 7.2195f },
+    { 50.0000f, -0.0010f, 2.4900f, 50.0000f, 0.0009f, -2.4900f, 4.8045f },
+    { 50.0000f, -0.0010f, 2.4900f, 50.0000f, 0.0010f, -2.4900f, 4.8045f },
+    { 50.0000f, -0.0010f, 2.4900f, 50.0000f, 0.0011f, -2.4900f, 4.7461f },
+    { 50.0000f, 2.5000f, 0.0000f, 50.0000f, 0.0000f, -2.5000f, 4.3065f },
+    { 50.0000f, 2.5000f, 0.0000f, 73.0000f, 25.0000f, -18.0000f, 27.1492f },
+    { 50.0000f, 2.5000f, 0.0000f, 61.0000f, -5.0000f, 29.0000f, 22.8977f },
+    { 50.0000f, 2.5000f, 0.0000f, 56.0000f, -27.0000f, -3.0000f, 31.9030f },
+    { 50.0000f, 2.5000f, 0.0000f, 58.0000f, 24.0000f, 15.0000f, 19.4535f },
+    { 50.0000f, 2.5000f, 0.0000f, 50.0000f, 3.1736f, 0.5854f, 1.0000f },
+    { 50.0000f, 2.5000f, 0.0000f, 50.0000f, 3.2972f, 0.0000f, 1.0000f },
+    { 50.0000f, 2.5000f, 0.0000f, 50.0000f, 1.8634f, 0.5757f, 1.0000f },
+    { 50.0000f, 2.5000f, 0.0000f, 50.0000f, 3.2592f, 0.3350f, 1.0000f },
+    { 60.2574f, -34.0099f, 36.2677f, 60.4626f, -34.1751f, 39.4387f, 1.2644f },
+    { 63.0109f, -31.0961f, -5.8663f, 62.8187f, -29.7946f, -4.0864f, 1.2630f },
+    { 61.2901f, 3.7196f, -5.3901f, 61.4292f, 2.2480f, -4.9620f, 1.8731f },
+    { 35.0831f, -44.1164f, 3.7933f, 35.0232f, -40.0716f, 1.5901f, 1.8645f },
+    { 22.7233f, 20.0904f, -46.6940f, 23.0331f, 14.9730f, -42.5619f, 2.0373f },
+    { 36.4612f, 47.8580f, 18.3852f, 36.2715f, 50.5065f, 21.2231f, 1.4146f },
+    { 90.8027f, -2.0831f, 1.4410f, 91.1528f, -1.6435f, 0.0447f, 1.4441f },
+    { 90.9257f, -0.5406f, -0.9208f, 88.6381f, -0.8985f, -0.7239f, 1.5381f },
+    { 6.7747f, -0.2908f, -2.4247f, 5.8714f, -0.0985f, -2.2286f, 0.6377f },
+    { 2.0776f, 0.0795f, -1.1350f, 0.9033f, -0.0636f, -0.5514f, 0.9082f },
+};
+
+bool benchmarkDeltaE()
+{
+    typedef std::chrono::steady_clock Clock;
+    char line[160];
+
+    // validation: the published values are rounded to 4 decimals, so 5e-5 of the error is rounding
+    const double SHARMA_TOLERANCE = 1e-4;
+    const size_t pairs = 34;
+    std::vector<float> sharma(pairs * 6);
+    const float* a[3] = { &sharma[0], &sharma[pairs], &sharma[2 * pairs] };
+    const float* b[3] = { &sharma[3 * pairs], &sharma[4 * pairs], &sharma[5 * pairs] };
+    for (size_t i = 0; i < pairs; ++i)
+        for (int k = 0; k < 6; ++k)
+            sharma[k * pairs + i] = SHARMA_DATA[i][k];
+    float batch[pairs];
+    deltaEPairs(DeltaE::CIEDE2000, a, b, batch, pairs);
+    double scalarError = 0.0, batchError = 0.0;
+    for (size_t i = 0; i < pairs; ++i)
+    {
+        const float* d = SHARMA_DATA[i];
+        float scalar = deltaE2000(glm::vec3(d[0], d[1], d[2]), glm::vec3(d[3], d[4], d[5]));
+        scalarError = std::max(scalarError, (double)std::fabs(scalar - d[6]));
+        batchError = std::max(batchError, (double)std::fabs(batch[i] - d[6]));
+    }
+    bool ok = scalarError <= SHARMA_TOLERANCE && batchError <= SHARMA_TOLERANCE;
+    snprintf(line, sizeof(line), "%sCIEDE2000 vs Sharma et al. (34 pairs): max error scalar %.2e, batch %.2e (tolerance %.0e)",
+        ok ? "" : "ERROR::DELTA_E::SHARMA_MISMATCH ", scalarError, batchError, SHARMA_TOLERANCE);
+    std::cout << line << std::endl;
+
+    // throughput on random Lab colors
+    const size_t n = 1 << 20;
+    std::vector<float> colors(n * 6);
+    unsigned int seed = 77;
+    for (size_t i = 0; i < n * 6; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float u = (seed >> 8) * (1.0f / 16777216.0f);
+        colors[i] = (i / n) % 3 == 0 ? u * 100.0f : u * 200.0f - 100.0f;
+    }
+    const float* p[3] = { &colors[0], &colors[n], &colors[2 * n] };
+    const float* q[3] = { &colors[3 * n], &colors[4 * n], &colors[5 * n] };
+    std::vector<float> out(n);
+
+    std::cout << "Delta E throughput, Mpairs/s (batch single core / scalar / " << std::max(1u, std::thread::hardware_concurrency())
+        << "-thread 1024x1024 matrix)" << std::endl;
+    const DeltaE formulas[] = { DeltaE::CIE76, DeltaE::CIE94, DeltaE::CIEDE2000 };
+    const char* names[] = { "CIE76", "CIE94", "CIEDE2000" };
+    for (int f = 0; f < 3; ++f)
+    {
+        Clock::time_point t0 = Clock::now();
+        deltaEPairs(formulas[f], p, q, out.data(), n);
+        double batchTime = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        t0 = Clock::now();
+        const size_t scalarCount = n / 8;
+        for (size_t i = 0; i < scalarCount; ++i)
+            out[i] = deltaE(formulas[f], glm::vec3(p[0][i], p[1][i], p[2][i]), glm::vec3(q[0][i], q[1][i], q[2][i]));
+        double scalarTime = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        t0 = Clock::now();
+        deltaEMatrix(formulas[f], p, 1024, q, 1024, out.data());
+        double matrixTime = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        snprintf(line, sizeof(line), "  %-10s %8.1f %8.1f %8.1f", names[f],
+            n / batchTime * 1e-6, scalarCount / scalarTime * 1e-6, 1024.0 * 1024.0 / matrixTime * 1e-6);
+        std::cout << line << std::endl;
+    }
+    return ok;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// =======================================================
+// Color differences (Delta E) on CIELAB
+// =======================================================
+//
+// CIE76: Euclidean distance in Lab. CIE94: graphic arts weights (kL = 1, K1 = 0.045,
+// K2 = 0.015). CIEDE2000: Sharma, Wu & Dalal (2005), kL = kC = kH = 1.
+// Colors are Lab triples as produced by convertColor(..., ColorSpace::Lab, ...).
+enum class DeltaE { CIE76, CIE94, CIEDE2000 };
+
+// scalar reference versions (double precision internally)
+float deltaE76(glm::vec3 lab1, glm::vec3 lab2);
+float deltaE94(glm::vec3 lab1, glm::vec3 lab2);
+float deltaE2000(glm::vec3 lab1, glm::vec3 lab2);
+float deltaE(DeltaE formula, glm::vec3 lab1, glm::vec3 lab2);
+
+// batch versions on planar (structure-of-arrays) Lab buffers, SSE2 where available.
+// Pairwise: out[i] = dE(a[i], b[i])
+void deltaEPairs(DeltaE formula, const float* const a[3], const float* const b[3], float* out, size_t n);
+// one reference against n colors: out[i] = dE(ref, lab[i])
+void deltaEToReference(DeltaE formula, glm::vec3 ref, const float* const lab[3], float* out, size_t n);
+// every a against every b, row-major n x m (out[i * m + j] = dE(a[i], b[j])), rows spread
+// over all cores
+void deltaEMatrix(DeltaE formula, const float* const a[3], size_t n, const float* const b[3], size_t m, float* out);
+
+// checks the scalar and batch CIEDE2000 against the 34 pairs of the Sharma test data, then
+// prints pairs/s per formula (--bench-delta-e); false if either is off by more than 1e-4
+bool benchmarkDeltaE();
@@ -0,0 +1,346 @@
+#include "eyedropper.hpp"
+#include "shader_manager.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// =======================================================
+// Tile shaders
+// =======================================================
+
+const char* image_vs = R"(
+#version 330 core
+layout (location = 0) in vec2 corner; // (0,0) top left .. (1,1) bottom right
+out vec2 TexCoord;
+
+uniform vec4 rect;   // x0, y0, x1, y1 in NDC
+uniform vec4 uvRect; // u0, v0, u1, v1; v grows downwards like the tile rows
+
+void main()
+{
+    gl_Position = vec4(mix(rect.x, rect.z, corner.x), mix(rect.w, rect.y, corner.y), 0.0, 1.0);
+    TexCoord = mix(uvRect.xy, uvRect.zw, corner);
+}
+)";
+
+const char* image_fs = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2DArray tiles;
+uniform float layer;
+uniform bool uLinearOutput;
+
+vec3 srgb_to_linear(vec3 c)
+{
+    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
+
+void main()
+{
+    vec3 rgb = texture(tiles, vec3(TexCoord, layer)).rgb;
+#ifdef RECOLOR
+    rgb = recolor(rgb);
+#endif
+    FragColor = vec4(uLinearOutput ? srgb_to_linear(rgb) : rgb, 1.0);
+}
+)";
+
+static GLuint imageProgram, imageRecolorProgram;
+static GLuint quadVAO, quadVBO;
+static std::string imageCacheDir = "image_cache";
+
+void initImageView()
+{
+    imageProgram = createProgram("image", image_vs, image_fs);
+    std::string recolor_fs = withPrelude(image_fs, std::string("#define RECOLOR\n") + recolor_glsl);
+    imageRecolorProgram = createProgram("image_recolor", image_vs, recolor_fs.c_str());
+    const float corners[] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f };
+    glGenVertexArrays(1, &quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glBindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+void setImageCacheDir(const std::string& dir)
+{
+    imageCacheDir = dir;
+}
+
+// =======================================================
+// Loading
+// =======================================================
+
+bool TiledImage::load(const std::string& path)
+{
+    // resident tiles belong to the previous image
+    for (Slot& slot : slots)
+        slot = Slot();
+    if (!pyramid.open(path, imageCacheDir)) return false;
+    if (pyramid.fromCache())
+        std::cout << "image pyramid of " << path << " mapped from the cache" << std::endl;
+    // fitted by the next setViewport
+    fitPending = true;
+    return true;
+}
+
+void TiledImage::close()
+{
+    pyramid.close();
+    for (Slot& slot : slots)
+        slot = Slot();
+}
+
+// =======================================================
+// View transform
+// =======================================================
+
+void TiledImage::setViewport(glm::vec4 rect, int framebufferWidth, int framebufferHeight)
+{
+    framebufferW = std::max(framebufferWidth, 1);
+    framebufferH = std::max(framebufferHeight, 1);
+    viewportX = (rect.x + 1.0f) * 0.5f * framebufferW;
+    viewportY = (1.0f - rect.w) * 0.5f * framebufferH;
+    viewportW = std::max((rect.z - rect.x) * 0.5f * framebufferW, 1.0f);
+    viewportH = std::max((rect.w - rect.y) * 0.5f * framebufferH, 1.0f);
+    // moved to another part of the window: fit again there
+    if (rect.x != viewportRect.x || rect.y != viewportRect.y || rect.z != viewportRect.z || rect.w != viewportRect.w)
+    {
+        viewportRect = rect;
+        fitPending = true;
+    }
+    if (fitPending) resetView();
+}
+
+void TiledImage::resetView()
+{
+    if (!loaded()) return;
+    scale = std::min(viewportW / width(), viewportH / height());
+    centerX = width() * 0.5;
+    centerY = height() * 0.5;
+    fitPending = false;
+}
+
+void TiledImage::zoom(float factor, float x, float y)
+{
+    if (!loaded()) return;
+    // from a quarter of the fitted size up to 64 screen pixels per image pixel
+    float fit = std::min(viewportW / width(), viewportH / height());
+    float next = std::min(std::max(scale * factor, fit * 0.25f), 64.0f);
+    double fx = (x + 1.0) * 0.5 * framebufferW - (viewportX + viewportW * 0.5);
+    double fy = (1.0 - y) * 0.5 * framebufferH - (viewportY + viewportH * 0.5);
+    centerX += fx / scale - fx / next;
+    centerY += fy / scale - fy / next;
+    scale = next;
+}
+
+void TiledImage::pan(float dx, float dy)
+{
+    if (!loaded()) return;
+    // the view center stays on the image, so it can't be lost off screen
+    centerX = std::min(std::max(centerX - dx * 0.5 * framebufferW / scale, 0.0), (double)width());
+    centerY = std::min(std::max(centerY + dy * 0.5 * framebufferH / scale, 0.0), (double)height());
+}
+
+bool TiledImage::pixelAt(float x, float y, int& px, int& py) const
+{
+    if (!loaded()) return false;
+    double fx = (x + 1.0) * 0.5 * framebufferW, fy = (1.0 - y) * 0.5 * framebufferH;
+    if (fx < viewportX || fy < viewportY || fx >= viewportX + viewportW || fy >= viewportY + viewportH)
+        return false;
+    px = (int)std::floor(centerX + (fx - viewportX - viewportW * 0.5) / scale);
+    py = (int)std::floor(centerY + (fy - viewportY - viewportH * 0.5) / scale);
+    return px >= 0 && py >= 0 && px < width() && py < height();
+}
+
+glm::vec2 TiledImage::imageToNdc(double x, double y) const
+{
+    double fx = viewportX + viewportW * 0.5 + (x - centerX) * scale;
+    double fy = viewportY + viewportH * 0.5 + (y - centerY) * scale;
+    return glm::vec2((float)(fx / framebufferW * 2.0 - 1.0), (float)(1.0 - fy / framebufferH * 2.0));
+}
+
+// =======================================================
+// Tile residency
+// =======================================================
+
+int TiledImage::viewLevel() const
+{
+    // the level with at most two texels per screen pixel, so bilinear sampling doesn't alias
+    int level = (int)std::floor(std::log2(1.0 / scale));
+    return std::min(std::max(level, 0), pyramid.levels() - 1);
+}
+
+int TiledImage::findSlot(int level, int tx, int ty) const
+{
+    for (size_t i = 0; i < slots.size(); ++i)
+        if (slots[i].level == level && slots[i].tx == tx && slots[i].ty == ty)
+            return (int)i;
+    return -1;
+}
+
+int TiledImage::availableRows(int level, int ty) const
+{
+    // a finished level has its padding rows too
+    int done = pyramid.rowsDone(level);
+    if (done == (int)pyramid.level(level).height) return PYRAMID_TILE_SIZE;
+    return std::min(std::max(done - ty * PYRAMID_TILE_SIZE, 0), PYRAMID_TILE_SIZE);
+}
+
+bool TiledImage::makeResident(const TileRef& tile, double deadline, int& uploads)
+{
+    int rows = availableRows(tile.level, tile.ty);
+    int index = findSlot(tile.level, tile.tx, tile.ty);
+    if (index >= 0)
+    {
+        slots[index].lastUsed = frame;
+        if (slots[index].rows >= rows) return true;
+    }
+    if (rows == 0 || glfwGetTime() >= deadline) return index >= 0;
+
+    if (index < 0)
+    {
+        // a free layer, else the least recently used one not needed this frame
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            if (slots[i].lastUsed == frame && slots[i].level >= 0) continue;
+            if (index < 0 || slots[i].level < 0 || slots[i].lastUsed < slots[index].lastUsed)
+                index = (int)i;
+            if (slots[index].level < 0) break;
+        }
+        if (index < 0) return false;
+        slots[index] = Slot();
+        slots[index].level = tile.level;
+        slots[index].tx = tile.tx;
+        slots[index].ty = tile.ty;
+        slots[index].lastUsed = frame;
+    }
+
+    // only the rows built since the last upload; tiles are read straight from the mapping
+    Slot& slot = slots[index];
+    const unsigned char* pixels = pyramid.tile(tile.level, tile.tx, tile.ty);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, slot.rows, index, PYRAMID_TILE_SIZE, rows - slot.rows, 1, GL_RGB, GL_UNSIGNED_BYTE,
+        pixels + (size_t)slot.rows * PYRAMID_TILE_SIZE * 3);
+    slot.rows = rows;
+    ++uploads;
+    return true;
+}
+
+int TiledImage::uploadTiles(double budgetSeconds)
+{
+    if (!loaded()) return 0;
+    ++frame;
+    if (!tileArray)
+    {
+        slots.assign(IMAGE_RESIDENT_TILES, Slot());
+        visible.reserve(IMAGE_RESIDENT_TILES);
+        glGenTextures(1, &tileArray);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tileArray);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, PYRAMID_TILE_SIZE, PYRAMID_TILE_SIZE, IMAGE_RESIDENT_TILES, 0, GL_RGB,
+            GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // tiles of the view's level that overlap the viewport, nearest to its center first
+    int level = viewLevel();
+    const PyramidLevel& lv = pyramid.level(level);
+    double span = (double)PYRAMID_TILE_SIZE * (1 << level);
+    double halfW = viewportW * 0.5 / scale, halfH = viewportH * 0.5 / scale;
+    int tx0 = std::max((int)std::floor((centerX - halfW) / span), 0);
+    int tx1 = std::min((int)std::floor((centerX + halfW) / span), (int)lv.tilesX - 1);
+    int ty0 = std::max((int)std::floor((centerY - halfH) / span), 0);
+    int ty1 = std::min((int)std::floor((centerY + halfH) / span), (int)lv.tilesY - 1);
+    visible.clear();
+    for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            visible.push_back(TileRef{ level, tx, ty });
+    std::sort(visible.begin(), visible.end(), [&](const TileRef& a, const TileRef& b) {
+        double ax = (a.tx + 0.5) * span - centerX, ay = (a.ty + 0.5) * span - centerY;
+        double bx = (b.tx + 0.5) * span - centerX, by = (b.ty + 0.5) * span - centerY;
+        return ax * ax + ay * ay < bx * bx + by * by;
+    });
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tileArray);
+    double deadline = glfwGetTime() + budgetSeconds;
+    int uploads = 0;
+    // the coarsest level is a single tile that stands in for anything not resident yet
+    makeResident(TileRef{ pyramid.levels() - 1, 0, 0 }, deadline, uploads);
+    for (const TileRef& tile : visible)
+        makeResident(tile, deadline, uploads);
+    return uploads;
+}
+
+// =======================================================
+// Drawing
+// =======================================================
+
+void TiledImage::drawTile(const Slot& slot, int layer, glm::vec4 area)
+{
+    // the part of area (image pixels: x0, y0, x1, y1) the slot's uploaded rows cover
+    const double S = PYRAMID_TILE_SIZE;
+    double span = S * (1 << slot.level);
+    double left = slot.tx * span, top = slot.ty * span;
+    double x0 = std::max((double)area.x, left), x1 = std::min({ (double)area.z, left + span, (double)width() });
+    double y0 = std::max((double)area.y, top), y1 = std::min({ (double)area.w, top + slot.rows / S * span, (double)height() });
+    if (x0 >= x1 || y0 >= y1) return;
+
+    GLuint program = drawProgram;
+    glm::vec2 a = imageToNdc(x0, y0), b = imageToNdc(x1, y1);
+    glUniform4f(glGetUniformLocation(program, "rect"), a.x, b.y, b.x, a.y);
+    glUniform4f(glGetUniformLocation(program, "uvRect"), (float)((x0 - left) / span), (float)((y0 - top) / span),
+        (float)((x1 - left) / span), (float)((y1 - top) / span));
+    glUniform1f(glGetUniformLocation(program, "layer"), (float)layer);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+void TiledImage::draw(bool linearOutput, const RecolorParams* recolor)
+{
+    if (!loaded() || !tileArray) return;
+    GLuint program = finishProgram(recolor ? imageRecolorProgram : imageProgram);
+    drawProgram = program;
+    glUseProgram(program);
+    if (recolor) setRecolorUniforms(program, *recolor);
+    glUniform1i(glGetUniformLocation(program, "tiles"), 0);
+    glUniform1i(glGetUniformLocation(program, "uLinearOutput"), linearOutput);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, tileArray);
+    glBindVertexArray(quadVAO);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor((GLint)viewportX, (GLint)(framebufferH - viewportY - viewportH), (GLsizei)std::ceil(viewportW),
+        (GLsizei)std::ceil(viewportH));
+
+    for (const TileRef& tile : visible)
+    {
+        float span = (float)PYRAMID_TILE_SIZE * (1 << tile.level);
+        glm::vec4 area(tile.tx * span, tile.ty * span, (tile.tx + 1) * span, (tile.ty + 1) * span);
+        int index = findSlot(tile.level, tile.tx, tile.ty);
+        if (index < 0 || slots[index].rows < PYRAMID_TILE_SIZE)
+        {
+            // missing or still filling in: the nearest resident ancestor underneath
+            for (int level = tile.level + 1; level < pyramid.levels(); ++level)
+            {
+                int shift = level - tile.level;
+                int ancestor = findSlot(level, tile.tx >> shift, tile.ty >> shift);
+                if (ancestor >= 0 && slots[ancestor].rows > 0)
+                {
+                    drawTile(slots[ancestor], ancestor, area);
+                    break;
+                }
+            }
+        }
+        if (index >= 0 && slots[index].rows > 0)
+            drawTile(slots[index], index, area);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
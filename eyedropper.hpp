@@ -0,0 +1,106 @@
+#pragma once
+
+#include "image_pyramid.hpp"
+#include "recolor.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// =======================================================
+// Eyedropper image: virtual-texture view of a tiled pyramid
+// =======================================================
+
+// texture array layers holding resident tiles (256x256 RGB8 each, 48 MB in total); when a new
+// tile is needed the least recently drawn one is replaced
+#define IMAGE_RESIDENT_TILES 256
+
+// An image loaded for picking, shown with pan and zoom. Its pixels live in an ImagePyramid
+// (image_pyramid.hpp), built in the background the first time and mapped from the disk cache
+// afterwards. Each frame only the tiles covering the view, at the level matching the zoom, are
+// made resident, within an upload time budget; tiles that aren't resident yet are drawn from
+// the closest coarser one that is. Frame time and GPU memory don't grow with the image.
+class TiledImage
+{
+public:
+    // opens the file's pyramid from the cache or starts building it; false if the file can't
+    // be read. Replaces the image loaded before and fits the new one into the view. Needs no GL
+    // context
+    bool load(const std::string& path);
+    // stops a running build and unmaps the pyramid
+    void close();
+
+    bool loaded() const { return pyramid.isOpen(); }
+    bool fromCache() const { return pyramid.fromCache(); }
+    int width() const { return pyramid.width(); }
+    int height() const { return pyramid.height(); }
+    // fraction of the pyramid built so far
+    float progress() const { return pyramid.progress(); }
+    // the pixels, for whole-image analysis
+    const ImagePyramid& source() const { return pyramid; }
+
+    // the image is shown inside rect (x0, y0, x1, y1 in NDC) of a framebuffer of the given
+    // size; call each frame before uploading and drawing. A different rect fits the image again
+    void setViewport(glm::vec4 rect, int framebufferWidth, int framebufferHeight);
+    // fits the whole image into the viewport
+    void resetView();
+    // scales the view by factor around an NDC point, which stays over the same image pixel
+    void zoom(float factor, float x, float y);
+    // moves the image by an NDC offset
+    void pan(float dx, float dy);
+    // framebuffer pixels per image pixel
+    float zoomLevel() const { return scale; }
+    // image pixel under an NDC point; false outside the viewport or the image
+    bool pixelAt(float x, float y, int& px, int& py) const;
+    // sRGB color of a full-resolution pixel; false outside the image or before its row is decoded
+    bool pixel(int x, int y, glm::vec3& rgb) const { return pyramid.pixel(x, y, rgb); }
+
+    // makes the tiles the view needs resident, uploading until budgetSeconds have passed; call
+    // once per frame with a current GL context. Returns the number of tile uploads
+    int uploadTiles(double budgetSeconds);
+    // draws the view, scissored to the viewport; with recolor, through the recolor shader
+    // (recolor.hpp), so changed parameters show in the same frame
+    void draw(bool linearOutput, const RecolorParams* recolor = nullptr);
+
+private:
+    struct Slot
+    {
+        int level = -1, tx = 0, ty = 0;
+        int rows = 0;           // rows uploaded; tiles fill in while the pyramid builds
+        unsigned lastUsed = 0;  // frame number
+    };
+    struct TileRef
+    {
+        int level, tx, ty;
+    };
+
+    int viewLevel() const;
+    int findSlot(int level, int tx, int ty) const;
+    int availableRows(int level, int ty) const;
+    bool makeResident(const TileRef& tile, double deadline, int& uploads);
+    void drawTile(const Slot& slot, int layer, glm::vec4 area);
+    glm::vec2 imageToNdc(double x, double y) const;
+
+    ImagePyramid pyramid;
+    // view: image pixel at the viewport center and framebuffer pixels per image pixel
+    double centerX = 0.0, centerY = 0.0;
+    float scale = 1.0f;
+    bool fitPending = true;
+    // viewport in framebuffer pixels, y down
+    glm::vec4 viewportRect = glm::vec4(0.0f);  // as last given to setViewport, NDC
+    float viewportX = 0.0f, viewportY = 0.0f, viewportW = 1.0f, viewportH = 1.0f;
+    int framebufferW = 1, framebufferH = 1;
+
+    GLuint tileArray = 0;
+    GLuint drawProgram = 0;  // the program draw() uses this frame
+    std::vector<Slot> slots;
+    std::vector<TileRef> visible;  // tiles of the current view, reused every frame
+    unsigned frame = 0;
+};
+
+// creates the program that draws image tiles; call once with a current GL context
+void initImageView();
+// directory of the pyramid cache, "image_cache" by default; empty keeps pyramids in memory
+void setImageCacheDir(const std::string& dir);
@@ -0,0 +1,116 @@
+#include "fast_math.hpp"
+#include "simd_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// =======================================================
+// Batches
+// =======================================================
+
+void fastAtan2Batch(const float* y, const float* x, float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, fastAtan2_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+#endif
+    for (; i < n; ++i)
+        out[i] = fastAtan2(y[i], x[i]);
+}
+
+void fastRsqrtBatch(const float* v, float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef RGBPICK_SSE2
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, fastRsqrt_ps(_mm_loadu_ps(v + i)));
+#endif
+    for (; i < n; ++i)
+        out[i] = fastRsqrt(v[i]);
+}
+
+// =======================================================
+// Error check against libm
+// =======================================================
+
+static bool reportError(const char* name, double scalarError, double batchError, double bound)
+{
+    bool ok = scalarError <= bound && batchError <= bound;
+    char line[160];
+    snprintf(line, sizeof(line), "%s max error: scalar %.3e, batch %.3e (bound %.3e)%s", name, scalarError, batchError, bound,
+        ok ? "" : " FAIL");
+    std::cout << line << std::endl;
+    return ok;
+}
+
+bool checkFastMath()
+{
+    // one grid row at a time, so the batch path sees the same points as the scalar one
+    const int GRID = 8001;
+    std::vector<float> y(GRID), x(GRID), out(GRID);
+    for (int i = 0; i < GRID; ++i)
+        x[i] = -1.0f + 2.0f * i / (GRID - 1);
+    double scalarError = 0.0, batchError = 0.0;
+    for (int j = 0; j < GRID; ++j)
+    {
+        std::fill(y.begin(), y.end(), -1.0f + 2.0f * j / (GRID - 1));
+        fastAtan2Batch(y.data(), x.data(), out.data(), GRID);
+        for (int i = 0; i < GRID; ++i)
+        {
+            double reference = std::atan2((double)y[i], (double)x[i]);
+            scalarError = std::max(scalarError, std::fabs(fastAtan2(y[i], x[i]) - reference));
+            batchError = std::max(batchError, std::fabs(out[i] - reference));
+        }
+    }
+    bool ok = reportError("fastAtan2 (8001x8001 grid of [-1,1]^2, rad)", scalarError, batchError, FAST_ATAN2_MAX_ERROR);
+
+    // every float from 2^-32 to 2^32, walked by bit pattern
+    const size_t BLOCK = 1 << 16;
+    std::vector<float> v(BLOCK);
+    out.resize(BLOCK);
+    float lowest = std::ldexp(1.0f, -32), highest = std::ldexp(1.0f, 32);
+    uint32_t first, last;
+    memcpy(&first, &lowest, sizeof(first));
+    memcpy(&last, &highest, sizeof(last));
+    scalarError = batchError = 0.0;
+    for (uint64_t bits = first; bits <= last; bits += BLOCK)
+    {
+        size_t n = (size_t)std::min<uint64_t>(BLOCK, last - bits + 1);
+        for (size_t k = 0; k < n; ++k)
+        {
+            uint32_t b = (uint32_t)(bits + k);
+            memcpy(&v[k], &b, sizeof(b));
+        }
+        fastRsqrtBatch(v.data(), out.data(), n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            double sq = std::sqrt((double)v[k]);
+            scalarError = std::max(scalarError, std::fabs(fastRsqrt(v[k]) * sq - 1.0));
+            batchError = std::max(batchError, std::fabs(out[k] * sq - 1.0));
+        }
+    }
+    ok = reportError("fastRsqrt (every float in [2^-32, 2^32], relative)", scalarError, batchError, FAST_RSQRT_MAX_ERROR) && ok;
+    return ok;
+}
+
+// =======================================================
+
+const char* fast_math_glsl =
+"float fast_atan2(float y, float x)\n"
+"{\n"
+"    float ax = abs(x), ay = abs(y);\n"
+"    float a = min(ax, ay) / max(max(ax, ay), 1e-30);\n"
+"    float s = a * a;\n"
+"    float r = a * (0.9998660 + s * (-0.3302995 + s * (0.1801410 + s * (-0.0851330 + s * 0.0208351))));\n"
+"    r = ay > ax ? 1.57079633 - r : r;\n"
+"    r = x < 0.0 ? 3.14159265 - r : r;\n"
+"    return y < 0.0 ? -r : r;\n"
+"}\n"
+"float fast_rsqrt(float v)\n"
+"{\n"
+"    return inversesqrt(v);\n"
+"}\n";
@@ -0,0 +1,119 @@
+#include "frame_pacing.hpp"
+#include "frame_stats.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// bounds of the margin waitUntil leaves between waking from sleep and the deadline (seconds)
+#define PACING_MIN_MARGIN 0.0002
+#define PACING_MAX_MARGIN 0.004
+
+static const char* modeNames[(int)PacingMode::Count] = { "vsync", "adaptive", "cap", "on-change", "uncapped" };
+
+static PacingMode mode = PacingMode::Vsync;
+static double cap = 60.0;
+static double slotEnd = 0.0;      // Cap mode: when the current frame's slot is over, 0 before the first
+static double lastFrame = -1.0;
+static double sleepMargin = 0.001;
+
+// =======================================================
+// Modes
+// =======================================================
+
+bool parsePacingMode(const std::string& name, PacingMode& m)
+{
+    for (int i = 0; i < (int)PacingMode::Count; ++i)
+        if (name == modeNames[i])
+        {
+            m = (PacingMode)i;
+            return true;
+        }
+    return false;
+}
+
+const char* pacingModeName(PacingMode m)
+{
+    return modeNames[(int)m];
+}
+
+void setPacingMode(PacingMode m)
+{
+    mode = m;
+    int interval = 1;
+    if (m == PacingMode::Cap || m == PacingMode::Uncapped)
+        interval = 0;
+    else if (m == PacingMode::Adaptive)
+    {
+        if (glfwExtensionSupported("GLX_EXT_swap_control_tear") || glfwExtensionSupported("WGL_EXT_swap_control_tear"))
+            interval = -1;
+        else
+            std::cout << "adaptive vsync isn't supported by the driver, using vsync" << std::endl;
+    }
+    glfwSwapInterval(interval);
+    restartFramePacing();
+}
+
+PacingMode pacingMode()
+{
+    return mode;
+}
+
+void setFpsCap(double fps)
+{
+    cap = std::min(std::max(fps, 1.0), 10000.0);
+    restartFramePacing();
+}
+
+double fpsCap()
+{
+    return cap;
+}
+
+// =======================================================
+// Waiting
+// =======================================================
+
+void waitUntil(double deadline)
+{
+    double now = glfwGetTime();
+    double sleepFor = deadline - now - sleepMargin;
+    if (sleepFor > 0.0)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(sleepFor));
+        double late = glfwGetTime() - (now + sleepFor);
+        // a late wake-up widens the margin at once; it narrows again slowly
+        sleepMargin = std::min(std::max(std::max(late * 1.25, sleepMargin * 0.98), PACING_MIN_MARGIN), PACING_MAX_MARGIN);
+    }
+    while (glfwGetTime() < deadline)
+        std::this_thread::yield();
+}
+
+void paceFrame()
+{
+    if (mode == PacingMode::Cap)
+    {
+        double period = 1.0 / cap;
+        double now = glfwGetTime();
+        // slots follow one another, so a slightly late frame doesn't shift the ones after it; a frame
+        // more than a whole slot late starts the schedule again rather than rushing to catch up
+        if (slotEnd == 0.0 || now - slotEnd > period)
+            slotEnd = now;
+        else if (now < slotEnd)
+            waitUntil(slotEnd);
+        slotEnd += period;
+    }
+    double now = glfwGetTime();
+    if (lastFrame >= 0.0)
+        recordFrameInterval(now - lastFrame);
+    lastFrame = now;
+}
+
+void restartFramePacing()
+{
+    slotEnd = 0.0;
+    lastFrame = -1.0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+// =======================================================
+// Frame pacing: swap interval, frame-rate cap, idle waits
+// =======================================================
+
+// how the frame loop is paced (--pacing, V cycles at runtime)
+enum class PacingMode
+{
+    Vsync,     // swap interval 1: one frame per display refresh
+    Adaptive,  // swap interval -1: vsync, but a late frame is shown at once (tearing) rather than a whole
+               // refresh later; plain vsync where the driver lacks EXT_swap_control_tear
+    Cap,       // no vsync; each frame waits out the rest of its 1 / cap seconds
+    OnChange,  // vsync, and the loop sleeps until input or background work changes what is shown
+    Uncapped,  // no vsync, no waiting
+    Count
+};
+
+// "vsync", "adaptive", "cap", "on-change" or "uncapped"
+bool parsePacingMode(const std::string& name, PacingMode& mode);
+const char* pacingModeName(PacingMode mode);
+
+// sets the swap interval of the current context for the mode and starts pacing afresh
+void setPacingMode(PacingMode mode);
+PacingMode pacingMode();
+// frames per second in Cap mode (60 by default)
+void setFpsCap(double fps);
+double fpsCap();
+
+// call right after the swap: in Cap mode waits for the frame's slot to end, and in every mode
+// hands the time since the previous frame to the frame statistics (jitter)
+void paceFrame();
+// call after the loop sat idle, so the gap isn't counted as a frame
+void restartFramePacing();
+// waits until glfwGetTime() reaches deadline: sleeps until shortly before it, by a margin that
+// tracks how late sleeps have woken up, then spins (yielding) for the rest
+void waitUntil(double deadline);
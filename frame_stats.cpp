@@ -0,0 +1,147 @@
+#include "frame_stats.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// =======================================================
+// Per-pass GPU (GL_TIME_ELAPSED) and CPU timings
+// =======================================================
+
+static const char* passNames[PASS_COUNT] = {
+    "wheel (shaded)",
+    "wheel cache rebuild",
+    "wheel cache blit",
+    "eyedropper image",
+    "hue histogram",
+    "alpha bar",
+    "value bar",
+    "output box",
+    "text",
+};
+
+// timer results arrive a few frames late, so each pass has a small ring of queries
+static const int QUERY_FRAMES = 4;
+
+static bool enabled = false;
+static bool synchronous = false;
+static GLuint queries[QUERY_FRAMES][PASS_COUNT];
+static bool queryIssued[QUERY_FRAMES][PASS_COUNT];
+static int frameSlot = 0;
+
+static double cpuStart[PASS_COUNT];
+
+// accumulated since the last report
+static double gpuTotal[PASS_COUNT], cpuTotal[PASS_COUNT];
+static int gpuSamples[PASS_COUNT], cpuSamples[PASS_COUNT];
+static int framesSinceReport = 0;
+static double lastReport = 0.0;
+// frame intervals since the last report
+static double intervalSum = 0.0, intervalSquares = 0.0, intervalMin = 0.0, intervalMax = 0.0;
+static int intervals = 0;
+
+void initFrameStats()
+{
+    glGenQueries(QUERY_FRAMES * PASS_COUNT, &queries[0][0]);
+    lastReport = glfwGetTime();
+}
+
+void setFrameStatsEnabled(bool on)
+{
+    enabled = on;
+}
+
+bool frameStatsEnabled()
+{
+    return enabled;
+}
+
+void setFrameStatsSync(bool sync)
+{
+    synchronous = sync;
+}
+
+void beginPass(RenderPass pass)
+{
+    if (!enabled) return;
+    if (synchronous) glFinish();
+    cpuStart[pass] = glfwGetTime();
+    glBeginQuery(GL_TIME_ELAPSED, queries[frameSlot][pass]);
+}
+
+void endPass(RenderPass pass)
+{
+    if (!enabled) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    if (synchronous) glFinish();
+    queryIssued[frameSlot][pass] = true;
+    cpuTotal[pass] += glfwGetTime() - cpuStart[pass];
+    cpuSamples[pass]++;
+}
+
+void endFrameStats(double interval)
+{
+    if (!enabled) return;
+    framesSinceReport++;
+
+    // read back the oldest slot, which is reused next frame; results not ready yet are dropped
+    // rather than stalling the pipeline
+    frameSlot = (frameSlot + 1) % QUERY_FRAMES;
+    for (int p = 0; p < PASS_COUNT; ++p)
+    {
+        if (!queryIssued[frameSlot][p]) continue;
+        queryIssued[frameSlot][p] = false;
+
+        GLint available = 0;
+        glGetQueryObjectiv(queries[frameSlot][p], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[frameSlot][p], GL_QUERY_RESULT, &ns);
+        gpuTotal[p] += ns * 1e-9;
+        gpuSamples[p]++;
+    }
+
+    if (glfwGetTime() - lastReport >= interval)
+        printFrameStats();
+}
+
+void recordFrameInterval(double seconds)
+{
+    if (!enabled) return;
+    intervalMin = intervals ? std::min(intervalMin, seconds) : seconds;
+    intervalMax = intervals ? std::max(intervalMax, seconds) : seconds;
+    intervalSum += seconds;
+    intervalSquares += seconds * seconds;
+    intervals++;
+}
+
+void printFrameStats()
+{
+    printf("\nPass timings over %d frames (avg ms per executed pass: GPU / CPU %s):\n",
+        framesSinceReport, synchronous ? "incl. glFinish" : "submit");
+    for (int p = 0; p < PASS_COUNT; ++p)
+    {
+        if (!cpuSamples[p]) continue;
+        printf("  %-22s %8.3f / %7.3f  (%d runs)\n", passNames[p],
+            gpuSamples[p] ? gpuTotal[p] * 1000.0 / gpuSamples[p] : 0.0,
+            cpuTotal[p] * 1000.0 / cpuSamples[p], cpuSamples[p]);
+        gpuTotal[p] = cpuTotal[p] = 0.0;
+        gpuSamples[p] = cpuSamples[p] = 0;
+    }
+    // jitter as the standard deviation of the interval, which a steady pace keeps near zero whatever the rate
+    if (intervals)
+    {
+        double mean = intervalSum / intervals;
+        double jitter = std::sqrt(std::max(intervalSquares / intervals - mean * mean, 0.0));
+        printf("  %-22s %8.3f ms avg, jitter %.3f ms, %.3f .. %.3f ms  (%d frames)\n", "frame interval", mean * 1000.0,
+            jitter * 1000.0, intervalMin * 1000.0, intervalMax * 1000.0, intervals);
+        intervalSum = intervalSquares = 0.0;
+        intervals = 0;
+    }
+    framesSinceReport = 0;
+    lastReport = glfwGetTime();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// render passes timed by the frame statistics
+enum RenderPass
+{
+    PASS_WHEEL,         // wheel shaded every frame
+    PASS_WHEEL_CACHE,   // re-rendering the cached wheel texture
+    PASS_WHEEL_BLIT,    // copying the cached wheel to the screen
+    PASS_IMAGE,         // eyedropper image: tile uploads and drawing
+    PASS_HISTOGRAM,     // image hue histogram: binning new rows and the overlay
+    PASS_ALPHA_BAR,
+    PASS_VALUE_BAR,
+    PASS_OUTPUT_BOX,
+    PASS_TEXT,
+    PASS_COUNT
+};
+
+// creates the GPU timer queries; call once with a current GL context
+void initFrameStats();
+// enables or disables timing; disabled passes cost nothing
+void setFrameStatsEnabled(bool enabled);
+bool frameStatsEnabled();
+// finish the GL queue around every pass so the CPU time covers the pass's execution too;
+// needed on drivers that defer rasterization to the swap (llvmpipe), whose timer queries
+// then report ~0 for draw calls
+void setFrameStatsSync(bool sync);
+// brackets the GL commands of a pass (passes must not nest)
+void beginPass(RenderPass pass);
+void endPass(RenderPass pass);
+// collects finished GPU timings and prints per-pass averages about once every interval seconds
+void endFrameStats(double interval = 2.0);
+// adds the time between two presented frames (frame_pacing.hpp), reported as the average
+// interval and its jitter
+void recordFrameInterval(double seconds);
+// prints the per-pass averages collected since the last report and starts collecting again
+void printFrameStats();
@@ -0,0 +1,282 @@
+#include "golden_test.hpp"
+#include "color_spaces.hpp"
+#include "color_transfer.hpp"
+#include "delta_e.hpp"
+#include "image_loader.hpp"
+#include "simd_math.hpp"
+#include "thread_pool.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <png.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// pixels converted to Lab and compared at a time
+#define DIFF_BLOCK 1024
+
+// =======================================================
+// States
+// =======================================================
+
+std::vector<GoldenState> goldenStates()
+{
+    static const float SATURATIONS[] = { 0.35f, 0.7f, 1.0f };
+    static const float VALUES[] = { 0.5f, 1.0f };
+    static const float ALPHAS[] = { 0.0f, 0.5f, 1.0f };
+    static const int SIZES[][2] = { { 800, 800 }, { 640, 480 }, { 1024, 768 } };
+    std::vector<GoldenState> states;
+    // one window size after another, so the window is resized only twice
+    for (const int* size : SIZES)
+        for (int h = 0; h < 8; ++h)
+            for (float s : SATURATIONS)
+                for (float v : VALUES)
+                    for (float a : ALPHAS)
+                    {
+                        char name[64];
+                        snprintf(name, sizeof(name), "h%03d_s%03d_v%03d_a%03d_%dx%d", h * 45, (int)(s * 100.0f + 0.5f),
+                            (int)(v * 100.0f + 0.5f), (int)(a * 100.0f + 0.5f), size[0], size[1]);
+                        states.push_back({ name, h / 8.0f, s, v, a, size[0], size[1] });
+                    }
+    return states;
+}
+
+// =======================================================
+// Per-pixel Delta E
+// =======================================================
+
+static bool pixelDiffers(const uint8_t* a, const uint8_t* b, size_t p)
+{
+    return a[p * 3] != b[p * 3] || a[p * 3 + 1] != b[p * 3 + 1] || a[p * 3 + 2] != b[p * 3 + 2];
+}
+
+static void addDiffering(const uint8_t* a, const uint8_t* b, size_t p, std::vector<uint32_t>& differing)
+{
+    // neighbouring 16-byte blocks share a pixel, so it can come up twice in a row
+    if (pixelDiffers(a, b, p) && (differing.empty() || differing.back() != p))
+        differing.push_back((uint32_t)p);
+}
+
+ImageDiff diffImages(const uint8_t* a, const uint8_t* b, size_t n, float tolerance, uint8_t* heat)
+{
+    ImageDiff d;
+    std::vector<uint32_t> differing;
+    size_t bytes = n * 3, i = 0;
+#ifdef RGBPICK_SSE2
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xffff) continue;
+        for (size_t p = i / 3; p <= (i + 15) / 3; ++p)
+            addDiffering(a, b, p, differing);
+    }
+#endif
+    for (size_t p = i / 3; p < n; ++p)
+        addDiffering(a, b, p, differing);
+    d.differing = differing.size();
+
+    if (heat)
+        for (size_t k = 0; k < bytes; ++k)
+            heat[k] = a[k] / 4;
+
+    double sum = 0.0;
+    float labA[3][DIFF_BLOCK], labB[3][DIFF_BLOCK], dE[DIFF_BLOCK];
+    float* const planesA[3] = { labA[0], labA[1], labA[2] };
+    float* const planesB[3] = { labB[0], labB[1], labB[2] };
+    for (size_t first = 0; first < differing.size(); first += DIFF_BLOCK)
+    {
+        size_t m = std::min<size_t>(DIFF_BLOCK, differing.size() - first);
+        for (size_t j = 0; j < m; ++j)
+        {
+            size_t p = differing[first + j] * (size_t)3;
+            for (int k = 0; k < 3; ++k)
+            {
+                // decoded by table, which skips the transfer curve, the costliest stage of sRGB -> Lab
+                labA[k][j] = srgb8ToLinear(a[p + k]);
+                labB[k][j] = srgb8ToLinear(b[p + k]);
+            }
+        }
+        convertColorsBatch(ColorSpace::LinearRGB, ColorSpace::Lab, planesA, planesA, m);
+        convertColorsBatch(ColorSpace::LinearRGB, ColorSpace::Lab, planesB, planesB, m);
+        deltaEPairs(DeltaE::CIEDE2000, planesA, planesB, dE, m);
+        for (size_t j = 0; j < m; ++j)
+        {
+            sum += dE[j];
+            d.maxDeltaE = std::max(d.maxDeltaE, dE[j]);
+            bool beyond = dE[j] > tolerance;
+            d.over += beyond;
+            if (heat)
+            {
+                uint8_t* h = heat + differing[first + j] * (size_t)3;
+                h[0] = 255;
+                h[1] = beyond ? 0 : 200;
+                h[2] = 0;
+            }
+        }
+    }
+    d.meanDeltaE = n ? (float)(sum / n) : 0.0f;
+    return d;
+}
+
+// =======================================================
+// Golden files
+// =======================================================
+
+// fastest deflate level: goldens are written often and only read back here
+static bool writePng(const std::string& path, const uint8_t* rgb, int width, int height)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::GOLDEN::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    bool ok = png && info && !setjmp(png_jmpbuf(png));
+    if (ok)
+    {
+        png_init_io(png, file);
+        png_set_compression_level(png, Z_BEST_SPEED);
+        png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+            PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png, info);
+        for (int y = 0; y < height; ++y)
+            png_write_row(png, rgb + (size_t)y * width * 3);
+        png_write_end(png, nullptr);
+    }
+    if (png) png_destroy_write_struct(&png, info ? &info : nullptr);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) std::cout << "ERROR::GOLDEN::CANNOT_WRITE " << path << std::endl;
+    return ok;
+}
+
+static bool readGolden(const std::string& path, int& width, int& height, std::vector<uint8_t>& rgb)
+{
+    std::unique_ptr<ImageReader> reader = openImage(path);
+    if (!reader) return false;
+    width = reader->width();
+    height = reader->height();
+    rgb.resize((size_t)width * height * 3);
+    for (int y = 0; y < height; ++y)
+        if (!reader->readRow(rgb.data() + (size_t)y * width * 3)) return false;
+    return true;
+}
+
+static void checkCapture(const GoldenOptions& options, GoldenCapture& c)
+{
+    std::filesystem::path base = std::filesystem::path(options.dir) / c.state->name;
+    std::string golden = base.string() + ".png", actual = base.string() + ".actual.png", diff = base.string() + ".diff.png";
+    c.failure.clear();
+    if (options.update)
+    {
+        if (!writePng(golden, c.rgb.data(), c.width, c.height)) c.failure = "golden not written";
+        return;
+    }
+    std::error_code ignored;
+    int width = 0, height = 0;
+    std::vector<uint8_t> expected;
+    if (!std::filesystem::exists(golden))
+        c.failure = "no golden image (--golden-update writes them)";
+    else if (!readGolden(golden, width, height, expected))
+        c.failure = "golden image unreadable";
+    else if (width != c.width || height != c.height)
+    {
+        char line[96];
+        snprintf(line, sizeof(line), "frame is %dx%d, golden %dx%d", c.width, c.height, width, height);
+        c.failure = line;
+    }
+    else
+    {
+        size_t n = (size_t)width * height;
+        c.diff = diffImages(expected.data(), c.rgb.data(), n, options.tolerance);
+        if (c.diff.over > options.maxPixels)
+        {
+            char line[128];
+            snprintf(line, sizeof(line), "%zu pixels beyond dE00 %.2f (max %.2f, %zu differ)", c.diff.over, options.tolerance,
+                c.diff.maxDeltaE, c.diff.differing);
+            c.failure = line;
+            // passing states, the common case, skip the diff image entirely
+            c.heat.resize(n * 3);
+            diffImages(expected.data(), c.rgb.data(), n, options.tolerance, c.heat.data());
+            writePng(diff, c.heat.data(), width, height);
+        }
+    }
+    if (c.failure.empty())
+    {
+        std::filesystem::remove(actual, ignored);
+        std::filesystem::remove(diff, ignored);
+    }
+    else
+        writePng(actual, c.rgb.data(), c.width, c.height);
+}
+
+// =======================================================
+// Runs
+// =======================================================
+
+GoldenRun::GoldenRun(const GoldenOptions& opts) : options(opts)
+{
+    batch.resize(std::max(4u, sharedThreadPool().size() * 2));
+    start = glfwGetTime();
+    std::error_code error;
+    std::filesystem::create_directories(options.dir, error);
+    if (error) std::cout << "ERROR::GOLDEN::CANNOT_CREATE_DIR " << options.dir << std::endl;
+}
+
+void GoldenRun::capture(const GoldenState& state, int width, int height)
+{
+    GoldenCapture& c = batch[pending++];
+    c.state = &state;
+    c.width = width;
+    c.height = height;
+    c.rgb.resize((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, c.rgb.data());
+    // GL rows go bottom up
+    size_t stride = (size_t)width * 3;
+    std::vector<uint8_t> row(stride);
+    for (int y = 0; y < height / 2; ++y)
+    {
+        uint8_t* top = c.rgb.data() + y * stride;
+        uint8_t* bottom = c.rgb.data() + (height - 1 - y) * stride;
+        memcpy(row.data(), top, stride);
+        memcpy(top, bottom, stride);
+        memcpy(bottom, row.data(), stride);
+    }
+    if (pending == batch.size())
+        checkBatch();
+}
+
+void GoldenRun::checkBatch()
+{
+    double compareStart = glfwGetTime();
+    sharedThreadPool().parallelFor(pending, [&](size_t i) { checkCapture(options, batch[i]); });
+    compareSeconds += glfwGetTime() - compareStart;
+    for (size_t i = 0; i < pending; ++i)
+    {
+        const GoldenCapture& c = batch[i];
+        ++checked;
+        if (c.failure.empty()) continue;
+        ++failed;
+        std::cout << "golden FAIL " << c.state->name << ": " << c.failure << std::endl;
+    }
+    pending = 0;
+}
+
+int GoldenRun::finish()
+{
+    checkBatch();
+    printf("golden: %d states %s in %.2f s (%.2f s of it %s)\n", checked, options.update ? "written" : "checked",
+        glfwGetTime() - start, compareSeconds, options.update ? "writing" : "comparing");
+    if (!options.update)
+        printf("golden: %d passed, %d failed (tolerance dE00 %.2f, %zu pixels)\n", checked - failed, failed, options.tolerance,
+            options.maxPixels);
+    return failed;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// =======================================================
+// Golden-image regression check (--golden <dir>)
+// =======================================================
+
+// a picker state and window size to render; the frame loop derives the output color and
+// the alpha marker (triangleYoffset) from it as it does for a pick
+struct GoldenState
+{
+    std::string name;  // file name stem, e.g. "h090_s070_v100_a050_800x800"
+    float hue, saturation, value, alpha;  // picker, all in [0, 1]
+    int width, height;  // window size
+};
+// 8 hues x 3 saturations x 2 values x 3 alphas at 3 window sizes: 432 states
+std::vector<GoldenState> goldenStates();
+
+// per-pixel difference between two RGB8 images
+struct ImageDiff
+{
+    size_t differing = 0;  // pixels that aren't byte-identical
+    size_t over = 0;       // pixels beyond the tolerance
+    float maxDeltaE = 0.0f;
+    float meanDeltaE = 0.0f;  // over all pixels
+};
+// CIEDE2000 between the pixels of a and b (n RGB8 pixels each). Identical bytes are skipped
+// 16 at a time (SSE2); only the pixels that differ are converted to Lab and compared, in SIMD
+// batches. heat (n * 3 bytes, optional) gets a diff image: a dimmed, and red where a pixel is
+// beyond tolerance, yellow where it differs within it
+ImageDiff diffImages(const uint8_t* a, const uint8_t* b, size_t n, float tolerance, uint8_t* heat = nullptr);
+
+struct GoldenOptions
+{
+    std::string dir;          // <dir>/<state>.png
+    bool update = false;      // write the frames as the new goldens instead of checking them
+    float tolerance = 1.0f;   // CIEDE2000 a pixel may differ by
+    size_t maxPixels = 0;     // pixels beyond tolerance a state may have and still pass
+};
+
+// a frame read back for a state, waiting for its check
+struct GoldenCapture
+{
+    const GoldenState* state;
+    int width, height;
+    std::vector<uint8_t> rgb;  // top row first
+    std::vector<uint8_t> heat; // diff image of a failure
+    std::string failure;       // empty if it passed
+    ImageDiff diff;
+};
+
+// Checks the frames of a run against the goldens. Frames are read back as they are rendered
+// and checked a batch at a time on all cores; a failing state leaves <state>.actual.png and
+// <state>.diff.png beside its golden, which a later pass removes
+class GoldenRun
+{
+public:
+    explicit GoldenRun(const GoldenOptions& options);
+    // reads back the framebuffer (before the swap) as the frame of a state
+    void capture(const GoldenState& state, int width, int height);
+    // checks what is left and prints a summary; the number of states that failed
+    int finish();
+
+private:
+    void checkBatch();
+
+    GoldenOptions options;
+    std::vector<GoldenCapture> batch;
+    size_t pending = 0;
+    int checked = 0, failed = 0;
+    double start = 0.0, compareSeconds = 0.0;
+};
@@ -0,0 +1,368 @@
+#include "hue_histogram.hpp"
+#include "shader_manager.hpp"
+#include "color_transfer.hpp"
+#include "oklch_wheel.hpp"
+#include "parallel_for.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+// =======================================================
+// Shaders
+// =======================================================
+
+// one point per pixel, placed at the center of its bin; the conversions match binPosition below
+const char* histogram_scatter_vs = R"(
+#version 330 core
+layout (location = 0) in vec3 color; // sRGB, from the RGB8 tile rows
+
+uniform bool uOklch;
+uniform float uSize;
+uniform float uMaxChroma;
+
+const float PI = 3.14159265;
+
+void main()
+{
+    float hue, saturation;
+    if (uOklch) {
+        vec3 c = mix(color / 12.92, pow((color + 0.055) / 1.055, vec3(2.4)), greaterThan(color, vec3(0.04045)));
+        vec3 lms = vec3(dot(vec3(0.4122214708, 0.5363325363, 0.0514459929), c),
+                        dot(vec3(0.2119034982, 0.6806995451, 0.1073969566), c),
+                        dot(vec3(0.0883024619, 0.2817188376, 0.6299787005), c));
+        lms = pow(max(lms, vec3(0.0)), vec3(1.0 / 3.0));
+        float a = dot(vec3(1.9779984951, -2.4285922050, 0.4505937099), lms);
+        float b = dot(vec3(0.0259040371, 0.7827717662, -0.8086757660), lms);
+        saturation = min(length(vec2(a, b)) / uMaxChroma, 1.0);
+        hue = atan(b, a) / (2.0 * PI);
+        if (hue < 0.0) hue += 1.0;
+    }
+    else {
+        float maxc = max(color.r, max(color.g, color.b));
+        float delta = maxc - min(color.r, min(color.g, color.b));
+        saturation = maxc > 0.0 ? delta / maxc : 0.0;
+        float h = 0.0;
+        if (delta > 0.0) {
+            if (maxc == color.r) h = (color.g - color.b) / delta;
+            else if (maxc == color.g) h = (color.b - color.r) / delta + 2.0;
+            else h = (color.r - color.g) / delta + 4.0;
+        }
+        hue = h < 0.0 ? h / 6.0 + 1.0 : h / 6.0;
+    }
+    // the wheel's layout: hue from the angle (0 at -pi), saturation = distance from the center
+    float angle = hue * 2.0 * PI - PI;
+    vec2 p = saturation * vec2(cos(angle), sin(angle));
+    vec2 bin = min(floor((p + 1.0) * 0.5 * uSize), uSize - 1.0);
+    gl_Position = vec4((bin + 0.5) / uSize * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+const char* histogram_scatter_fs = R"(
+#version 330 core
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0);
+}
+)";
+
+const char* histogram_overlay_vs = R"(
+#version 330 core
+layout (location = 0) in vec2 corner; // [-1, 1]
+out vec2 WheelPos;
+
+uniform float uExtent;
+
+void main()
+{
+    WheelPos = corner;
+    gl_Position = vec4(corner * uExtent, 0.0, 1.0);
+}
+)";
+
+// log-scaled density as black -> red -> yellow -> white, more opaque where it is denser
+const char* histogram_overlay_fs = R"(
+#version 330 core
+in vec2 WheelPos;
+out vec4 FragColor;
+
+uniform sampler2D uHistogram;
+uniform float uPeak;
+uniform bool uLinearOutput;
+
+vec3 srgb_to_linear(vec3 c)
+{
+    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));
+}
+
+void main()
+{
+    if (dot(WheelPos, WheelPos) > 1.0) discard;
+    float count = texture(uHistogram, WheelPos * 0.5 + 0.5).r;
+    if (count < 0.01) discard;
+    float t = clamp(log(1.0 + count) / log(1.0 + uPeak), 0.0, 1.0);
+    vec3 heat = clamp(vec3(3.0 * t, 3.0 * t - 1.0, 3.0 * t - 2.0), 0.0, 1.0);
+    FragColor = vec4(uLinearOutput ? srgb_to_linear(heat) : heat, 0.35 + 0.6 * t);
+}
+)";
+
+// =======================================================
+// Setup
+// =======================================================
+
+void HueHistogram::init(bool forceCpu)
+{
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, HISTOGRAM_SIZE, HISTOGRAM_SIZE, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    useGpu = false;
+    if (!forceCpu)
+    {
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        useGpu = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!useGpu)
+            std::cout << "ERROR::HISTOGRAM::FLOAT_FRAMEBUFFER_INCOMPLETE, counting on the CPU" << std::endl;
+    }
+    if (useGpu)
+    {
+        scatterProgram = createProgram("histogram_scatter", histogram_scatter_vs, histogram_scatter_fs);
+        glGenVertexArrays(1, &pointVAO);
+        glGenBuffers(1, &pointVBO);
+        glBindVertexArray(pointVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, pointVBO);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_BYTE, GL_TRUE, 3, (void*)0);
+        glEnableVertexAttribArray(0);
+    }
+
+    overlayProgram = createProgram("histogram_overlay", histogram_overlay_vs, histogram_overlay_fs);
+    const float corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+    glGenVertexArrays(1, &overlayVAO);
+    glGenBuffers(1, &overlayVBO);
+    glBindVertexArray(overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, overlayVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    reset();
+}
+
+void HueHistogram::reset()
+{
+    // the texture is cleared by the next update, which runs with the GL context current
+    clearPending = true;
+    level = -1;
+    rowsBinned = 0;
+    total = 0;
+}
+
+// =======================================================
+// Binning
+// =======================================================
+
+// the bin of an sRGB8 pixel; the same mapping as histogram_scatter_vs
+static int binIndex(const unsigned char* rgb, bool oklch)
+{
+    const float PI = 3.14159265f;
+    float hue, saturation;
+    if (oklch)
+    {
+        float r = srgb8ToLinear(rgb[0]), g = srgb8ToLinear(rgb[1]), b = srgb8ToLinear(rgb[2]);
+        float l = std::cbrt(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+        float m = std::cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+        float s = std::cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+        float A = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+        float B = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+        saturation = std::min(std::sqrt(A * A + B * B) / OKLCH_MAX_CHROMA, 1.0f);
+        hue = std::atan2(B, A) / (2.0f * PI);
+        if (hue < 0.0f) hue += 1.0f;
+    }
+    else
+    {
+        float r = rgb[0] / 255.0f, g = rgb[1] / 255.0f, b = rgb[2] / 255.0f;
+        float maxc = std::max(r, std::max(g, b));
+        float delta = maxc - std::min(r, std::min(g, b));
+        saturation = maxc > 0.0f ? delta / maxc : 0.0f;
+        float h = 0.0f;
+        if (delta > 0.0f)
+        {
+            if (maxc == r) h = (g - b) / delta;
+            else if (maxc == g) h = (b - r) / delta + 2.0f;
+            else h = (r - g) / delta + 4.0f;
+        }
+        hue = h < 0.0f ? h / 6.0f + 1.0f : h / 6.0f;
+    }
+    float angle = hue * 2.0f * PI - PI;
+    float x = saturation * std::cos(angle), y = saturation * std::sin(angle);
+    int bx = std::min((int)std::floor((x + 1.0f) * 0.5f * HISTOGRAM_SIZE), HISTOGRAM_SIZE - 1);
+    int by = std::min((int)std::floor((y + 1.0f) * 0.5f * HISTOGRAM_SIZE), HISTOGRAM_SIZE - 1);
+    return by * HISTOGRAM_SIZE + bx;
+}
+
+void HueHistogram::scatterRows(const ImagePyramid& image, int y0, int y1)
+{
+    // rows y0..y1 lie in one tile row; each tile's part is contiguous except for the padding
+    // columns of the last tile, which are left out row by row
+    const int S = PYRAMID_TILE_SIZE;
+    const PyramidLevel& lv = image.level(level);
+    int ty = y0 / S, rows = y1 - y0;
+    size_t pixels = (size_t)lv.width * rows;
+    glBufferData(GL_ARRAY_BUFFER, pixels * 3, nullptr, GL_STREAM_DRAW);
+    size_t offset = 0;
+    for (int tx = 0; tx < (int)lv.tilesX; ++tx)
+    {
+        const unsigned char* tile = image.tile(level, tx, ty) + (size_t)(y0 - ty * S) * S * 3;
+        int tileW = std::min(S, (int)lv.width - tx * S);
+        if (tileW == S)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, offset, (size_t)rows * S * 3, tile);
+            offset += (size_t)rows * S * 3;
+        }
+        else
+            for (int r = 0; r < rows; ++r)
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, offset, (size_t)tileW * 3, tile + (size_t)r * S * 3);
+                offset += (size_t)tileW * 3;
+            }
+    }
+    glDrawArrays(GL_POINTS, 0, (GLsizei)pixels);
+}
+
+void HueHistogram::countRows(const ImagePyramid& image, int y0, int y1)
+{
+    const int S = PYRAMID_TILE_SIZE;
+    const PyramidLevel& lv = image.level(level);
+    int ty = y0 / S;
+    // one stripe of the rows per pool thread, counted into that stripe's own histogram; no
+    // two threads share one, so they need neither a lock nor clearing
+    size_t stripes = stripeCounts.size(), rows = (size_t)(y1 - y0);
+    sharedThreadPool().parallelFor(stripes, [&](size_t k) {
+        std::vector<float>& local = stripeCounts[k];
+        for (size_t r = rows * k / stripes; r < rows * (k + 1) / stripes; ++r)
+            for (int tx = 0; tx < (int)lv.tilesX; ++tx)
+            {
+                const unsigned char* row = image.tile(level, tx, ty) + (y0 + r - ty * S) * S * 3;
+                int tileW = std::min(S, (int)lv.width - tx * S);
+                for (int x = 0; x < tileW; ++x)
+                    local[binIndex(row + x * 3, binnedOklch)] += 1.0f;
+            }
+    });
+}
+
+size_t HueHistogram::update(const ImagePyramid& image, bool oklch, int framebufferWidth, int framebufferHeight, double budgetSeconds)
+{
+    if (!image.isOpen()) return 0;
+    if (oklch != binnedOklch || level < 0)
+    {
+        reset();
+        binnedOklch = oklch;
+        level = 0;
+        while (level + 1 < image.levels() && (size_t)image.level(level).width * image.level(level).height > HISTOGRAM_MAX_SAMPLES)
+            ++level;
+    }
+    if (clearPending)
+    {
+        if (useGpu)
+        {
+            const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glClearBufferfv(GL_COLOR, 0, zero);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        else
+        {
+            counts.assign(HISTOGRAM_SIZE * HISTOGRAM_SIZE, 0.0f);
+            stripeCounts.assign(sharedThreadPool().size(), counts);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, HISTOGRAM_SIZE, HISTOGRAM_SIZE, GL_RED, GL_FLOAT, counts.data());
+        }
+        clearPending = false;
+    }
+
+    int available = image.rowsDone(level);
+    if (rowsBinned >= available) return 0;
+    const PyramidLevel& lv = image.level(level);
+    if (useGpu)
+    {
+        // additive point scatter; the blend function goes back to the UI's afterwards
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, HISTOGRAM_SIZE, HISTOGRAM_SIZE);
+        glBlendFunc(GL_ONE, GL_ONE);
+        GLuint program = finishProgram(scatterProgram);
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "uOklch"), binnedOklch);
+        glUniform1f(glGetUniformLocation(program, "uSize"), (float)HISTOGRAM_SIZE);
+        glUniform1f(glGetUniformLocation(program, "uMaxChroma"), OKLCH_MAX_CHROMA);
+        glBindVertexArray(pointVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, pointVBO);
+    }
+
+    double deadline = glfwGetTime() + budgetSeconds;
+    size_t binned = 0;
+    while (rowsBinned < available && glfwGetTime() < deadline)
+    {
+        int y0 = rowsBinned;
+        int y1 = std::min({ available, y0 + HISTOGRAM_CHUNK_ROWS, (y0 / PYRAMID_TILE_SIZE + 1) * PYRAMID_TILE_SIZE });
+        if (useGpu) scatterRows(image, y0, y1);
+        else countRows(image, y0, y1);
+        binned += (size_t)lv.width * (y1 - y0);
+        rowsBinned = y1;
+    }
+    total += binned;
+
+    if (useGpu)
+    {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+    }
+    else
+    {
+        // the stripes' histograms are summed once per update, not per chunk
+        parallelRanges(counts.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                float sum = 0.0f;
+                for (const std::vector<float>& local : stripeCounts)
+                    sum += local[i];
+                counts[i] = sum;
+            }
+        });
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, HISTOGRAM_SIZE, HISTOGRAM_SIZE, GL_RED, GL_FLOAT, counts.data());
+    }
+    return binned;
+}
+
+// =======================================================
+// Overlay
+// =======================================================
+
+void HueHistogram::draw(float extent, bool linearOutput)
+{
+    if (total == 0) return;
+    GLuint program = finishProgram(overlayProgram);
+    glUseProgram(program);
+    glUniform1f(glGetUniformLocation(program, "uExtent"), extent);
+    // a bin holding 1/256 of the pixels is drawn at full strength
+    glUniform1f(glGetUniformLocation(program, "uPeak"), std::max(1.0f, total / 256.0f));
+    glUniform1i(glGetUniformLocation(program, "uLinearOutput"), linearOutput);
+    glUniform1i(glGetUniformLocation(program, "uHistogram"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindVertexArray(overlayVAO);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "image_pyramid.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// =======================================================
+// Hue/saturation histogram of an image, drawn over the wheel
+// =======================================================
+
+// bins per side; the histogram covers the wheel's bounding square, [-1, 1] in wheel units
+#define HISTOGRAM_SIZE 256
+// pixels binned at most: the histogram reads the finest pyramid level with no more than this
+#define HISTOGRAM_MAX_SAMPLES (1 << 22)
+// level rows binned per step; update() checks its time budget between steps
+#define HISTOGRAM_CHUNK_ROWS 32
+
+// Where an image's pixels would be picked on the wheel, as a density map. Each pixel's hue and
+// saturation (HSV, or OKLCH hue and chroma for the OKLCH wheel) give a wheel position, and the
+// bin there counts it.
+//
+// On the GPU the pixels are scattered as points straight from the pyramid tiles into a float
+// framebuffer with additive blending; the vertex shader does the color conversion. Where
+// float framebuffers aren't renderable (or with forceCpu) the bins are counted on all cores
+// and the texture is uploaded instead. Either way binning is incremental: every update only
+// adds the pyramid rows that were finished since the last one.
+class HueHistogram
+{
+public:
+    // creates the histogram texture and the point program; call once with a current GL context
+    void init(bool forceCpu);
+    // forgets all counts, e.g. when another image is loaded
+    void reset();
+
+    // bins newly finished rows of the image until budgetSeconds have passed, restarting when
+    // the wheel layout changed. Renders off screen on the GPU path, so it takes the framebuffer
+    // size to restore the viewport. Returns the number of pixels binned
+    size_t update(const ImagePyramid& image, bool oklch, int framebufferWidth, int framebufferHeight, double budgetSeconds);
+    // the heatmap over a wheel of radius extent (NDC), blended over what is there
+    void draw(float extent, bool linearOutput);
+
+    bool gpu() const { return useGpu; }
+    size_t binned() const { return total; }
+
+private:
+    void scatterRows(const ImagePyramid& image, int y0, int y1);
+    void countRows(const ImagePyramid& image, int y0, int y1);
+
+    bool useGpu = false;
+    GLuint texture = 0, fbo = 0;
+    GLuint pointVAO = 0, pointVBO = 0;
+    GLuint scatterProgram = 0, overlayProgram = 0;
+    GLuint overlayVAO = 0, overlayVBO = 0;
+
+    bool clearPending = true;
+    bool binnedOklch = false;
+    int level = -1;      // pyramid level being binned
+    int rowsBinned = 0;  // of that level
+    size_t total = 0;
+    std::vector<float> counts;  // CPU path
+    std::vector<std::vector<float>> stripeCounts;  // CPU path: one histogram per pool thread, summed into counts
+};
@@ -0,0 +1,272 @@
+#include "image_loader.hpp"
+
+#include <png.h>
+#include <jpeglib.h>
+
+#include <cctype>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// =======================================================
+// PNG (libpng, sequential row reads)
+// =======================================================
+
+class PngReader : public ImageReader
+{
+public:
+    ~PngReader()
+    {
+        if (png) png_destroy_read_struct(&png, info ? &info : nullptr, nullptr);
+        if (file) fclose(file);
+    }
+
+    bool open(FILE* f)
+    {
+        file = f;
+        png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        if (!png) return false;
+        info = png_create_info_struct(png);
+        if (!info) return false;
+        if (setjmp(png_jmpbuf(png))) return false;
+
+        png_init_io(png, file);
+        png_read_info(png, info);
+        w = (int)png_get_image_width(png, info);
+        h = (int)png_get_image_height(png, info);
+        // everything becomes 8-bit RGB: expand palette/low-bit gray, drop 16-bit precision and alpha
+        png_set_expand(png);
+        png_set_strip_16(png);
+        png_set_strip_alpha(png);
+        png_set_gray_to_rgb(png);
+        int passes = png_set_interlace_handling(png);
+        png_read_update_info(png, info);
+
+        if (passes > 1)
+        {
+            // Adam7 rows are only final after the last pass
+            whole.resize((size_t)w * h * 3);
+            std::vector<png_bytep> rows(h);
+            for (int y = 0; y < h; ++y)
+                rows[y] = &whole[(size_t)y * w * 3];
+            png_read_image(png, rows.data());
+        }
+        return true;
+    }
+
+    bool readRow(unsigned char* rgb) override
+    {
+        if (row >= h) return false;
+        if (!whole.empty())
+        {
+            memcpy(rgb, &whole[(size_t)row++ * w * 3], (size_t)w * 3);
+            return true;
+        }
+        if (setjmp(png_jmpbuf(png))) return false;
+        png_read_row(png, rgb, nullptr);
+        ++row;
+        return true;
+    }
+
+private:
+    FILE* file = nullptr;
+    png_structp png = nullptr;
+    png_infop info = nullptr;
+    int row = 0;
+    std::vector<unsigned char> whole;
+};
+
+// =======================================================
+// JPEG (libjpeg scanlines)
+// =======================================================
+
+// libjpeg reports fatal errors through error_exit; jump back instead of exiting
+struct JpegError
+{
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+static void jpegErrorExit(j_common_ptr cinfo)
+{
+    char message[JMSG_LENGTH_MAX];
+    cinfo->err->format_message(cinfo, message);
+    std::cout << "ERROR::IMAGE::JPEG " << message << std::endl;
+    longjmp(((JpegError*)cinfo->err)->jump, 1);
+}
+
+class JpegReader : public ImageReader
+{
+public:
+    ~JpegReader()
+    {
+        if (created) jpeg_destroy_decompress(&cinfo);
+        if (file) fclose(file);
+    }
+
+    bool open(FILE* f)
+    {
+        file = f;
+        cinfo.err = jpeg_std_error(&error.mgr);
+        error.mgr.error_exit = jpegErrorExit;
+        if (setjmp(error.jump)) return false;
+
+        jpeg_create_decompress(&cinfo);
+        created = true;
+        jpeg_stdio_src(&cinfo, file);
+        jpeg_read_header(&cinfo, TRUE);
+        if (cinfo.jpeg_color_space != JCS_GRAYSCALE && cinfo.jpeg_color_space != JCS_YCbCr && cinfo.jpeg_color_space != JCS_RGB)
+        {
+            std::cout << "ERROR::IMAGE::JPEG_COLOR_SPACE_UNSUPPORTED (CMYK/YCCK)" << std::endl;
+            return false;
+        }
+        cinfo.out_color_space = JCS_RGB;
+        jpeg_start_decompress(&cinfo);
+        w = (int)cinfo.output_width;
+        h = (int)cinfo.output_height;
+        return true;
+    }
+
+    bool readRow(unsigned char* rgb) override
+    {
+        if ((int)cinfo.output_scanline >= h) return false;
+        if (setjmp(error.jump)) return false;
+        JSAMPROW rows[1] = { rgb };
+        return jpeg_read_scanlines(&cinfo, rows, 1) == 1;
+    }
+
+private:
+    FILE* file = nullptr;
+    jpeg_decompress_struct cinfo;
+    JpegError error;
+    bool created = false;
+};
+
+// =======================================================
+// PPM (P6 binary, P3 text; maxval up to 65535)
+// =======================================================
+
+class PpmReader : public ImageReader
+{
+public:
+    ~PpmReader()
+    {
+        if (file) fclose(file);
+    }
+
+    bool open(FILE* f)
+    {
+        file = f;
+        char magic[2];
+        if (fread(magic, 1, 2, file) != 2 || magic[0] != 'P' || (magic[1] != '6' && magic[1] != '3'))
+            return false;
+        binary = magic[1] == '6';
+        if (!readNumber(w) || !readNumber(h) || !readNumber(maxValue) || w <= 0 || h <= 0 || maxValue <= 0 || maxValue > 65535)
+            return false;
+        // readNumber consumed the single whitespace byte that ends the header
+        sampleBytes = maxValue > 255 ? 2 : 1;
+        return true;
+    }
+
+    bool readRow(unsigned char* rgb) override
+    {
+        if (row >= h) return false;
+        ++row;
+        size_t samples = (size_t)w * 3;
+        if (!binary)
+        {
+            for (size_t i = 0; i < samples; ++i)
+            {
+                int v;
+                if (!readNumber(v)) return false;
+                rgb[i] = scale(v);
+            }
+            return true;
+        }
+        if (sampleBytes == 1 && maxValue == 255)
+            return fread(rgb, 1, samples, file) == samples;
+        raw.resize(samples * sampleBytes);
+        if (fread(raw.data(), 1, raw.size(), file) != raw.size()) return false;
+        for (size_t i = 0; i < samples; ++i)
+            rgb[i] = scale(sampleBytes == 2 ? raw[2 * i] << 8 | raw[2 * i + 1] : raw[i]);
+        return true;
+    }
+
+private:
+    // next decimal number, skipping whitespace and '#' comments
+    bool readNumber(int& value)
+    {
+        int c = fgetc(file);
+        while (c != EOF && (isspace(c) || c == '#'))
+        {
+            if (c == '#')
+                while (c != EOF && c != '\n') c = fgetc(file);
+            c = fgetc(file);
+        }
+        if (c == EOF || !isdigit(c)) return false;
+        value = 0;
+        while (c != EOF && isdigit(c))
+        {
+            value = value * 10 + (c - '0');
+            c = fgetc(file);
+        }
+        return true;
+    }
+
+    unsigned char scale(int v) const
+    {
+        if (v > maxValue) v = maxValue;
+        return (unsigned char)((v * 255 + maxValue / 2) / maxValue);
+    }
+
+    FILE* file = nullptr;
+    bool binary = true;
+    int maxValue = 255;
+    int sampleBytes = 1;
+    int row = 0;
+    std::vector<unsigned char> raw;
+};
+
+// =======================================================
+// Format detection
+// =======================================================
+
+std::unique_ptr<ImageReader> openImage(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        std::cout << "ERROR::IMAGE::FILE_NOT_READ " << path << std::endl;
+        return nullptr;
+    }
+    unsigned char magic[8] = {};
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    rewind(file);
+
+    if (got == 8 && png_sig_cmp(magic, 0, 8) == 0)
+    {
+        std::unique_ptr<PngReader> reader(new PngReader());
+        if (reader->open(file)) return reader;
+    }
+    else if (got >= 3 && magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF)
+    {
+        std::unique_ptr<JpegReader> reader(new JpegReader());
+        if (reader->open(file)) return reader;
+    }
+    else if (got >= 2 && magic[0] == 'P' && (magic[1] == '6' || magic[1] == '3'))
+    {
+        std::unique_ptr<PpmReader> reader(new PpmReader());
+        if (reader->open(file)) return reader;
+    }
+    else
+    {
+        fclose(file);
+        std::cout << "ERROR::IMAGE::FORMAT_UNSUPPORTED " << path << std::endl;
+        return nullptr;
+    }
+    // the reader owns (and has closed) the file
+    std::cout << "ERROR::IMAGE::HEADER_INVALID " << path << std::endl;
+    return nullptr;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// =======================================================
+// Row-streaming image decoding (PNG, JPEG, PPM)
+// =======================================================
+
+// Decodes an image top to bottom, one row at a time, as 8-bit sRGB triples; only the
+// decoder's own state is held in memory, so arbitrarily tall images can be streamed.
+// PNG goes through libpng (16-bit and palette images are reduced to 8-bit RGB, alpha is
+// dropped), JPEG through libjpeg (grayscale and RGB), PPM is P3/P6 with any maxval.
+// Interlaced PNGs are the exception: they are decoded whole on open and then served by row.
+class ImageReader
+{
+public:
+    virtual ~ImageReader() {}
+
+    int width() const { return w; }
+    int height() const { return h; }
+    // decodes the next row into rgb (width() * 3 bytes); false on a decode error or past
+    // the last row
+    virtual bool readRow(unsigned char* rgb) = 0;
+
+protected:
+    int w = 0, h = 0;
+};
+
+// opens the file and reads its header; the format is detected from the first bytes.
+// Returns nullptr (after printing the error) for unreadable or unsupported files
+std::unique_ptr<ImageReader> openImage(const std::string& path);
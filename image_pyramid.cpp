@@ -0,0 +1,325 @@
+#include "image_pyramid.hpp"
+#include "color_transfer.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// =======================================================
+// File layout
+// =======================================================
+
+// the first page of the file; the levels' tiles follow, each level starting on a tile boundary
+struct PyramidHeader
+{
+    char magic[8];        // "RGBPYR1"
+    uint32_t tileSize;
+    uint32_t levels;
+    uint64_t sourceSize;  // size and modification time of the image it was built from
+    int64_t sourceTime;
+    uint32_t complete;    // set last, once every tile is on disk
+    uint32_t reserved;
+    PyramidLevel level[PYRAMID_MAX_LEVELS];
+};
+
+static const size_t HEADER_BYTES = 4096;
+static_assert(sizeof(PyramidHeader) <= HEADER_BYTES, "pyramid header must fit its page");
+static_assert(PYRAMID_TILE_BYTES % 4096 == 0, "tiles must stay page aligned");
+
+static uint64_t fnv1a(const std::string& s)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : s)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// levels halve (rounding up) until one fits a single tile
+static int planLevels(int width, int height, PyramidLevel* levels)
+{
+    uint64_t offset = HEADER_BYTES;
+    int count = 0;
+    for (;;)
+    {
+        PyramidLevel& lv = levels[count++];
+        lv.width = width;
+        lv.height = height;
+        lv.tilesX = (width + PYRAMID_TILE_SIZE - 1) / PYRAMID_TILE_SIZE;
+        lv.tilesY = (height + PYRAMID_TILE_SIZE - 1) / PYRAMID_TILE_SIZE;
+        lv.offset = offset;
+        offset += (uint64_t)lv.tilesX * lv.tilesY * PYRAMID_TILE_BYTES;
+        if ((width <= PYRAMID_TILE_SIZE && height <= PYRAMID_TILE_SIZE) || count == PYRAMID_MAX_LEVELS)
+            return count;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+}
+
+// =======================================================
+// Opening: reuse the cache or start a build
+// =======================================================
+
+ImagePyramid::~ImagePyramid()
+{
+    close();
+}
+
+void ImagePyramid::close()
+{
+    cancel = true;
+    if (worker.joinable()) worker.join();
+    cancel = false;
+    if (data) munmap(data, mappedSize);
+    data = nullptr;
+    header = nullptr;
+    mappedSize = 0;
+    levelCount = 0;
+    cached = false;
+}
+
+bool ImagePyramid::open(const std::string& path, const std::string& cacheDir)
+{
+    close();
+    struct stat source;
+    if (stat(path.c_str(), &source) != 0)
+    {
+        std::cout << "ERROR::IMAGE::FILE_NOT_READ " << path << std::endl;
+        return false;
+    }
+
+    // the cache file name is a hash of the absolute path; size and time are checked inside
+    std::string cacheFile;
+    if (!cacheDir.empty())
+    {
+        char* absolute = realpath(path.c_str(), nullptr);
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)fnv1a(absolute ? absolute : path));
+        free(absolute);
+        cacheFile = cacheDir + "/" + hex + ".pyr";
+
+        int fd = ::open(cacheFile.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            PyramidHeader stored;
+            struct stat st;
+            bool valid = pread(fd, &stored, sizeof(stored), 0) == (ssize_t)sizeof(stored) && fstat(fd, &st) == 0 &&
+                memcmp(stored.magic, "RGBPYR1", 8) == 0 && stored.tileSize == PYRAMID_TILE_SIZE && stored.complete &&
+                stored.sourceSize == (uint64_t)source.st_size && stored.sourceTime == (int64_t)source.st_mtime &&
+                stored.levels > 0 && stored.levels <= PYRAMID_MAX_LEVELS;
+            if (valid)
+            {
+                const PyramidLevel& last = stored.level[stored.levels - 1];
+                mappedSize = last.offset + (size_t)last.tilesX * last.tilesY * PYRAMID_TILE_BYTES;
+                valid = (size_t)st.st_size == mappedSize;
+            }
+            if (valid)
+            {
+                void* mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+                if (mapped != MAP_FAILED)
+                {
+                    data = (unsigned char*)mapped;
+                    header = (PyramidHeader*)data;
+                    levelCount = (int)stored.levels;
+                    for (int l = 0; l < levelCount; ++l)
+                    {
+                        levelInfo[l] = stored.level[l];
+                        done[l].store((int)levelInfo[l].height);
+                    }
+                    cached = true;
+                }
+            }
+            ::close(fd);
+            if (cached) return true;
+        }
+    }
+
+    std::unique_ptr<ImageReader> reader = openImage(path);
+    if (!reader) return false;
+    levelCount = planLevels(reader->width(), reader->height(), levelInfo);
+    const PyramidLevel& last = levelInfo[levelCount - 1];
+    mappedSize = last.offset + (size_t)last.tilesX * last.tilesY * PYRAMID_TILE_BYTES;
+
+    void* mapped = MAP_FAILED;
+    fileBacked = false;
+    if (!cacheFile.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        int fd = ::open(cacheFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0 && ftruncate(fd, (off_t)mappedSize) == 0)
+            mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (fd >= 0) ::close(fd);
+        if (mapped == MAP_FAILED)
+            std::cout << "image cache: cannot write " << cacheFile << ", keeping the pyramid in memory" << std::endl;
+        fileBacked = mapped != MAP_FAILED;
+    }
+    if (mapped == MAP_FAILED)
+        mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapped == MAP_FAILED)
+    {
+        std::cout << "ERROR::IMAGE::PYRAMID_ALLOCATION_FAILED (" << mappedSize / (1024 * 1024) << " MB)" << std::endl;
+        levelCount = 0;
+        return false;
+    }
+
+    data = (unsigned char*)mapped;
+    header = (PyramidHeader*)data;
+    memset(header, 0, sizeof(PyramidHeader));
+    memcpy(header->magic, "RGBPYR1", 8);
+    header->tileSize = PYRAMID_TILE_SIZE;
+    header->levels = (uint32_t)levelCount;
+    header->sourceSize = (uint64_t)source.st_size;
+    header->sourceTime = (int64_t)source.st_mtime;
+    for (int l = 0; l < levelCount; ++l)
+    {
+        header->level[l] = levelInfo[l];
+        done[l].store(0);
+    }
+    worker = std::thread(&ImagePyramid::build, this, std::move(reader));
+    return true;
+}
+
+// =======================================================
+// Background build
+// =======================================================
+
+void ImagePyramid::downsampleRow(int l, int y)
+{
+    const PyramidLevel& src = levelInfo[l - 1];
+    const PyramidLevel& dst = levelInfo[l];
+    int ya = 2 * y, yb = std::min(2 * y + 1, (int)src.height - 1);
+    for (int x = 0; x < (int)dst.width; ++x)
+    {
+        int xa = 2 * x, xb = std::min(2 * x + 1, (int)src.width - 1);
+        const unsigned char* p00 = pixelAddress(l - 1, xa, ya);
+        const unsigned char* p01 = pixelAddress(l - 1, xb, ya);
+        const unsigned char* p10 = pixelAddress(l - 1, xa, yb);
+        const unsigned char* p11 = pixelAddress(l - 1, xb, yb);
+        unsigned char* out = pixelAddress(l, x, y);
+        for (int c = 0; c < 3; ++c)
+            out[c] = linearToSrgb8(0.25f * (srgb8ToLinear(p00[c]) + srgb8ToLinear(p01[c]) + srgb8ToLinear(p10[c]) + srgb8ToLinear(p11[c])));
+    }
+    // pad the last tile column by repeating the last pixel
+    const unsigned char* edge = pixelAddress(l, dst.width - 1, y);
+    for (int x = dst.width; x < (int)dst.tilesX * PYRAMID_TILE_SIZE; ++x)
+        memcpy(pixelAddress(l, x, y), edge, 3);
+}
+
+void ImagePyramid::padRows(int l, int from)
+{
+    const PyramidLevel& lv = levelInfo[l];
+    for (int y = from; y < (int)lv.tilesY * PYRAMID_TILE_SIZE; ++y)
+        for (int tx = 0; tx < (int)lv.tilesX; ++tx)
+            memcpy(pixelAddress(l, tx * PYRAMID_TILE_SIZE, y), pixelAddress(l, tx * PYRAMID_TILE_SIZE, from - 1), PYRAMID_TILE_SIZE * 3);
+}
+
+void ImagePyramid::releaseRows(int l, int from, int to)
+{
+    // whole tile rows only; the pages stay in the file and fault back in when read
+    const PyramidLevel& lv = levelInfo[l];
+    size_t rowBytes = (size_t)lv.tilesX * PYRAMID_TILE_BYTES;
+    int first = from / PYRAMID_TILE_SIZE, last = to / PYRAMID_TILE_SIZE;
+    if (last > first)
+        madvise(data + lv.offset + first * rowBytes, (last - first) * rowBytes, MADV_DONTNEED);
+}
+
+void ImagePyramid::build(std::unique_ptr<ImageReader> reader)
+{
+    const int S = PYRAMID_TILE_SIZE;
+    const PyramidLevel& base = levelInfo[0];
+    const int w = base.width, h = base.height;
+    std::vector<unsigned char> row((size_t)w * 3);
+    // rows of each level the build no longer needs (consumed by the next level)
+    int released[PYRAMID_MAX_LEVELS] = {};
+
+    for (int y0 = 0; y0 < h && !cancel; y0 += S)
+    {
+        // decode one band (a tile row) straight into the mapped tiles
+        int y1 = std::min(h, y0 + S), y = y0;
+        for (; y < y1; ++y)
+        {
+            if (!reader->readRow(row.data())) break;
+            for (int tx = 0; tx < (int)base.tilesX; ++tx)
+            {
+                int n = std::min(S, w - tx * S);
+                unsigned char* out = pixelAddress(0, tx * S, y);
+                memcpy(out, &row[(size_t)tx * S * 3], (size_t)n * 3);
+                for (int x = n; x < S; ++x)
+                    memcpy(out + x * 3, out + (n - 1) * 3, 3);
+            }
+        }
+        if (y < y1)
+        {
+            std::cout << "ERROR::IMAGE::DECODE_FAILED at row " << y << std::endl;
+            return;
+        }
+        if (y1 == h) padRows(0, h);
+        done[0].store(y1, std::memory_order_release);
+
+        // coarser levels: every new row whose two source rows are final, spread over the pool
+        for (int l = 1; l < levelCount; ++l)
+        {
+            int srcDone = done[l - 1].load(std::memory_order_relaxed);
+            int target = srcDone == (int)levelInfo[l - 1].height ? (int)levelInfo[l].height : srcDone / 2;
+            int from = done[l].load(std::memory_order_relaxed);
+            if (target <= from) break;
+            pool.parallelFor(target - from, [&](size_t i) { downsampleRow(l, from + (int)i); });
+            if (target == (int)levelInfo[l].height) padRows(l, target);
+            done[l].store(target, std::memory_order_release);
+        }
+
+        if (fileBacked)
+            for (int l = 0; l + 1 < levelCount; ++l)
+            {
+                int consumed = std::min((int)levelInfo[l].height, 2 * done[l + 1].load(std::memory_order_relaxed));
+                releaseRows(l, released[l], consumed);
+                released[l] = consumed / S * S;
+            }
+    }
+    if (cancel) return;
+
+    // tiles first, then the flag that makes the file a valid cache
+    if (fileBacked)
+    {
+        msync(data, mappedSize, MS_SYNC);
+        header->complete = 1;
+        msync(data, HEADER_BYTES, MS_SYNC);
+    }
+}
+
+// =======================================================
+// Queries
+// =======================================================
+
+float ImagePyramid::progress() const
+{
+    double total = 0.0, finished = 0.0;
+    for (int l = 0; l < levelCount; ++l)
+    {
+        total += levelInfo[l].height;
+        finished += rowsDone(l);
+    }
+    return total > 0.0 ? (float)(finished / total) : 0.0f;
+}
+
+bool ImagePyramid::pixel(int x, int y, glm::vec3& rgb) const
+{
+    if (!levelCount || x < 0 || y < 0 || x >= width() || y >= height() || y >= rowsDone(0))
+        return false;
+    const unsigned char* p = pixelAddress(0, x, y);
+    rgb = glm::vec3(p[0] / 255.0f, p[1] / 255.0f, p[2] / 255.0f);
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "image_loader.hpp"
+#include "thread_pool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// =======================================================
+// Tiled mip pyramid, cached on disk as a memory-mapped file
+// =======================================================
+
+// tile edge in pixels; a tile (RGB8, always full size) is 192 KB, a whole number of pages
+#define PYRAMID_TILE_SIZE 256
+#define PYRAMID_TILE_BYTES (PYRAMID_TILE_SIZE * PYRAMID_TILE_SIZE * 3)
+#define PYRAMID_MAX_LEVELS 24
+
+struct PyramidHeader;
+
+// one level of the pyramid, as stored in the file header
+struct PyramidLevel
+{
+    uint32_t width, height;
+    uint32_t tilesX, tilesY;
+    uint64_t offset;  // byte offset of the level's first tile; tiles follow row by row
+};
+
+// An image as a pyramid of 2x2 box-filtered (linear light) levels, down to one that fits a
+// single tile, stored as tiles in one file that is mapped into memory. Tiles at the image's
+// right and bottom edge are padded by repeating the last column/row, so sampling them
+// clamps at the border.
+//
+// The first time an image is opened, a worker thread decodes it band by band (one tile row)
+// straight into the mapped file and the shared pool builds the coarser levels' new rows after each
+// band; level rows become readable as they finish. Bands already consumed are dropped from
+// the mapping, so memory use stays bounded however large the image. The finished file is
+// keyed by the image's path, size and modification time and reused on later runs.
+class ImagePyramid
+{
+public:
+    ~ImagePyramid();
+
+    // maps the cached pyramid of the image, or creates it and starts building; cacheDir empty
+    // keeps the pyramid in anonymous memory instead. False when the image can't be read
+    bool open(const std::string& path, const std::string& cacheDir);
+    // stops a running build and unmaps the file
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    bool fromCache() const { return cached; }
+    int width() const { return levelCount ? (int)levelInfo[0].width : 0; }
+    int height() const { return levelCount ? (int)levelInfo[0].height : 0; }
+    int levels() const { return levelCount; }
+    const PyramidLevel& level(int l) const { return levelInfo[l]; }
+    // rows of level l that are final; readers may use rows below this
+    int rowsDone(int l) const { return done[l].load(std::memory_order_acquire); }
+    // fraction of the pyramid built (all levels, weighted by their rows)
+    float progress() const;
+
+    // the tile's pixels: PYRAMID_TILE_SIZE rows of PYRAMID_TILE_SIZE RGB8 pixels
+    const unsigned char* tile(int l, int tx, int ty) const
+    {
+        const PyramidLevel& lv = levelInfo[l];
+        return data + lv.offset + ((size_t)ty * lv.tilesX + tx) * PYRAMID_TILE_BYTES;
+    }
+    // sRGB color of a full-resolution pixel; false outside the image or before its row is built
+    bool pixel(int x, int y, glm::vec3& rgb) const;
+
+private:
+    unsigned char* pixelAddress(int l, int x, int y) const
+    {
+        const PyramidLevel& lv = levelInfo[l];
+        size_t tileIndex = (size_t)(y / PYRAMID_TILE_SIZE) * lv.tilesX + x / PYRAMID_TILE_SIZE;
+        return data + lv.offset + tileIndex * PYRAMID_TILE_BYTES
+            + ((size_t)(y % PYRAMID_TILE_SIZE) * PYRAMID_TILE_SIZE + x % PYRAMID_TILE_SIZE) * 3;
+    }
+    void build(std::unique_ptr<ImageReader> reader);
+    void downsampleRow(int l, int y);
+    void padRows(int l, int from);
+    void releaseRows(int l, int from, int to);
+
+    unsigned char* data = nullptr;
+    size_t mappedSize = 0;
+    bool cached = false;
+    bool fileBacked = false;  // a cache file rather than anonymous memory
+    PyramidHeader* header = nullptr;
+    int levelCount = 0;
+    PyramidLevel levelInfo[PYRAMID_MAX_LEVELS];
+    std::atomic<int> done[PYRAMID_MAX_LEVELS];
+
+    std::thread worker;
+    std::atomic<bool> cancel{ false };
+    // bound here so the pool is created before, and outlives, a global pyramid
+    ThreadPool& pool = sharedThreadPool();
+};
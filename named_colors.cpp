@@ -0,0 +1,440 @@
+#include "named_colors.hpp"
+#include "simd_math.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+// =======================================================
+// Palettes
+// =======================================================
+
+static const struct { const char* name; unsigned int hex; } CSS_COLORS[] = {
+    { "aliceblue", 0xf0f8ff }, { "antiquewhite", 0xfaebd7 }, { "aqua", 0x00ffff }, { "aquamarine", 0x7fffd4 },
+    { "azure", 0xf0ffff }, { "beige", 0xf5f5dc }, { "bisque", 0xffe4c4 }, { "black", 0x000000 },
+    { "blanchedalmond", 0xffebcd }, { "blue", 0x0000ff }, { "blueviolet", 0x8a2be2 }, { "brown", 0xa52a2a },
+    { "burlywood", 0xdeb887 }, { "cadetblue", 0x5f9ea0 }, { "chartreuse", 0x7fff00 }, { "chocolate", 0xd2691e },
+    { "coral", 0xff7f50 }, { "cornflowerblue", 0x6495ed }, { "cornsilk", 0xfff8dc }, { "crimson", 0xdc143c },
+    { "cyan", 0x00ffff }, { "darkblue", 0x00008b }, { "darkcyan", 0x008b8b }, { "darkgoldenrod", 0xb8860b },
+    { "darkgray", 0xa9a9a9 }, { "darkgreen", 0x006400 }, { "darkgrey", 0xa9a9a9 }, { "darkkhaki", 0xbdb76b },
+    { "darkmagenta", 0x8b008b }, { "darkolivegreen", 0x556b2f }, { "darkorange", 0xff8c00 }, { "darkorchid", 0x9932cc },
+    { "darkred", 0x8b0000 }, { "darksalmon", 0xe9967a }, { "darkseagreen", 0x8fbc8f }, { "darkslateblue", 0x483d8b },
+    { "darkslategray", 0x2f4f4f }, { "darkslategrey", 0x2f4f4f }, { "darkturquoise", 0x00ced1 }, { "darkviolet", 0x9400d3 },
+    { "deeppink", 0xff1493 }, { "deepskyblue", 0x00bfff }, { "dimgray", 0x696969 }, { "dimgrey", 0x696969 },
+    { "dodgerblue", 0x1e90ff }, { "firebrick", 0xb22222 }, { "floralwhite", 0xfffaf0 }, { "forestgreen", 0x228b22 },
+    { "fuchsia", 0xff00ff }, { "gainsboro", 0xdcdcdc }, { "ghostwhite", 0xf8f8ff }, { "gold", 0xffd700 },
+    { "goldenrod", 0xdaa520 }, { "gray", 0x808080 }, { "green", 0x008000 }, { "greenyellow", 0xadff2f },
+    { "grey", 0x808080 }, { "honeydew", 0xf0fff0 }, { "hotpink", 0xff69b4 }, { "indianred", 0xcd5c5c },
+    { "indigo", 0x4b0082 }, { "ivory", 0xfffff0 }, { "khaki", 0xf0e68c }, { "lavender", 0xe6e6fa },
+    { "lavenderblush", 0xfff0f5 }, { "lawngreen", 0x7cfc00 }, { "lemonchiffon", 0xfffacd }, { "lightblue", 0xadd8e6 },
+    { "lightcoral", 0xf08080 }, { "lightcyan", 0xe0ffff }, { "lightgoldenrodyellow", 0xfafad2 }, { "lightgray", 0xd3d3d3 },
+    { "lightgreen", 0x90ee90 }, { "lightgrey", 0xd3d3d3 }, { "lightpink", 0xffb6c1 }, { "lightsalmon", 0xffa07a },
+    { "lightseagreen", 0x20b2aa }, { "lightskyblue", 0x87cefa }, { "lightslategray", 0x778899 }, { "lightslategrey", 0x778899 },
+    { "lightsteelblue", 0xb0c4de }, { "lightyellow", 0xffffe0 }, { "lime", 0x00ff00 }, { "limegreen", 0x32cd32 },
+    { "linen", 0xfaf0e6 }, { "magenta", 0xff00ff }, { "maroon", 0x800000 }, { "mediumaquamarine", 0x66cdaa },
+    { "mediumblue", 0x0000cd }, { "mediumorchid", 0xba55d3 }, { "mediumpurple", 0x9370db }, { "mediumseagreen", 0x3cb371 },
+    { "mediumslateblue", 0x7b68ee }, { "mediumspringgreen", 0x00fa9a }, { "mediumturquoise", 0x48d1cc }, { "mediumvioletred", 0xc71585 },
+    { "midnightblue", 0x191970 }, { "mintcream", 0xf5fffa }, { "mistyrose", 0xffe4e1 }, { "moccasin", 0xffe4b5 },
+    { "navajowhite", 0xffdead }, { "navy", 0x000080 }, { "oldlace", 0xfdf5e6 }, { "olive", 0x808000 },
+    { "olivedrab", 0x6b8e23 }, { "orange", 0xffa500 }, { "orangered", 0xff4500 }, { "orchid", 0xda70d6 },
+    { "palegoldenrod", 0xeee8aa }, { "palegreen", 0x98fb98 }, { "paleturquoise", 0xafeeee }, { "palevioletred", 0xdb7093 },
+    { "papayawhip", 0xffefd5 }, { "peachpuff", 0xffdab9 }, { "peru", 0xcd853f }, { "pink", 0xffc0cb },
+    { "plum", 0xdda0dd }, { "powderblue", 0xb0e0e6 }, { "purple", 0x800080 }, { "rebeccapurple", 0x663399 },
+    { "red", 0xff0000 }, { "rosybrown", 0xbc8f8f }, { "royalblue", 0x4169e1 }, { "saddlebrown", 0x8b4513 },
+    { "salmon", 0xfa8072 }, { "sandybrown", 0xf4a460 }, { "seagreen", 0x2e8b57 }, { "seashell", 0xfff5ee },
+    { "sienna", 0xa0522d }, { "silver", 0xc0c0c0 }, { "skyblue", 0x87ceeb }, { "slateblue", 0x6a5acd },
+    { "slategray", 0x708090 }, { "slategrey", 0x708090 }, { "snow", 0xfffafa }, { "springgreen", 0x00ff7f },
+    { "steelblue", 0x4682b4 }, { "tan", 0xd2b48c }, { "teal", 0x008080 }, { "thistle", 0xd8bfd8 },
+    { "tomato", 0xff6347 }, { "turquoise", 0x40e0d0 }, { "violet", 0xee82ee }, { "wheat", 0xf5deb3 },
+    { "white", 0xffffff }, { "whitesmoke", 0xf5f5f5 }, { "yellow", 0xffff00 }, { "yellowgreen", 0x9acd32 },
+};
+
+static glm::vec3 hexToRgb(unsigned int hex)
+{
+    return glm::vec3(((hex >> 16) & 0xff) / 255.0f, ((hex >> 8) & 0xff) / 255.0f, (hex & 0xff) / 255.0f);
+}
+
+std::vector<NamedColor> cssNamedColors()
+{
+    std::vector<NamedColor> colors;
+    for (const auto& c : CSS_COLORS)
+        colors.push_back({ c.name, hexToRgb(c.hex) });
+    return colors;
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool onlySpaces(const char* p)
+{
+    while (*p == ' ' || *p == '\t') ++p;
+    return *p == '\0';
+}
+
+// " #rrggbb": exactly six hex digits, followed only by spaces
+static bool parseHexColor(const char* p, unsigned int& hex)
+{
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p++ != '#') return false;
+    hex = 0;
+    for (int k = 0; k < 6; ++k)
+    {
+        int d = hexDigit(p[k]);
+        if (d < 0) return false;
+        hex = hex * 16 + d;
+    }
+    return onlySpaces(p + 6);
+}
+
+bool loadNamedColors(const std::string& path, std::vector<NamedColor>& colors)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::NAMED_COLORS::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t comma = line.find(',');
+        if (comma == std::string::npos)
+        {
+            std::cout << "ERROR::NAMED_COLORS::BAD_LINE " << path << ":" << lineNumber << std::endl;
+            continue;
+        }
+        std::string name = line.substr(0, comma);
+        std::string value = line.substr(comma + 1);
+        unsigned int hex, r, g, b;
+        int used = 0;
+        if (parseHexColor(value.c_str(), hex))
+            colors.push_back({ name, hexToRgb(hex) });
+        else if (sscanf(value.c_str(), "%u,%u,%u%n", &r, &g, &b, &used) == 3 && onlySpaces(value.c_str() + used) && r < 256 && g < 256 &&
+            b < 256)
+            colors.push_back({ name, glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f) });
+        else
+            std::cout << "ERROR::NAMED_COLORS::BAD_LINE " << path << ":" << lineNumber << std::endl;
+    }
+    return true;
+}
+
+// =======================================================
+// k-d tree
+// =======================================================
+
+static const int LEAF_SIZE = 8;
+
+void NamedColorIndex::toSpace(glm::vec3 rgb, float out[3]) const
+{
+    glm::vec3 c = convertColor(ColorSpace::SRGB, space, rgb);
+    out[0] = c.x;
+    out[1] = c.y;
+    out[2] = c.z;
+}
+
+void NamedColorIndex::build(const std::vector<NamedColor>& palette, ColorSpace indexSpace)
+{
+    space = indexSpace;
+    names.clear();
+    colors.clear();
+    points.clear();
+    for (const NamedColor& c : palette)
+    {
+        Point p;
+        toSpace(c.rgb, p.p);
+        p.index = (int)names.size();
+        points.push_back(p);
+        names.push_back(c.name);
+        colors.push_back(c.rgb);
+    }
+    splitAxis.assign(points.size(), 0);
+    buildRange(0, (int)points.size());
+
+    // planes padded to a multiple of 4 with far-away points, so the scan needs no tail
+    size_t padded = (points.size() + 3) & ~size_t(3);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        planes[axis].assign(padded, 1e18f);
+        for (size_t i = 0; i < points.size(); ++i)
+            planes[axis][i] = points[i].p[axis];
+    }
+}
+
+void NamedColorIndex::buildRange(int lo, int hi)
+{
+    if (hi - lo <= LEAF_SIZE) return;
+
+    // split the widest axis at its median
+    float mn[3] = { points[lo].p[0], points[lo].p[1], points[lo].p[2] };
+    float mx[3] = { mn[0], mn[1], mn[2] };
+    for (int i = lo + 1; i < hi; ++i)
+        for (int a = 0; a < 3; ++a)
+        {
+            mn[a] = std::min(mn[a], points[i].p[a]);
+            mx[a] = std::max(mx[a], points[i].p[a]);
+        }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+        if (mx[a] - mn[a] > mx[axis] - mn[axis]) axis = a;
+
+    int mid = (lo + hi) / 2;
+    std::nth_element(points.begin() + lo, points.begin() + mid, points.begin() + hi,
+        [axis](const Point& a, const Point& b) { return a.p[axis] < b.p[axis]; });
+    splitAxis[mid] = (unsigned char)axis;
+    buildRange(lo, mid);
+    buildRange(mid + 1, hi);
+}
+
+// keeps best/bestDist sorted ascending; bestDist[k - 1] is the pruning radius
+static inline void offer(int index, float d, int k, int* best, float* bestDist)
+{
+    if (d >= bestDist[k - 1]) return;
+    int i = k - 1;
+    while (i > 0 && bestDist[i - 1] > d)
+    {
+        bestDist[i] = bestDist[i - 1];
+        best[i] = best[i - 1];
+        --i;
+    }
+    bestDist[i] = d;
+    best[i] = index;
+}
+
+static inline float distance2(const float a[3], const float b[3])
+{
+    float d0 = a[0] - b[0], d1 = a[1] - b[1], d2 = a[2] - b[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+void NamedColorIndex::search(int lo, int hi, const float q[3], int k, int* best, float* bestDist) const
+{
+    if (hi - lo <= LEAF_SIZE)
+    {
+        for (int i = lo; i < hi; ++i)
+            offer(points[i].index, distance2(q, points[i].p), k, best, bestDist);
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    const Point& split = points[mid];
+    offer(split.index, distance2(q, split.p), k, best, bestDist);
+
+    float d = q[splitAxis[mid]] - split.p[splitAxis[mid]];
+    if (d < 0.0f)
+    {
+        search(lo, mid, q, k, best, bestDist);
+        if (d * d < bestDist[k - 1]) search(mid + 1, hi, q, k, best, bestDist);
+    }
+    else
+    {
+        search(mid + 1, hi, q, k, best, bestDist);
+        if (d * d < bestDist[k - 1]) search(lo, mid, q, k, best, bestDist);
+    }
+}
+
+int NamedColorIndex::nearest(glm::vec3 rgb) const
+{
+    if (points.empty()) return -1;
+    float q[3];
+    toSpace(rgb, q);
+    int best = -1;
+    float bestDist = std::numeric_limits<float>::infinity();
+    search(0, (int)points.size(), q, 1, &best, &bestDist);
+    return best;
+}
+
+// =======================================================
+// Brute-force baseline
+// =======================================================
+
+int NamedColorIndex::bruteForce(const float q[3]) const
+{
+    size_t n = planes[0].size();
+    size_t i = 0;
+    float bestDist = std::numeric_limits<float>::infinity();
+    size_t bestSlot = 0;
+#ifdef RGBPICK_SSE2
+    // per-lane minimum and the slot it came from, reduced at the end
+    __m128 qx = _mm_set1_ps(q[0]), qy = _mm_set1_ps(q[1]), qz = _mm_set1_ps(q[2]);
+    __m128 laneBest = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128i laneSlot = _mm_setzero_si128();
+    __m128i slot = _mm_setr_epi32(0, 1, 2, 3);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&planes[0][i]), qx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&planes[1][i]), qy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(&planes[2][i]), qz);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 closer = _mm_cmplt_ps(d, laneBest);
+        laneBest = select_ps(closer, d, laneBest);
+        laneSlot = _mm_castps_si128(select_ps(closer, _mm_castsi128_ps(slot), _mm_castsi128_ps(laneSlot)));
+        slot = _mm_add_epi32(slot, _mm_set1_epi32(4));
+    }
+    float lanes[4];
+    int slots[4];
+    _mm_storeu_ps(lanes, laneBest);
+    _mm_storeu_si128((__m128i*)slots, laneSlot);
+    for (int l = 0; l < 4; ++l)
+        if (lanes[l] < bestDist || (lanes[l] == bestDist && (size_t)slots[l] < bestSlot))
+        {
+            bestDist = lanes[l];
+            bestSlot = slots[l];
+        }
+#endif
+    for (; i < n; ++i)
+    {
+        float p[3] = { planes[0][i], planes[1][i], planes[2][i] };
+        float d = distance2(q, p);
+        if (d < bestDist)
+        {
+            bestDist = d;
+            bestSlot = i;
+        }
+    }
+    return points[bestSlot].index;
+}
+
+int NamedColorIndex::nearestBruteForce(glm::vec3 rgb) const
+{
+    if (points.empty()) return -1;
+    float q[3];
+    toSpace(rgb, q);
+    return bruteForce(q);
+}
+
+// =======================================================
+// Batch queries
+// =======================================================
+
+void NamedColorIndex::queryRange(const float* const rgb[3], size_t begin, size_t end, int k, int* indices, float* distances, bool brute) const
+{
+    // convert a block at a time with the batch conversions, then query each color
+    const size_t BLOCK = 256;
+    float block[3][BLOCK];
+    float* const out[3] = { block[0], block[1], block[2] };
+    for (size_t start = begin; start < end; start += BLOCK)
+    {
+        size_t count = std::min(BLOCK, end - start);
+        const float* const in[3] = { rgb[0] + start, rgb[1] + start, rgb[2] + start };
+        convertColorsBatch(ColorSpace::SRGB, space, in, out, count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            float q[3] = { block[0][i], block[1][i], block[2][i] };
+            if (brute)
+            {
+                indices[start + i] = bruteForce(q);
+                continue;
+            }
+            int* best = indices + (start + i) * k;
+            float* bestDist = distances + (start + i) * k;
+            std::fill(best, best + k, -1);
+            std::fill(bestDist, bestDist + k, std::numeric_limits<float>::infinity());
+            search(0, (int)points.size(), q, k, best, bestDist);
+            for (int j = 0; j < k; ++j)
+                if (best[j] >= 0) bestDist[j] = std::sqrt(bestDist[j]);
+        }
+    }
+}
+
+void NamedColorIndex::nearestK(const float* const rgb[3], size_t n, int k, int* indices, float* distances) const
+{
+    if (points.empty())
+    {
+        std::fill(indices, indices + n * k, -1);
+        std::fill(distances, distances + n * k, std::numeric_limits<float>::infinity());
+        return;
+    }
+    parallelRanges(n, [&](size_t begin, size_t end) { queryRange(rgb, begin, end, k, indices, distances, false); });
+}
+
+void NamedColorIndex::nearestBruteForceBatch(const float* const rgb[3], size_t n, int* indices) const
+{
+    if (points.empty())
+    {
+        std::fill(indices, indices + n, -1);
+        return;
+    }
+    parallelRanges(n, [&](size_t begin, size_t end) { queryRange(rgb, begin, end, 1, indices, nullptr, true); });
+}
+
+// =======================================================
+// Benchmark
+// =======================================================
+
+void benchmarkNamedColors()
+{
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    unsigned int seed = 2024;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
+
+    std::vector<NamedColor> palette = cssNamedColors();
+    while (palette.size() < 50000)
+        palette.push_back({ "color" + std::to_string(palette.size()), glm::vec3(next(), next(), next()) });
+
+    NamedColorIndex index;
+    Clock::time_point t0 = Clock::now();
+    index.build(palette);
+    std::cout << "named colors: " << index.size() << " entries, index built in " << seconds(t0) * 1000.0 << " ms" << std::endl;
+
+    const size_t n = 20000;
+    std::vector<float> queries(n * 3);
+    for (float& v : queries) v = next();
+    const float* rgb[3] = { queries.data(), queries.data() + n, queries.data() + 2 * n };
+
+    // single queries, as the picker issues them
+    t0 = Clock::now();
+    std::vector<int> tree(n), brute(n);
+    for (size_t i = 0; i < n; ++i)
+        tree[i] = index.nearest(glm::vec3(rgb[0][i], rgb[1][i], rgb[2][i]));
+    double treeTime = seconds(t0);
+    t0 = Clock::now();
+    for (size_t i = 0; i < n; ++i)
+        brute[i] = index.nearestBruteForce(glm::vec3(rgb[0][i], rgb[1][i], rgb[2][i]));
+    double bruteTime = seconds(t0);
+
+    // ties can pick different entries at the same distance; anything else is a bug
+    int mismatches = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (tree[i] != brute[i] && index.rgb(tree[i]) != index.rgb(brute[i]))
+            ++mismatches;
+
+    char line[160];
+    snprintf(line, sizeof(line), "  single query: k-d tree %.2f us, brute force (SSE2) %.2f us, %d mismatches",
+        treeTime / n * 1e6, bruteTime / n * 1e6, mismatches);
+    std::cout << line << std::endl;
+
+    // batch over all cores
+    const int k = 4;
+    std::vector<int> indices(n * k);
+    std::vector<float> distances(n * k);
+    t0 = Clock::now();
+    index.nearestK(rgb, n, k, indices.data(), distances.data());
+    double knnTime = seconds(t0);
+    t0 = Clock::now();
+    index.nearestBruteForceBatch(rgb, n, brute.data());
+    double bruteBatchTime = seconds(t0);
+    snprintf(line, sizeof(line), "  batch (%u threads): k-d tree k=%d %.2f Mq/s, brute force k=1 %.3f Mq/s",
+        std::max(1u, std::thread::hardware_concurrency()), k, n / knnTime * 1e-6, n / bruteBatchTime * 1e-6);
+    std::cout << line << std::endl;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "color_spaces.hpp"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// =======================================================
+// Named colors and nearest-name lookup
+// =======================================================
+
+struct NamedColor
+{
+    std::string name;
+    glm::vec3 rgb;  // sRGB-encoded, [0,1]
+};
+
+// the 148 CSS named colors
+std::vector<NamedColor> cssNamedColors();
+// reads a palette file, one color per line: "name,#rrggbb" or "name,r,g,b" (0-255);
+// blank lines and lines starting with '#' are skipped. Returns false if the file can't be read
+bool loadNamedColors(const std::string& path, std::vector<NamedColor>& colors);
+
+// Nearest-neighbor index over a palette, in a perceptual space (OKLab by default, or Lab).
+// Built once as a k-d tree (median splits on the widest axis, leaf buckets of up to 8
+// colors); queries and results use sRGB and palette indices, the space stays internal.
+// A brute-force SSE2 scan over the same data is kept as the baseline.
+class NamedColorIndex
+{
+public:
+    void build(const std::vector<NamedColor>& colors, ColorSpace space = ColorSpace::OKLab);
+
+    size_t size() const { return names.size(); }
+    const std::string& name(int index) const { return names[index]; }
+    glm::vec3 rgb(int index) const { return colors[index]; }
+
+    // index of the palette entry closest to the sRGB color, -1 when empty
+    int nearest(glm::vec3 rgb) const;
+    // the same by scanning every entry
+    int nearestBruteForce(glm::vec3 rgb) const;
+
+    // k nearest entries for each of n sRGB colors given as planes (r, g, b), sorted by
+    // distance: indices/distances hold n * k values (distance in the index space, -1 / inf
+    // padding when the palette has fewer than k entries). Runs on all cores
+    void nearestK(const float* const rgb[3], size_t n, int k, int* indices, float* distances) const;
+    // the brute-force equivalent of nearestK for k = 1, also on all cores
+    void nearestBruteForceBatch(const float* const rgb[3], size_t n, int* indices) const;
+
+private:
+    struct Point { float p[3]; int index; };
+
+    void buildRange(int lo, int hi);
+    void search(int lo, int hi, const float q[3], int k, int* best, float* bestDist) const;
+    void toSpace(glm::vec3 rgb, float out[3]) const;
+    int bruteForce(const float q[3]) const;
+    void queryRange(const float* const rgb[3], size_t begin, size_t end, int k, int* indices, float* distances, bool brute) const;
+
+    ColorSpace space = ColorSpace::OKLab;
+    std::vector<std::string> names;
+    std::vector<glm::vec3> colors;
+    // k-d tree: points reordered so each range [lo, hi) has its split point at the middle;
+    // splitAxis[mid] is that node's axis
+    std::vector<Point> points;
+    std::vector<unsigned char> splitAxis;
+    // the same points as padded planes for the SIMD scan
+    std::vector<float> planes[3];
+};
+
+// builds a 50,000-color random palette, then times k-d tree and brute-force queries
+// against each other and checks they agree (--bench-named-colors)
+void benchmarkNamedColors();
@@ -0,0 +1,201 @@
+#include "oklch_wheel.hpp"
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <vector>
+
+// =======================================================
+// Gamut boundary table
+// =======================================================
+
+static void oklabToLinear(float L, float a, float b, float rgb[3])
+{
+    float l = L + 0.3963377774f * a + 0.2158037573f * b;
+    float m = L - 0.1055613458f * a - 0.0638541728f * b;
+    float s = L - 0.0894841775f * a - 1.2914855480f * b;
+    l = l * l * l;
+    m = m * m * m;
+    s = s * s * s;
+    rgb[0] = 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s;
+    rgb[1] = -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s;
+    rgb[2] = -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s;
+}
+
+static bool inGamut(const float rgb[3])
+{
+    return rgb[0] >= 0.0f && rgb[1] >= 0.0f && rgb[2] >= 0.0f &&
+        rgb[0] <= 1.0f && rgb[1] <= 1.0f && rgb[2] <= 1.0f;
+}
+
+// largest in-gamut chroma at one lightness and hue angle (cosine, sine), bisected in OKLCH_GAMUT_STEPS steps
+static float maxChromaAt(float lightness, float ca, float sa)
+{
+    float rgb[3];
+    float lo = 0.0f, hi = OKLCH_MAX_CHROMA;
+    for (int step = 0; step < OKLCH_GAMUT_STEPS; ++step)
+    {
+        float mid = 0.5f * (lo + hi);
+        oklabToLinear(lightness, mid * ca, mid * sa, rgb);
+        if (inGamut(rgb)) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+void buildOklchGamutTable(float lightness, float* maxChroma)
+{
+    for (int i = 0; i < OKLCH_GAMUT_TABLE_SIZE; ++i)
+    {
+        float h = i * (6.28318531f / OKLCH_GAMUT_TABLE_SIZE);
+        maxChroma[i] = maxChromaAt(lightness, std::cos(h), std::sin(h));
+    }
+}
+
+// =======================================================
+// CPU version (mirrors oklch_wheel_glsl line by line)
+// =======================================================
+
+static_assert((OKLCH_GAMUT_TABLE_SIZE & (OKLCH_GAMUT_TABLE_SIZE - 1)) == 0, "table indices wrap with a mask");
+
+// the last two lightnesses asked for, so callers alternating between two of them (the picked
+// color and the value bar) don't rebuild a table each time
+struct CpuGamutTable
+{
+    float lightness = -1.0f;
+    unsigned lastUse = 0;
+    std::vector<float> maxChroma = std::vector<float>(OKLCH_GAMUT_TABLE_SIZE);
+};
+static CpuGamutTable cpuTables[2];
+static unsigned cpuTableUses = 0;
+
+static const std::vector<float>& cpuGamutTable(float lightness)
+{
+    CpuGamutTable* table = &cpuTables[0];
+    if (cpuTables[1].lightness == lightness ||
+        (cpuTables[0].lightness != lightness && cpuTables[1].lastUse < cpuTables[0].lastUse))
+        table = &cpuTables[1];
+    if (table->lightness != lightness)
+    {
+        buildOklchGamutTable(lightness, table->maxChroma.data());
+        table->lightness = lightness;
+    }
+    table->lastUse = ++cpuTableUses;
+    return table->maxChroma;
+}
+
+static float encode(float c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+glm::vec3 oklchWheelToRgb(float hue, float saturation, float lightness)
+{
+    const std::vector<float>& cpuTable = cpuGamutTable(lightness);
+    float p = hue * OKLCH_GAMUT_TABLE_SIZE;
+    float i0 = std::floor(p);
+    float f = p - i0;
+    int a = (int)i0 & (OKLCH_GAMUT_TABLE_SIZE - 1);
+    int b = (a + 1) & (OKLCH_GAMUT_TABLE_SIZE - 1);
+    float boundary = cpuTable[a] + (cpuTable[b] - cpuTable[a]) * f;
+
+    float h = hue * 6.28318531f;
+    float chroma = std::fmin(saturation * OKLCH_MAX_CHROMA, boundary);
+    float rgb[3];
+    oklabToLinear(lightness, chroma * std::cos(h), chroma * std::sin(h), rgb);
+    // interpolating between table entries can overshoot the boundary by a hair
+    for (float& c : rgb) c = std::fmin(std::fmax(c, 0.0f), 1.0f);
+    return glm::vec3(encode(rgb[0]), encode(rgb[1]), encode(rgb[2]));
+}
+
+// =======================================================
+// Value bar
+// =======================================================
+
+glm::vec3 oklchCuspToRgb(float hue, float saturation)
+{
+    float h = hue * 6.28318531f;
+    float ca = std::cos(h), sa = std::sin(h);
+    // the largest chroma over lightness rises to a single peak (the cusp of the gamut's
+    // lightness/chroma slice), so a ternary search finds it
+    float lo = 0.0f, hi = 1.0f;
+    for (int step = 0; step < 32; ++step)
+    {
+        float m1 = lo + (hi - lo) / 3.0f, m2 = hi - (hi - lo) / 3.0f;
+        if (maxChromaAt(m1, ca, sa) < maxChromaAt(m2, ca, sa)) lo = m1;
+        else hi = m2;
+    }
+    float lightness = 0.5f * (lo + hi);
+    float chroma = std::fmin(saturation * OKLCH_MAX_CHROMA, maxChromaAt(lightness, ca, sa));
+    float rgb[3];
+    oklabToLinear(lightness, chroma * ca, chroma * sa, rgb);
+    for (float& c : rgb) c = std::fmin(std::fmax(c, 0.0f), 1.0f);
+    return glm::vec3(encode(rgb[0]), encode(rgb[1]), encode(rgb[2]));
+}
+
+// =======================================================
+// GPU table
+// =======================================================
+
+static GLuint gamutTexture;
+static float gpuTableLightness = -1.0f;
+
+void bindOklchGamutTable(float lightness, int unit)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    if (!gamutTexture)
+    {
+        glGenTextures(1, &gamutTexture);
+        glBindTexture(GL_TEXTURE_2D, gamutTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, OKLCH_GAMUT_TABLE_SIZE, 1, 0, GL_RED, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, gamutTexture);
+    if (lightness != gpuTableLightness)
+    {
+        std::vector<float> table(OKLCH_GAMUT_TABLE_SIZE);
+        buildOklchGamutTable(lightness, table.data());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, OKLCH_GAMUT_TABLE_SIZE, 1, GL_RED, GL_FLOAT, table.data());
+        gpuTableLightness = lightness;
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// =======================================================
+// GLSL version
+// =======================================================
+
+#define GLSL_STRINGIFY_(x) #x
+#define GLSL_STRINGIFY(x) GLSL_STRINGIFY_(x)
+
+const char* oklch_wheel_glsl =
+"uniform sampler2D uGamutTable;\n"
+"vec3 oklab_to_linear(float L, float a, float b)\n"
+"{\n"
+"    float l = L + 0.3963377774 * a + 0.2158037573 * b;\n"
+"    float m = L - 0.1055613458 * a - 0.0638541728 * b;\n"
+"    float s = L - 0.0894841775 * a - 1.2914855480 * b;\n"
+"    l = l * l * l;\n"
+"    m = m * m * m;\n"
+"    s = s * s * s;\n"
+"    return vec3(4.0767416621 * l - 3.3077115913 * m + 0.2309699292 * s,\n"
+"                -1.2684380046 * l + 2.6097574011 * m - 0.3413193965 * s,\n"
+"                -0.0041960863 * l - 0.7034186147 * m + 1.7076147010 * s);\n"
+"}\n"
+"vec3 oklch_wheel(float hue, float saturation, float lightness)\n"
+"{\n"
+"    const int size = " GLSL_STRINGIFY(OKLCH_GAMUT_TABLE_SIZE) ";\n"
+"    float p = hue * float(size);\n"
+"    float i0 = floor(p);\n"
+"    float f = p - i0;\n"
+"    int a = int(i0) & (size - 1);\n"
+"    int b = (a + 1) & (size - 1);\n"
+"    float t0 = texelFetch(uGamutTable, ivec2(a, 0), 0).r;\n"
+"    float t1 = texelFetch(uGamutTable, ivec2(b, 0), 0).r;\n"
+"    float boundary = t0 + (t1 - t0) * f;\n"
+"    float h = hue * 6.28318531;\n"
+"    float chroma = min(saturation * " GLSL_STRINGIFY(OKLCH_MAX_CHROMA) ", boundary);\n"
+"    vec3 rgb = clamp(oklab_to_linear(lightness, chroma * cos(h), chroma * sin(h)), 0.0, 1.0);\n"
+"    return mix(rgb * 12.92, 1.055 * pow(rgb, vec3(1.0 / 2.4)) - 0.055, greaterThan(rgb, vec3(0.0031308)));\n"
+"}\n";
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// =======================================================
+// OKLCH wheel layout with gamut mapping
+// =======================================================
+//
+// Same layout as the HSV wheel (hue from the angle, 0 at -pi; saturation = distance /
+// radius), but the wheel position means OKLCH hue and chroma at a fixed lightness, so equal
+// steps on the wheel are roughly equal perceived steps. Chroma is saturation *
+// OKLCH_MAX_CHROMA, clipped to the largest chroma sRGB can show at that lightness and hue
+// (chroma reduction at constant lightness and hue, so the hue stays exact).
+//
+// Lightness is constant over the wheel, so the gamut boundary only depends on hue: it is
+// found once per lightness by bisection for OKLCH_GAMUT_TABLE_SIZE hues and stored in a
+// table. The shader and the CPU both interpolate that table with the same float operations,
+// so the color picked on the CPU matches the pixel drawn under the cursor (to within GPU
+// rounding, well below one 8-bit step) and a fragment costs one OKLab -> RGB conversion.
+
+// macros rather than constants so the GLSL source is generated from the same values
+// a little above the largest chroma sRGB reaches (0.322, blue)
+#define OKLCH_MAX_CHROMA 0.33f
+// hues in the boundary table (a power of two)
+#define OKLCH_GAMUT_TABLE_SIZE 1024
+// bisection steps per hue; the boundary error is OKLCH_MAX_CHROMA / 2^steps = 5e-6
+#define OKLCH_GAMUT_STEPS 16
+
+// largest in-gamut chroma for OKLCH_GAMUT_TABLE_SIZE evenly spaced hues at `lightness`
+void buildOklchGamutTable(float lightness, float* maxChroma);
+
+// hue [0,1), saturation [0,1], lightness [0,1] -> gamut-mapped, sRGB-encoded color
+// (keeps the tables of the last two lightnesses asked for)
+glm::vec3 oklchWheelToRgb(float hue, float saturation, float lightness);
+
+// the same mapping at the lightness where sRGB reaches its largest chroma for the hue (the
+// cusp), i.e. the hue at its most colorful; the value bar's top color on the OKLCH wheel
+// (at lightness 1 every hue is white). Searched directly, no table
+glm::vec3 oklchCuspToRgb(float hue, float saturation);
+
+// uploads the boundary table for `lightness` (only when it changed) as a
+// OKLCH_GAMUT_TABLE_SIZE x 1 GL_R32F texture and binds it to texture unit `unit`
+void bindOklchGamutTable(float lightness, int unit);
+
+// GLSL oklch_wheel(hue, saturation, lightness) with the same mapping, reading the table from
+// `uniform sampler2D uGamutTable`; for pasting into shaders ahead of main()
+extern const char* oklch_wheel_glsl;
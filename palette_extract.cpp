@@ -0,0 +1,473 @@
+#include "palette_extract.hpp"
+#include "color_spaces.hpp"
+#include "color_transfer.hpp"
+#include "simd_math.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+// samples per parallel work item; items are handed out one at a time, so threads that finish
+// early take over the remaining blocks
+static const size_t PALETTE_BLOCK = 16384;
+
+// =======================================================
+// Sampling
+// =======================================================
+
+// converts count sRGB8 pixels, step pixels apart, to OKLab samples starting at offset
+static void convertPixels(const unsigned char* rgb, size_t count, size_t step, PaletteSamples& out, size_t offset)
+{
+    std::vector<unsigned char> bytes(count * 3);
+    std::vector<float> lab(count * 3);
+    for (size_t i = 0; i < count; ++i)
+        for (int c = 0; c < 3; ++c)
+            bytes[i * 3 + c] = rgb[i * step * 3 + c];
+    srgb8ToLinearBatch(bytes.data(), lab.data(), count * 3);
+    convertColorsInterleaved(ColorSpace::LinearRGB, ColorSpace::OKLab, lab.data(), lab.data(), count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        out.L[offset + i] = lab[i * 3];
+        out.a[offset + i] = lab[i * 3 + 1];
+        out.b[offset + i] = lab[i * 3 + 2];
+    }
+}
+
+static void resizeSamples(PaletteSamples& samples, size_t count)
+{
+    samples.L.resize(count);
+    samples.a.resize(count);
+    samples.b.resize(count);
+}
+
+void samplePixels(const unsigned char* rgb, int width, int height, size_t maxSamples, PaletteSamples& out)
+{
+    // the smallest grid step that keeps the sample count within maxSamples
+    size_t step = 1, cols = width, rows = height;
+    while (maxSamples && cols * rows > maxSamples)
+    {
+        ++step;
+        cols = (width + step - 1) / step;
+        rows = (height + step - 1) / step;
+    }
+    resizeSamples(out, cols * rows);
+    sharedThreadPool().parallelFor(rows, [&](size_t r) {
+        convertPixels(rgb + r * step * width * 3, cols, step, out, r * cols);
+    });
+}
+
+bool samplePyramid(const ImagePyramid& image, size_t maxSamples, PaletteSamples& out)
+{
+    if (!image.isOpen()) return false;
+    int l = 0;
+    while (l + 1 < image.levels() && maxSamples && (size_t)image.level(l).width * image.level(l).height > maxSamples)
+        ++l;
+    const PyramidLevel& lv = image.level(l);
+    if (image.rowsDone(l) < (int)lv.height) return false;
+
+    const int S = PYRAMID_TILE_SIZE;
+    resizeSamples(out, (size_t)lv.width * lv.height);
+    sharedThreadPool().parallelFor((size_t)lv.tilesX * lv.tilesY, [&](size_t t) {
+        int tx = (int)(t % lv.tilesX), ty = (int)(t / lv.tilesX);
+        int tileW = std::min(S, (int)lv.width - tx * S), tileH = std::min(S, (int)lv.height - ty * S);
+        const unsigned char* tile = image.tile(l, tx, ty);
+        for (int y = 0; y < tileH; ++y)
+            convertPixels(tile + (size_t)y * S * 3, tileW, 1, out, (size_t)(ty * S + y) * lv.width + tx * S);
+    });
+    return true;
+}
+
+// =======================================================
+// Distance kernels
+// =======================================================
+
+struct Centers
+{
+    int k = 0;
+    float L[PALETTE_MAX_COLORS], a[PALETTE_MAX_COLORS], b[PALETTE_MAX_COLORS];
+};
+
+// label[i] / dist[i]: nearest center and its squared distance, for samples [begin, end)
+static void assignRange(const PaletteSamples& s, size_t begin, size_t end, const Centers& centers, uint8_t* label, float* dist)
+{
+    size_t i = begin;
+#ifdef RGBPICK_SSE2
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 L = _mm_loadu_ps(&s.L[i]), a = _mm_loadu_ps(&s.a[i]), b = _mm_loadu_ps(&s.b[i]);
+        __m128 best = _mm_set1_ps(FLT_MAX), bestIndex = _mm_setzero_ps();
+        for (int c = 0; c < centers.k; ++c)
+        {
+            __m128 dL = _mm_sub_ps(L, _mm_set1_ps(centers.L[c]));
+            __m128 da = _mm_sub_ps(a, _mm_set1_ps(centers.a[c]));
+            __m128 db = _mm_sub_ps(b, _mm_set1_ps(centers.b[c]));
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dL, dL), _mm_mul_ps(da, da)), _mm_mul_ps(db, db));
+            __m128 closer = _mm_cmplt_ps(d, best);
+            best = _mm_min_ps(d, best);
+            bestIndex = select_ps(closer, _mm_set1_ps((float)c), bestIndex);
+        }
+        _mm_storeu_ps(&dist[i], best);
+        int index[4];
+        _mm_storeu_si128((__m128i*)index, _mm_cvttps_epi32(bestIndex));
+        for (int j = 0; j < 4; ++j)
+            label[i + j] = (uint8_t)index[j];
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        float best = FLT_MAX;
+        int bestIndex = 0;
+        for (int c = 0; c < centers.k; ++c)
+        {
+            float dL = s.L[i] - centers.L[c], da = s.a[i] - centers.a[c], db = s.b[i] - centers.b[c];
+            float d = dL * dL + da * da + db * db;
+            if (d < best)
+            {
+                best = d;
+                bestIndex = c;
+            }
+        }
+        dist[i] = best;
+        label[i] = (uint8_t)bestIndex;
+    }
+}
+
+// dist[i] = min(dist[i], squared distance to one color) for samples [begin, end); returns the sum
+static double nearerRange(const PaletteSamples& s, size_t begin, size_t end, float cL, float ca, float cb, float* dist)
+{
+    double sum = 0.0;
+    size_t i = begin;
+#ifdef RGBPICK_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 dL = _mm_sub_ps(_mm_loadu_ps(&s.L[i]), _mm_set1_ps(cL));
+        __m128 da = _mm_sub_ps(_mm_loadu_ps(&s.a[i]), _mm_set1_ps(ca));
+        __m128 db = _mm_sub_ps(_mm_loadu_ps(&s.b[i]), _mm_set1_ps(cb));
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dL, dL), _mm_mul_ps(da, da)), _mm_mul_ps(db, db));
+        d = _mm_min_ps(d, _mm_loadu_ps(&dist[i]));
+        _mm_storeu_ps(&dist[i], d);
+        total = _mm_add_ps(total, d);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, total);
+    sum = (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < end; ++i)
+    {
+        float dL = s.L[i] - cL, da = s.a[i] - ca, db = s.b[i] - cb;
+        dist[i] = std::min(dist[i], dL * dL + da * da + db * db);
+        sum += dist[i];
+    }
+    return sum;
+}
+
+// =======================================================
+// K-means
+// =======================================================
+
+// k-means++: each next center is a sample drawn with probability proportional to its squared
+// distance from the nearest center so far. Fixed seed, so a palette is reproducible
+static void seedKMeans(const PaletteSamples& s, int k, Centers& centers, std::vector<float>& dist)
+{
+    size_t n = s.count(), blocks = (n + PALETTE_BLOCK - 1) / PALETTE_BLOCK;
+    std::vector<double> blockSum(blocks);
+    dist.assign(n, FLT_MAX);
+    uint32_t state = 2463534242u;
+    auto random = [&]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    size_t pick = random() % n;
+    centers.k = 0;
+    for (;;)
+    {
+        centers.L[centers.k] = s.L[pick];
+        centers.a[centers.k] = s.a[pick];
+        centers.b[centers.k] = s.b[pick];
+        int c = centers.k++;
+        if (centers.k == k) break;
+
+        sharedThreadPool().parallelFor(blocks, [&](size_t blk) {
+            size_t begin = blk * PALETTE_BLOCK, end = std::min(n, begin + PALETTE_BLOCK);
+            blockSum[blk] = nearerRange(s, begin, end, centers.L[c], centers.a[c], centers.b[c], dist.data());
+        });
+        double total = 0.0;
+        for (double sum : blockSum) total += sum;
+        // fewer distinct colors than requested
+        if (total <= 0.0) break;
+
+        double target = (random() >> 8) * (1.0 / 16777216.0) * total;
+        size_t blk = 0;
+        while (blk + 1 < blocks && target >= blockSum[blk])
+            target -= blockSum[blk++];
+        size_t end = std::min(n, (blk + 1) * PALETTE_BLOCK);
+        pick = blk * PALETTE_BLOCK;
+        while (pick + 1 < end && target >= dist[pick])
+            target -= dist[pick++];
+    }
+}
+
+// one Lloyd iteration: assigns every sample, moves each center to its cluster's mean and
+// returns the largest move. counts receives the cluster sizes
+static float lloydStep(const PaletteSamples& s, Centers& centers, std::vector<uint8_t>& label, std::vector<float>& dist,
+    std::vector<double>& partial, size_t* counts)
+{
+    size_t n = s.count(), blocks = (n + PALETTE_BLOCK - 1) / PALETTE_BLOCK;
+    const int k = centers.k;
+    // per block sums of L, a, b and the count, merged after the parallel pass
+    partial.assign(blocks * k * 4, 0.0);
+    sharedThreadPool().parallelFor(blocks, [&](size_t blk) {
+        size_t begin = blk * PALETTE_BLOCK, end = std::min(n, begin + PALETTE_BLOCK);
+        assignRange(s, begin, end, centers, label.data(), dist.data());
+        double* sums = &partial[blk * k * 4];
+        for (size_t i = begin; i < end; ++i)
+        {
+            double* cluster = sums + label[i] * 4;
+            cluster[0] += s.L[i];
+            cluster[1] += s.a[i];
+            cluster[2] += s.b[i];
+            cluster[3] += 1.0;
+        }
+    });
+
+    float shift = 0.0f;
+    for (int c = 0; c < k; ++c)
+    {
+        double L = 0.0, a = 0.0, b = 0.0, count = 0.0;
+        for (size_t blk = 0; blk < blocks; ++blk)
+        {
+            const double* cluster = &partial[(blk * k + c) * 4];
+            L += cluster[0];
+            a += cluster[1];
+            b += cluster[2];
+            count += cluster[3];
+        }
+        counts[c] = (size_t)count;
+        // an empty cluster keeps its center
+        if (count == 0.0) continue;
+        float nL = (float)(L / count), na = (float)(a / count), nb = (float)(b / count);
+        float dL = nL - centers.L[c], da = na - centers.a[c], db = nb - centers.b[c];
+        shift = std::max(shift, dL * dL + da * da + db * db);
+        centers.L[c] = nL;
+        centers.a[c] = na;
+        centers.b[c] = nb;
+    }
+    return std::sqrt(shift);
+}
+
+// =======================================================
+// Median cut
+// =======================================================
+
+struct CutBox
+{
+    size_t begin, end;
+    int axis;      // of largest variance
+    double error;  // sum of squared deviations along it
+    float mean[3];
+};
+
+static void measureBox(const PaletteSamples& s, const std::vector<uint32_t>& index, CutBox& box)
+{
+    const float* channel[3] = { s.L.data(), s.a.data(), s.b.data() };
+    double sum[3] = {}, squares[3] = {};
+    for (size_t i = box.begin; i < box.end; ++i)
+        for (int c = 0; c < 3; ++c)
+        {
+            double v = channel[c][index[i]];
+            sum[c] += v;
+            squares[c] += v * v;
+        }
+    double count = (double)(box.end - box.begin);
+    box.axis = 0;
+    box.error = -1.0;
+    for (int c = 0; c < 3; ++c)
+    {
+        box.mean[c] = (float)(sum[c] / count);
+        double error = squares[c] - sum[c] * sum[c] / count;
+        if (error > box.error)
+        {
+            box.error = error;
+            box.axis = c;
+        }
+    }
+}
+
+static void medianCut(const PaletteSamples& s, int k, Centers& centers, size_t* counts)
+{
+    std::vector<uint32_t> index(s.count());
+    for (size_t i = 0; i < index.size(); ++i)
+        index[i] = (uint32_t)i;
+    std::vector<CutBox> boxes(1);
+    boxes[0].begin = 0;
+    boxes[0].end = index.size();
+    measureBox(s, index, boxes[0]);
+
+    const float* channel[3] = { s.L.data(), s.a.data(), s.b.data() };
+    while ((int)boxes.size() < k)
+    {
+        size_t worst = 0;
+        for (size_t i = 1; i < boxes.size(); ++i)
+            if (boxes[i].error > boxes[worst].error) worst = i;
+        CutBox box = boxes[worst];
+        if (box.end - box.begin < 2 || box.error <= 0.0) break;
+
+        // split at the median value; equal values stay on one side, so a flat region of the
+        // image isn't torn between two boxes
+        const float* values = channel[box.axis];
+        auto first = index.begin() + box.begin, last = index.begin() + box.end;
+        std::nth_element(first, first + (last - first) / 2, last, [values](uint32_t x, uint32_t y) { return values[x] < values[y]; });
+        float median = values[*(first + (last - first) / 2)];
+        auto split = std::partition(first, last, [&](uint32_t i) { return values[i] < median; });
+        if (split == first)
+            split = std::partition(first, last, [&](uint32_t i) { return values[i] <= median; });
+        size_t middle = split - index.begin();
+        CutBox low = box, high = box;
+        low.end = middle;
+        high.begin = middle;
+        measureBox(s, index, low);
+        measureBox(s, index, high);
+        boxes[worst] = low;
+        boxes.push_back(high);
+    }
+
+    centers.k = (int)boxes.size();
+    for (int c = 0; c < centers.k; ++c)
+    {
+        centers.L[c] = boxes[c].mean[0];
+        centers.a[c] = boxes[c].mean[1];
+        centers.b[c] = boxes[c].mean[2];
+        counts[c] = boxes[c].end - boxes[c].begin;
+    }
+}
+
+// =======================================================
+// Extraction
+// =======================================================
+
+std::vector<PaletteColor> extractPalette(const PaletteSamples& samples, const PaletteOptions& options)
+{
+    std::vector<PaletteColor> palette;
+    size_t n = samples.count();
+    int k = std::min(std::max(options.colors, 1), PALETTE_MAX_COLORS);
+    if (n == 0) return palette;
+
+    Centers centers;
+    size_t counts[PALETTE_MAX_COLORS] = {};
+    if (options.method == PaletteMethod::MedianCut)
+        medianCut(samples, k, centers, counts);
+    else
+    {
+        std::vector<float> dist;
+        std::vector<uint8_t> label(n);
+        std::vector<double> partial;
+        seedKMeans(samples, k, centers, dist);
+        // stop once no center moves by more than a tenth of a just noticeable OKLab difference
+        for (int i = 0; i < std::max(options.iterations, 1); ++i)
+            if (lloydStep(samples, centers, label, dist, partial, counts) < 0.002f)
+                break;
+    }
+
+    for (int c = 0; c < centers.k; ++c)
+    {
+        if (counts[c] == 0) continue;
+        PaletteColor color;
+        color.oklab = glm::vec3(centers.L[c], centers.a[c], centers.b[c]);
+        glm::vec3 rgb = convertColor(ColorSpace::OKLab, ColorSpace::SRGB, color.oklab);
+        color.rgb = glm::vec3(std::min(std::max(rgb.x, 0.0f), 1.0f), std::min(std::max(rgb.y, 0.0f), 1.0f),
+            std::min(std::max(rgb.z, 0.0f), 1.0f));
+        color.share = (float)((double)counts[c] / n);
+        palette.push_back(color);
+    }
+    std::sort(palette.begin(), palette.end(), [](const PaletteColor& x, const PaletteColor& y) { return x.share > y.share; });
+    return palette;
+}
+
+// =======================================================
+// Benchmark
+// =======================================================
+
+// twelve flat-ish color regions with gradients and grain, so the palette has a clear answer
+static std::vector<unsigned char> syntheticImage(int width, int height)
+{
+    static const unsigned char bases[12][3] = {
+        { 200, 40, 40 }, { 40, 160, 60 }, { 30, 60, 200 }, { 230, 200, 40 }, { 120, 40, 160 }, { 20, 170, 180 },
+        { 240, 130, 30 }, { 90, 90, 90 }, { 240, 240, 230 }, { 30, 30, 40 }, { 160, 110, 70 }, { 250, 150, 190 },
+    };
+    std::vector<unsigned char> rgb((size_t)width * height * 3);
+    sharedThreadPool().parallelFor(height, [&](size_t y) {
+        uint32_t seed = (uint32_t)y * 2654435761u + 1;
+        for (int x = 0; x < width; ++x)
+        {
+            int region = (x * 4 / width + (int)(y * 3 / height) * 4) % 12;
+            float shade = 0.85f + 0.15f * (float)x / width;
+            for (int c = 0; c < 3; ++c)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                int v = (int)(bases[region][c] * shade) + (int)(seed >> 28) - 8;
+                rgb[((size_t)y * width + x) * 3 + c] = (unsigned char)std::min(std::max(v, 0), 255);
+            }
+        }
+    });
+    return rgb;
+}
+
+void benchmarkPalette()
+{
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); };
+    const int k = 8;
+    char line[160];
+    std::cout << "Palette extraction, " << k << " colors in OKLab, " << sharedThreadPool().size() << " threads" << std::endl;
+    std::cout << "  image            samples   sample ms  median cut ms  k-means++ ms  ms/iteration (iterations)" << std::endl;
+
+    struct Size { const char* name; int width, height; };
+    const Size sizes[] = { { "4K 3840x2160", 3840, 2160 }, { "50MP 8660x5774", 8660, 5774 } };
+    const size_t limits[] = { 0, 1 << 22, 1 << 20, 1 << 18 };
+    for (const Size& size : sizes)
+    {
+        std::vector<unsigned char> image = syntheticImage(size.width, size.height);
+        for (size_t limit : limits)
+        {
+            PaletteSamples samples;
+            Clock::time_point t0 = Clock::now();
+            samplePixels(image.data(), size.width, size.height, limit, samples);
+            double sampleTime = seconds(t0);
+            size_t n = samples.count();
+
+            Centers centers;
+            size_t counts[PALETTE_MAX_COLORS];
+            t0 = Clock::now();
+            medianCut(samples, k, centers, counts);
+            double cutTime = seconds(t0);
+
+            std::vector<float> dist;
+            std::vector<uint8_t> label(n);
+            std::vector<double> partial;
+            t0 = Clock::now();
+            seedKMeans(samples, k, centers, dist);
+            double seedTime = seconds(t0);
+            t0 = Clock::now();
+            int iterations = 0;
+            while (iterations < 16)
+            {
+                ++iterations;
+                if (lloydStep(samples, centers, label, dist, partial, counts) < 0.002f) break;
+            }
+            double iterationTime = seconds(t0) / iterations;
+
+            snprintf(line, sizeof(line), "  %-15s %8.2fM %11.1f %14.1f %13.1f %13.2f (%d)", size.name, n * 1e-6,
+                sampleTime * 1e3, cutTime * 1e3, seedTime * 1e3, iterationTime * 1e3, iterations);
+            std::cout << line << std::endl;
+        }
+    }
+}
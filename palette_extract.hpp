@@ -0,0 +1,56 @@
+#pragma once
+
+#include "image_pyramid.hpp"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// =======================================================
+// Dominant color extraction (median cut / k-means in OKLab)
+// =======================================================
+
+// most colors a palette can have
+#define PALETTE_MAX_COLORS 32
+
+// MedianCut: recursively splits the box of largest squared error at the median of its widest
+// axis. KMeans: k-means++ seeding, then Lloyd iterations until the centers stop moving
+enum class PaletteMethod { MedianCut, KMeans };
+
+struct PaletteOptions
+{
+    int colors = 8;
+    PaletteMethod method = PaletteMethod::KMeans;
+    // pixels used at most; bigger images are subsampled (0 uses every pixel)
+    size_t maxSamples = 1 << 20;
+    int iterations = 16;  // k-means limit
+};
+
+struct PaletteColor
+{
+    glm::vec3 rgb;    // sRGB [0,1], clipped to the gamut
+    glm::vec3 oklab;  // cluster mean
+    float share;      // fraction of the samples in the cluster
+};
+
+// pixels in OKLab, planar; the samples clustering runs on
+struct PaletteSamples
+{
+    std::vector<float> L, a, b;
+    size_t count() const { return L.size(); }
+};
+
+// samples of an interleaved RGB8 image, taken on a regular grid when it has more than
+// maxSamples pixels. Rows are converted in parallel
+void samplePixels(const unsigned char* rgb, int width, int height, size_t maxSamples, PaletteSamples& out);
+// samples of a pyramid: the finest level with at most maxSamples pixels (its pixels are box
+// averages of the ones below). False while that level is still being built
+bool samplePyramid(const ImagePyramid& image, size_t maxSamples, PaletteSamples& out);
+
+// the dominant colors, most common first. Assignment and seeding passes run on all cores over
+// blocks of samples, with SSE2 distance computations where available
+std::vector<PaletteColor> extractPalette(const PaletteSamples& samples, const PaletteOptions& options);
+
+// times sampling, seeding and k-means iterations on synthetic 4K and 50-megapixel images, with
+// and without subsampling (--bench-palette)
+void benchmarkPalette();
@@ -0,0 +1,576 @@
+#include "palette_library.hpp"
+#include "color_spaces.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+// =======================================================
+// File layout
+// =======================================================
+
+// header, records, string table, then the optional name index; everything native byte order
+struct PaletteLibraryHeader
+{
+    char magic[8];             // "RGBPAL1"
+    uint32_t count;
+    uint32_t flags;            // LIBRARY_NAME_INDEX
+    uint64_t recordsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t nameIndexOffset;  // count uint32 record numbers, ordered by name
+    uint64_t reserved[2];
+};
+
+// the records form a k-d tree the same way NamedColorIndex orders its points: each range
+// [lo, hi) longer than a leaf has its split record at the middle, splitting on splitAxis
+struct PaletteRecord
+{
+    uint8_t rgba[4];
+    float oklab[3];
+    uint32_t nameOffset;  // into the string table; names aren't terminated
+    uint16_t nameLength;
+    uint8_t splitAxis;
+    uint8_t reserved;
+};
+
+static const char LIBRARY_MAGIC[8] = { 'R', 'G', 'B', 'P', 'A', 'L', '1', '\0' };
+static const uint32_t LIBRARY_NAME_INDEX = 1;
+static const int LIBRARY_LEAF_SIZE = 8;
+static_assert(sizeof(PaletteLibraryHeader) == 64, "library header is 64 bytes on disk");
+static_assert(sizeof(PaletteRecord) == 24, "library records are 24 bytes on disk");
+
+// =======================================================
+// Reading a library
+// =======================================================
+
+PaletteLibrary::~PaletteLibrary()
+{
+    close();
+}
+
+bool PaletteLibrary::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cout << "ERROR::PALETTE_LIBRARY::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(PaletteLibraryHeader))
+        mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        std::cout << "ERROR::PALETTE_LIBRARY::NOT_A_LIBRARY " << path << std::endl;
+        return false;
+    }
+    data = (const unsigned char*)mapped;
+    mappedSize = (size_t)st.st_size;
+
+    // only the header is checked; name offsets are bounded when a name is read
+    PaletteLibraryHeader h;
+    memcpy(&h, data, sizeof(h));
+    uint64_t recordsEnd = h.recordsOffset + (uint64_t)h.count * sizeof(PaletteRecord);
+    bool valid = memcmp(h.magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) == 0 && h.recordsOffset % alignof(PaletteRecord) == 0 &&
+        recordsEnd <= mappedSize && h.stringsOffset + h.stringsSize <= mappedSize;
+    if (valid && (h.flags & LIBRARY_NAME_INDEX))
+        valid = h.nameIndexOffset % 4 == 0 && h.nameIndexOffset + (uint64_t)h.count * 4 <= mappedSize;
+    if (!valid || h.count == 0)
+    {
+        std::cout << "ERROR::PALETTE_LIBRARY::" << (valid ? "EMPTY " : "NOT_A_LIBRARY ") << path << std::endl;
+        close();
+        return false;
+    }
+    count = h.count;
+    records = (const PaletteRecord*)(data + h.recordsOffset);
+    strings = (const char*)data + h.stringsOffset;
+    stringsSize = h.stringsSize;
+    nameIndex = (h.flags & LIBRARY_NAME_INDEX) ? (const uint32_t*)(data + h.nameIndexOffset) : nullptr;
+    // queries jump around the tree; don't read ahead
+    madvise((void*)data, mappedSize, MADV_RANDOM);
+    return true;
+}
+
+void PaletteLibrary::close()
+{
+    if (data)
+        munmap((void*)data, mappedSize);
+    data = nullptr;
+    mappedSize = 0;
+    count = 0;
+    records = nullptr;
+    strings = nullptr;
+    stringsSize = 0;
+    nameIndex = nullptr;
+}
+
+glm::vec4 PaletteLibrary::rgba(size_t index) const
+{
+    const uint8_t* c = records[index].rgba;
+    return glm::vec4(c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f);
+}
+
+glm::vec3 PaletteLibrary::oklab(size_t index) const
+{
+    const float* p = records[index].oklab;
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+std::string_view PaletteLibrary::name(size_t index) const
+{
+    const PaletteRecord& r = records[index];
+    if ((uint64_t)r.nameOffset + r.nameLength > stringsSize)
+        return std::string_view();
+    return std::string_view(strings + r.nameOffset, r.nameLength);
+}
+
+static inline float distance2(const float a[3], const float b[3])
+{
+    float d0 = a[0] - b[0], d1 = a[1] - b[1], d2 = a[2] - b[2];
+    return d0 * d0 + d1 * d1 + d2 * d2;
+}
+
+void PaletteLibrary::search(int lo, int hi, const float q[3], int& best, float& bestDist) const
+{
+    if (hi - lo <= LIBRARY_LEAF_SIZE)
+    {
+        for (int i = lo; i < hi; ++i)
+        {
+            float d = distance2(q, records[i].oklab);
+            if (d < bestDist)
+            {
+                bestDist = d;
+                best = i;
+            }
+        }
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    const PaletteRecord& split = records[mid];
+    float d2 = distance2(q, split.oklab);
+    if (d2 < bestDist)
+    {
+        bestDist = d2;
+        best = mid;
+    }
+    int axis = std::min<int>(split.splitAxis, 2);
+    float d = q[axis] - split.oklab[axis];
+    if (d < 0.0f)
+    {
+        search(lo, mid, q, best, bestDist);
+        if (d * d < bestDist) search(mid + 1, hi, q, best, bestDist);
+    }
+    else
+    {
+        search(mid + 1, hi, q, best, bestDist);
+        if (d * d < bestDist) search(lo, mid, q, best, bestDist);
+    }
+}
+
+int PaletteLibrary::nearest(glm::vec3 rgb) const
+{
+    if (count == 0) return -1;
+    glm::vec3 lab = convertColor(ColorSpace::SRGB, ColorSpace::OKLab, rgb);
+    float q[3] = { lab.x, lab.y, lab.z };
+    int best = -1;
+    float bestDist = std::numeric_limits<float>::infinity();
+    search(0, (int)count, q, best, bestDist);
+    return best;
+}
+
+int PaletteLibrary::find(std::string_view key) const
+{
+    if (!nameIndex) return -1;
+    const uint32_t* end = nameIndex + count;
+    const uint32_t* it = std::lower_bound(nameIndex, end, key,
+        [this](uint32_t record, std::string_view k) { return name(std::min<size_t>(record, count - 1)) < k; });
+    if (it == end || *it >= count || name(*it) != key)
+        return -1;
+    return (int)*it;
+}
+
+bool isPaletteLibrary(const std::string& path)
+{
+    char magic[8] = {};
+    std::ifstream file(path, std::ios::binary);
+    return file.read(magic, sizeof(magic)) && memcmp(magic, LIBRARY_MAGIC, sizeof(magic)) == 0;
+}
+
+// =======================================================
+// Source formats
+// =======================================================
+
+// "GIMP Palette", optional "Name:"/"Columns:" lines and '#' comments, then "r g b name" per line
+static bool readGpl(const std::string& path, const std::vector<char>& bytes, std::vector<NamedColor>& colors)
+{
+    std::string text(bytes.begin(), bytes.end());
+    size_t pos = 0;
+    int lineNumber = 0;
+    while (pos < text.size())
+    {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (lineNumber == 1 || line.empty() || line[0] == '#' || line.compare(0, 5, "Name:") == 0 || line.compare(0, 8, "Columns:") == 0)
+            continue;
+        unsigned int r, g, b;
+        int consumed = 0;
+        if (sscanf(line.c_str(), " %u %u %u %n", &r, &g, &b, &consumed) < 3 || r > 255 || g > 255 || b > 255)
+        {
+            std::cout << "ERROR::PALETTE_LIBRARY::BAD_LINE " << path << ":" << lineNumber << std::endl;
+            continue;
+        }
+        std::string name = line.substr(consumed);
+        while (!name.empty() && isspace((unsigned char)name.back())) name.pop_back();
+        if (name.empty())
+        {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "#%02x%02x%02x", r, g, b);
+            name = hex;
+        }
+        colors.push_back({ name, glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f) });
+    }
+    return true;
+}
+
+static uint16_t readBe16(const unsigned char* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static uint32_t readBe32(const unsigned char* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+static float readBeFloat(const unsigned char* p)
+{
+    uint32_t bits = readBe32(p);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// UTF-16BE code units to UTF-8, stopping at the terminating zero
+static std::string utf16ToUtf8(const unsigned char* p, size_t units)
+{
+    std::string out;
+    for (size_t i = 0; i < units; ++i)
+    {
+        uint32_t c = readBe16(p + 2 * i);
+        if (c == 0) break;
+        if (c >= 0xd800 && c < 0xdc00 && i + 1 < units)
+        {
+            uint32_t low = readBe16(p + 2 * (i + 1));
+            if (low >= 0xdc00 && low < 0xe000)
+            {
+                c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                ++i;
+            }
+        }
+        if (c < 0x80)
+            out += (char)c;
+        else if (c < 0x800)
+        {
+            out += (char)(0xc0 | c >> 6);
+            out += (char)(0x80 | (c & 0x3f));
+        }
+        else if (c < 0x10000)
+        {
+            out += (char)(0xe0 | c >> 12);
+            out += (char)(0x80 | (c >> 6 & 0x3f));
+            out += (char)(0x80 | (c & 0x3f));
+        }
+        else
+        {
+            out += (char)(0xf0 | c >> 18);
+            out += (char)(0x80 | (c >> 12 & 0x3f));
+            out += (char)(0x80 | (c >> 6 & 0x3f));
+            out += (char)(0x80 | (c & 0x3f));
+        }
+    }
+    return out;
+}
+
+// Adobe Swatch Exchange: "ASEF", version, block count, then big-endian blocks; only color
+// entries (type 1) are read, group start/end blocks are skipped
+static bool readAse(const std::string& path, const std::vector<char>& bytes, std::vector<NamedColor>& colors)
+{
+    const unsigned char* p = (const unsigned char*)bytes.data();
+    size_t size = bytes.size(), pos = 12;
+    uint32_t blocks = size >= 12 ? readBe32(p + 8) : 0;
+    for (uint32_t b = 0; b < blocks && pos + 6 <= size; ++b)
+    {
+        uint16_t type = readBe16(p + pos);
+        uint32_t length = readBe32(p + pos + 2);
+        size_t body = pos + 6;
+        pos = body + length;
+        if (pos > size)
+        {
+            std::cout << "ERROR::PALETTE_LIBRARY::TRUNCATED_ASE " << path << std::endl;
+            return false;
+        }
+        if (type != 0x0001 || length < 2)
+            continue;
+        size_t units = readBe16(p + body);
+        size_t model = body + 2 + units * 2;
+        if (model + 4 > pos)
+            continue;
+        std::string name = utf16ToUtf8(p + body + 2, units);
+        auto value = [&](int i) { return model + 4 + 4 * (i + 1) <= pos ? readBeFloat(p + model + 4 + 4 * i) : 0.0f; };
+        glm::vec3 rgb;
+        if (memcmp(p + model, "RGB ", 4) == 0)
+            rgb = glm::vec3(value(0), value(1), value(2));
+        else if (memcmp(p + model, "CMYK", 4) == 0)
+        {
+            float k = 1.0f - value(3);
+            rgb = glm::vec3((1.0f - value(0)) * k, (1.0f - value(1)) * k, (1.0f - value(2)) * k);
+        }
+        else if (memcmp(p + model, "LAB ", 4) == 0)
+            rgb = convertColor(ColorSpace::Lab, ColorSpace::SRGB, glm::vec3(value(0) * 100.0f, value(1), value(2)));
+        else if (memcmp(p + model, "Gray", 4) == 0)
+            rgb = glm::vec3(value(0));
+        else
+        {
+            std::cout << "ERROR::PALETTE_LIBRARY::UNKNOWN_ASE_MODEL " << path << " " << name << std::endl;
+            continue;
+        }
+        for (int i = 0; i < 3; ++i)
+            rgb[i] = std::min(std::max(rgb[i], 0.0f), 1.0f);
+        colors.push_back({ name, rgb });
+    }
+    return true;
+}
+
+bool readPaletteSource(const std::string& path, std::vector<NamedColor>& colors)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::PALETTE_LIBRARY::CANNOT_OPEN " << path << std::endl;
+        return false;
+    }
+    char head[12] = {};
+    file.read(head, sizeof(head));
+    bool ase = memcmp(head, "ASEF", 4) == 0;
+    bool gpl = memcmp(head, "GIMP Palette", 12) == 0;
+    if (!ase && !gpl)
+        return loadNamedColors(path, colors);
+    file.clear();
+    file.seekg(0);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return ase ? readAse(path, bytes, colors) : readGpl(path, bytes, colors);
+}
+
+// =======================================================
+// Writing a library
+// =======================================================
+
+static void orderRange(std::vector<PaletteRecord>& records, int lo, int hi)
+{
+    if (hi - lo <= LIBRARY_LEAF_SIZE) return;
+
+    // split the widest axis at its median
+    float mn[3] = { records[lo].oklab[0], records[lo].oklab[1], records[lo].oklab[2] };
+    float mx[3] = { mn[0], mn[1], mn[2] };
+    for (int i = lo + 1; i < hi; ++i)
+        for (int a = 0; a < 3; ++a)
+        {
+            mn[a] = std::min(mn[a], records[i].oklab[a]);
+            mx[a] = std::max(mx[a], records[i].oklab[a]);
+        }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+        if (mx[a] - mn[a] > mx[axis] - mn[axis]) axis = a;
+
+    int mid = (lo + hi) / 2;
+    std::nth_element(records.begin() + lo, records.begin() + mid, records.begin() + hi,
+        [axis](const PaletteRecord& a, const PaletteRecord& b) { return a.oklab[axis] < b.oklab[axis]; });
+    records[mid].splitAxis = (uint8_t)axis;
+    orderRange(records, lo, mid);
+    orderRange(records, mid + 1, hi);
+}
+
+bool writePaletteLibrary(const std::vector<NamedColor>& colors, const std::string& path, bool withNameIndex)
+{
+    if (colors.size() > INT32_MAX)
+    {
+        std::cout << "ERROR::PALETTE_LIBRARY::TOO_MANY_COLORS " << colors.size() << std::endl;
+        return false;
+    }
+    std::string strings;
+    std::vector<PaletteRecord> records(colors.size());
+    for (size_t i = 0; i < colors.size(); ++i)
+    {
+        const NamedColor& c = colors[i];
+        PaletteRecord& r = records[i];
+        for (int ch = 0; ch < 3; ++ch)
+            r.rgba[ch] = (uint8_t)std::lround(std::min(std::max(c.rgb[ch], 0.0f), 1.0f) * 255.0f);
+        r.rgba[3] = 255;
+        // OKLab of the stored 8-bit color, so queries and the color shown agree
+        glm::vec3 lab = convertColor(ColorSpace::SRGB, ColorSpace::OKLab, glm::vec3(r.rgba[0] / 255.0f, r.rgba[1] / 255.0f, r.rgba[2] / 255.0f));
+        r.oklab[0] = lab.x;
+        r.oklab[1] = lab.y;
+        r.oklab[2] = lab.z;
+        r.nameOffset = (uint32_t)strings.size();
+        r.nameLength = (uint16_t)std::min<size_t>(c.name.size(), UINT16_MAX);
+        r.splitAxis = 0;
+        r.reserved = 0;
+        strings.append(c.name, 0, r.nameLength);
+        if (strings.size() > UINT32_MAX)
+        {
+            std::cout << "ERROR::PALETTE_LIBRARY::NAMES_TOO_LONG " << path << std::endl;
+            return false;
+        }
+    }
+    orderRange(records, 0, (int)records.size());
+
+    std::vector<uint32_t> byName;
+    if (withNameIndex)
+    {
+        byName.resize(records.size());
+        std::iota(byName.begin(), byName.end(), 0u);
+        auto nameOf = [&](uint32_t i) { return std::string_view(strings.data() + records[i].nameOffset, records[i].nameLength); };
+        std::sort(byName.begin(), byName.end(), [&](uint32_t a, uint32_t b) { return nameOf(a) < nameOf(b); });
+    }
+
+    PaletteLibraryHeader h = {};
+    memcpy(h.magic, LIBRARY_MAGIC, sizeof(h.magic));
+    h.count = (uint32_t)records.size();
+    h.flags = withNameIndex ? LIBRARY_NAME_INDEX : 0;
+    h.recordsOffset = sizeof(h);
+    h.stringsOffset = h.recordsOffset + records.size() * sizeof(PaletteRecord);
+    h.stringsSize = strings.size();
+    h.nameIndexOffset = withNameIndex ? (h.stringsOffset + h.stringsSize + 3) & ~uint64_t(3) : 0;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const char pad[4] = {};
+    file.write((const char*)&h, sizeof(h));
+    file.write((const char*)records.data(), records.size() * sizeof(PaletteRecord));
+    file.write(strings.data(), strings.size());
+    if (withNameIndex)
+    {
+        file.write(pad, h.nameIndexOffset - (h.stringsOffset + h.stringsSize));
+        file.write((const char*)byName.data(), byName.size() * sizeof(uint32_t));
+    }
+    if (!file.flush())
+    {
+        std::cout << "ERROR::PALETTE_LIBRARY::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool convertPaletteLibrary(const std::string& input, const std::string& output)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<NamedColor> colors;
+    if (!readPaletteSource(input, colors) || !writePaletteLibrary(colors, output))
+        return false;
+    printf("%s: %zu colors written to %s in %.1f ms\n", input.c_str(), colors.size(), output.c_str(),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+// =======================================================
+// Benchmark
+// =======================================================
+
+void benchmarkPaletteLibrary()
+{
+    typedef std::chrono::steady_clock Clock;
+    auto ms = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    unsigned int seed = 2024;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    };
+
+    const size_t n = 1000000;
+    std::vector<NamedColor> colors(n);
+    for (size_t i = 0; i < n; ++i)
+        colors[i] = { "color" + std::to_string(i), glm::vec3(next(), next(), next()) };
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string csvPath = (dir / "rgbpick_bench_library.csv").string();
+    std::string libraryPath = (dir / "rgbpick_bench_library.rgbpal").string();
+    {
+        std::ofstream csv(csvPath);
+        char line[64];
+        for (const NamedColor& c : colors)
+        {
+            snprintf(line, sizeof(line), ",#%02x%02x%02x\n", (int)std::lround(c.rgb.r * 255.0f), (int)std::lround(c.rgb.g * 255.0f),
+                (int)std::lround(c.rgb.b * 255.0f));
+            csv << c.name << line;
+        }
+    }
+    std::cout << "palette library: " << n << " colors" << std::endl;
+
+    Clock::time_point t0 = Clock::now();
+    convertPaletteLibrary(csvPath, libraryPath);
+    double convertTime = ms(t0);
+
+    // the status quo: parse the CSV and build the k-d tree at every start
+    t0 = Clock::now();
+    std::vector<NamedColor> parsed;
+    loadNamedColors(csvPath, parsed);
+    NamedColorIndex index;
+    index.build(parsed);
+    double csvTime = ms(t0);
+
+    const int opens = 100;
+    PaletteLibrary library;
+    t0 = Clock::now();
+    for (int i = 0; i < opens; ++i)
+        library.open(libraryPath);
+    double openTime = ms(t0) / opens;
+
+    // first queries fault their pages in; later ones find them cached
+    const int queries = 20000;
+    std::vector<glm::vec3> probes(queries);
+    for (glm::vec3& p : probes) p = glm::vec3(next(), next(), next());
+    t0 = Clock::now();
+    std::vector<int> results(queries);
+    results[0] = library.nearest(probes[0]);
+    double firstTime = ms(t0);
+    t0 = Clock::now();
+    int mismatches = 0;
+    for (const glm::vec3& p : probes)
+    {
+        int a = library.nearest(p), b = index.nearest(p);
+        if (library.name(a) != index.name(b) && library.rgba(a) != glm::vec4(index.rgb(b), 1.0f))
+            ++mismatches;
+    }
+    double bothTime = ms(t0);
+    t0 = Clock::now();
+    for (int i = 0; i < queries; ++i)
+        results[i] = library.nearest(probes[i]);
+    double queryTime = ms(t0) / queries;
+    t0 = Clock::now();
+    int found = 0;
+    for (int i = 0; i < queries; ++i)
+        found += library.find("color" + std::to_string(i * 37 % n)) >= 0;
+    double findTime = ms(t0) / queries;
+
+    char line[200];
+    snprintf(line, sizeof(line), "  CSV -> .rgbpal %.0f ms (%.1f MB); CSV load + k-d build %.0f ms", convertTime,
+        std::filesystem::file_size(libraryPath) / 1e6, csvTime);
+    std::cout << line << std::endl;
+    snprintf(line, sizeof(line), "  open %.3f ms, first nearest %.3f ms, nearest %.2f us (%d mismatches vs NamedColorIndex, %.0f ms both), find %.2f us (%d/%d found)",
+        openTime, firstTime, queryTime * 1000.0, mismatches, bothTime, findTime * 1000.0, found, queries);
+    std::cout << line << std::endl;
+    library.close();
+    std::filesystem::remove(csvPath);
+    std::filesystem::remove(libraryPath);
+}
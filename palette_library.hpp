@@ -0,0 +1,68 @@
+#pragma once
+
+#include "named_colors.hpp"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// =======================================================
+// Binary palette libraries, memory-mapped
+// =======================================================
+
+struct PaletteRecord;
+
+// A palette in the .rgbpal format (layout in palette_library.cpp): fixed-size records with
+// RGBA8 and precomputed OKLab, stored in k-d tree order so nearest-color queries walk the
+// records directly, names in one string table, and optionally the records sorted by name.
+// open() maps the file and checks the header; nothing is parsed or copied, so opening takes
+// the same time for ten entries as for millions and pages are read as queries touch them.
+class PaletteLibrary
+{
+public:
+    ~PaletteLibrary();
+
+    // false (with an ERROR line) if the file isn't a valid library or has no entries
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    size_t size() const { return count; }
+    glm::vec4 rgba(size_t index) const;  // sRGB + alpha, [0,1]
+    glm::vec3 oklab(size_t index) const;
+    std::string_view name(size_t index) const;
+
+    // entry closest to the sRGB color in OKLab, -1 when empty
+    int nearest(glm::vec3 rgb) const;
+    // entry with exactly this name, -1 if there is none or the file has no name index
+    int find(std::string_view name) const;
+
+private:
+    void search(int lo, int hi, const float q[3], int& best, float& bestDist) const;
+
+    const unsigned char* data = nullptr;
+    size_t mappedSize = 0;
+    size_t count = 0;
+    const PaletteRecord* records = nullptr;
+    const char* strings = nullptr;
+    size_t stringsSize = 0;
+    const uint32_t* nameIndex = nullptr;
+};
+
+// true if the file starts with the .rgbpal magic
+bool isPaletteLibrary(const std::string& path);
+// reads a palette in any supported source format, told apart by content: Adobe Swatch
+// Exchange (.ase, RGB/CMYK/Lab/Gray swatches), GIMP palette (.gpl), or the CSV of
+// loadNamedColors. False if the file can't be read
+bool readPaletteSource(const std::string& path, std::vector<NamedColor>& colors);
+// writes colors as a .rgbpal library, with a name index unless nameIndex is false
+bool writePaletteLibrary(const std::vector<NamedColor>& colors, const std::string& path, bool nameIndex = true);
+// reads any source format and writes a library (--convert-palette <in> <out>)
+bool convertPaletteLibrary(const std::string& input, const std::string& output);
+
+// writes a 1M-entry library, then times opening and querying it against loading the same
+// colors from CSV and building a NamedColorIndex (--bench-palette-library)
+void benchmarkPaletteLibrary();
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+// splits [0, n) into one contiguous range per thread of the shared pool (ranges of at least
+// minChunk items) and calls fn(begin, end) for each on the pool
+template <typename Fn>
+void parallelRanges(size_t n, Fn fn, size_t minChunk = 1024)
+{
+    ThreadPool& pool = sharedThreadPool();
+    size_t threads = std::min<size_t>(pool.size(), std::max<size_t>(1, n / minChunk));
+    size_t chunk = (n + threads - 1) / threads;
+    pool.parallelFor(threads, [&](size_t t) {
+        size_t begin = std::min(n, t * chunk), end = std::min(n, begin + chunk);
+        fn(begin, end);
+    });
+}
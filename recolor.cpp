@@ -0,0 +1,459 @@
+#include "recolor.hpp"
+#include "color_spaces.hpp"
+#include "color_transfer.hpp"
+#include "thread_pool.hpp"
+
+#include <png.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// pixels below this OKLab chroma are never shifted; the weight ramps up to full at twice it
+#define RECOLOR_MIN_CHROMA 0.015f
+
+// =======================================================
+// The shift
+// =======================================================
+
+namespace
+{
+// RecolorParams reduced to what is applied per pixel (degrees and chroma ratios)
+struct RecolorShift
+{
+    float sourceHue = 0.0f;
+    float hueDelta = 0.0f;
+    float chromaRatio = 1.0f;
+    float inner = 0.0f, outer = 1.0f;  // hue distances where the weight starts and ends falling
+    float strength = 0.0f;             // 0 when nothing is selected
+};
+}
+
+static RecolorShift recolorShift(const RecolorParams& params)
+{
+    RecolorShift s;
+    glm::vec3 source = convertColor(ColorSpace::SRGB, ColorSpace::OKLCh, params.source);
+    glm::vec3 target = convertColor(ColorSpace::SRGB, ColorSpace::OKLCh, params.target);
+    // a gray source has no hue to select by
+    if (source.y < 2.0f * RECOLOR_MIN_CHROMA) return s;
+    s.sourceHue = source.z;
+    s.hueDelta = std::remainder(target.z - source.z, 360.0f);
+    // a gray target desaturates the selection; its hue doesn't matter then
+    s.chromaRatio = std::min(target.y / source.y, 4.0f);
+    s.inner = std::min(std::max(params.hueRange, 0.0f), 180.0f);
+    s.outer = s.inner + std::max(params.feather, 1.0f);
+    s.strength = std::min(std::max(params.strength, 0.0f), 1.0f);
+    return s;
+}
+
+bool recolorSelectsHue(const RecolorParams& params)
+{
+    return recolorShift(params).strength > 0.0f;
+}
+
+static float smoothstep(float edge0, float edge1, float x)
+{
+    float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// how much of the shift a pixel of this OKLCh chroma and hue gets
+static float recolorWeight(const RecolorShift& s, float chroma, float hue)
+{
+    if (s.strength <= 0.0f || chroma < RECOLOR_MIN_CHROMA) return 0.0f;
+    float distance = std::fabs(std::remainder(hue - s.sourceHue, 360.0f));
+    return s.strength * (1.0f - smoothstep(s.inner, s.outer, distance)) * smoothstep(RECOLOR_MIN_CHROMA, 2.0f * RECOLOR_MIN_CHROMA, chroma);
+}
+
+void recolorPixels(const RecolorParams& params, const uint8_t* in, uint8_t* out, size_t n)
+{
+    RecolorShift s = recolorShift(params);
+    if (s.strength <= 0.0f)
+    {
+        if (out != in) memmove(out, in, n * 3);
+        return;
+    }
+    std::vector<float> lch(n * 3);
+    std::vector<uint8_t> shifted(n * 3);
+    srgb8ToLinearBatch(in, lch.data(), n * 3);
+    convertColorsInterleaved(ColorSpace::LinearRGB, ColorSpace::OKLCh, lch.data(), lch.data(), n);
+    // a weight of zero marks a pixel that keeps its exact bytes
+    std::vector<float> weight(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        float* c = &lch[i * 3];
+        float w = recolorWeight(s, c[1], c[2]);
+        weight[i] = w;
+        c[1] *= 1.0f + w * (s.chromaRatio - 1.0f);
+        c[2] += w * s.hueDelta;
+    }
+    convertColorsInterleaved(ColorSpace::OKLCh, ColorSpace::LinearRGB, lch.data(), lch.data(), n);
+    linearToSrgb8Batch(lch.data(), shifted.data(), n * 3);
+    for (size_t i = 0; i < n; ++i)
+        if (weight[i] > 0.0f)
+            memcpy(out + i * 3, &shifted[i * 3], 3);
+        else if (out != in)
+            memcpy(out + i * 3, in + i * 3, 3);
+}
+
+// =======================================================
+// GLSL version
+// =======================================================
+
+#define GLSL_STRINGIFY_(x) #x
+#define GLSL_STRINGIFY(x) GLSL_STRINGIFY_(x)
+
+const char* recolor_glsl =
+"uniform vec4 uRecolor;      // source hue, hue shift (degrees), chroma ratio, strength\n"
+"uniform vec2 uRecolorRange; // hue distances where the weight starts and ends falling\n"
+"vec3 recolor(vec3 srgb)\n"
+"{\n"
+"    vec3 lin = mix(srgb / 12.92, pow((srgb + 0.055) / 1.055, vec3(2.4)), greaterThan(srgb, vec3(0.04045)));\n"
+"    vec3 lms = pow(mat3(0.4122214708, 0.2119034982, 0.0883024619,\n"
+"                        0.5363325363, 0.6806995451, 0.2817188376,\n"
+"                        0.0514459929, 0.1073969566, 0.6299787005) * lin, vec3(1.0 / 3.0));\n"
+"    vec3 lab = mat3(0.2104542553, 1.9779984951, 0.0259040371,\n"
+"                    0.7936177850, -2.4285922050, 0.7827717662,\n"
+"                    -0.0040720468, 0.4505937099, -0.8086757660) * lms;\n"
+"    float chroma = length(lab.yz);\n"
+"    if (uRecolor.w <= 0.0 || chroma < " GLSL_STRINGIFY(RECOLOR_MIN_CHROMA) ") return srgb;\n"
+"    float hue = degrees(atan(lab.z, lab.y));\n"
+"    float distance = abs(mod(hue - uRecolor.x + 180.0, 360.0) - 180.0);\n"
+"    float w = uRecolor.w * (1.0 - smoothstep(uRecolorRange.x, uRecolorRange.y, distance))\n"
+"            * smoothstep(" GLSL_STRINGIFY(RECOLOR_MIN_CHROMA) ", 2.0 * " GLSL_STRINGIFY(RECOLOR_MIN_CHROMA) ", chroma);\n"
+"    if (w <= 0.0) return srgb;\n"
+"    chroma *= 1.0 + w * (uRecolor.z - 1.0);\n"
+"    float h = radians(hue + w * uRecolor.y);\n"
+"    lms = lab.x + vec3(0.3963377774, -0.1055613458, -0.0894841775) * (chroma * cos(h))\n"
+"                + vec3(0.2158037573, -0.0638541728, -1.2914855480) * (chroma * sin(h));\n"
+"    lms = lms * lms * lms;\n"
+"    lin = clamp(mat3(4.0767416621, -1.2684380046, -0.0041960863,\n"
+"                     -3.3077115913, 2.6097574011, -0.7034186147,\n"
+"                     0.2309699292, -0.3413193965, 1.7076147010) * lms, 0.0, 1.0);\n"
+"    return mix(lin * 12.92, 1.055 * pow(lin, vec3(1.0 / 2.4)) - 0.055, greaterThan(lin, vec3(0.0031308)));\n"
+"}\n";
+
+void setRecolorUniforms(GLuint program, const RecolorParams& params)
+{
+    RecolorShift s = recolorShift(params);
+    glUniform4f(glGetUniformLocation(program, "uRecolor"), s.sourceHue, s.hueDelta, s.chromaRatio, s.strength);
+    glUniform2f(glGetUniformLocation(program, "uRecolorRange"), s.inner, s.outer);
+}
+
+// =======================================================
+// PNG encoding in parallel bands
+// =======================================================
+
+// copies row y of the image (width * 3 bytes of sRGB8) into rgb
+typedef std::function<void(int y, uint8_t* rgb)> RowSource;
+
+namespace
+{
+// one band of the output on its way to the file; the buffers keep their capacity between bands
+struct Band
+{
+    std::vector<uint8_t> rgb;         // recolored rows, starting with the row above the band
+    std::vector<uint8_t> filtered;    // filter type byte + filtered row, for each row
+    std::vector<uint8_t> candidates;  // scratch: the row under each of the five filters
+    std::vector<uint8_t> deflated;
+    uLong adler = 0;
+    bool ok = false;
+};
+}
+
+static uint8_t paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// filters one row (prev is the unfiltered row above, zeros for the first) with whichever of
+// the five PNG filters gives the smallest sum of absolute signed bytes, as libpng chooses
+static void filterRow(const uint8_t* row, const uint8_t* prev, size_t bytes, uint8_t* out, uint8_t* candidates)
+{
+    const size_t bpp = 3;
+    uint8_t* f[5];
+    for (int t = 0; t < 5; ++t) f[t] = candidates + t * bytes;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        int a = i >= bpp ? row[i - bpp] : 0, b = prev[i], c = i >= bpp ? prev[i - bpp] : 0;
+        f[0][i] = row[i];
+        f[1][i] = (uint8_t)(row[i] - a);
+        f[2][i] = (uint8_t)(row[i] - b);
+        f[3][i] = (uint8_t)(row[i] - ((a + b) >> 1));
+        f[4][i] = (uint8_t)(row[i] - paeth(a, b, c));
+    }
+    int best = 0;
+    uint64_t bestSum = UINT64_MAX;
+    for (int t = 0; t < 5; ++t)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < bytes; ++i) sum += (uint64_t)std::abs((int)(int8_t)f[t][i]);
+        if (sum < bestSum)
+        {
+            bestSum = sum;
+            best = t;
+        }
+    }
+    out[0] = (uint8_t)best;
+    memcpy(out + 1, f[best], bytes);
+}
+
+// recolors, filters and deflates rows [y0, y1); the last band finishes the deflate stream,
+// the others end with a sync flush so the next band's stream can follow on
+static void encodeBand(const RowSource& source, const RecolorParams& params, int width, int y0, int y1, bool last, Band& band)
+{
+    size_t stride = (size_t)width * 3;
+    // the row above is recolored too: the Up, Average and Paeth filters refer to it
+    int first = y0 > 0 ? y0 - 1 : y0;
+    size_t rows = y1 - first;
+    band.rgb.resize((rows + 1) * stride);
+    for (int y = first; y < y1; ++y)
+        source(y, &band.rgb[(y - first) * stride]);
+    recolorPixels(params, band.rgb.data(), band.rgb.data(), rows * width);
+    // the image's first row is filtered against zeros, kept past the band's rows
+    uint8_t* zeros = &band.rgb[rows * stride];
+    memset(zeros, 0, stride);
+
+    band.filtered.resize((size_t)(y1 - y0) * (stride + 1));
+    band.candidates.resize(5 * stride);
+    for (int y = y0; y < y1; ++y)
+    {
+        const uint8_t* row = &band.rgb[(y - first) * stride];
+        const uint8_t* prev = y > 0 ? row - stride : zeros;
+        filterRow(row, prev, stride, &band.filtered[(size_t)(y - y0) * (stride + 1)], band.candidates.data());
+    }
+    band.adler = adler32(adler32(0L, Z_NULL, 0), band.filtered.data(), (uInt)band.filtered.size());
+
+    // raw deflate (no zlib header), as libpng compresses by default
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    band.ok = false;
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_FILTERED) != Z_OK) return;
+    band.deflated.resize(deflateBound(&zs, band.filtered.size()) + 16);
+    zs.next_in = band.filtered.data();
+    zs.avail_in = (uInt)band.filtered.size();
+    zs.next_out = band.deflated.data();
+    zs.avail_out = (uInt)band.deflated.size();
+    int status = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+    band.ok = zs.avail_in == 0 && (last ? status == Z_STREAM_END : status == Z_OK);
+    band.deflated.resize(zs.total_out);
+    deflateEnd(&zs);
+}
+
+static void putBigEndian(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// one PNG chunk whose data is prefix followed by data
+static bool writeChunk(FILE* file, const char* type, const uint8_t* prefix, size_t prefixSize, const uint8_t* data, size_t size)
+{
+    uint8_t head[8], tail[4];
+    putBigEndian(head, (uint32_t)(prefixSize + size));
+    memcpy(head + 4, type, 4);
+    uLong crc = crc32(0L, head + 4, 4);
+    if (prefixSize) crc = crc32(crc, prefix, (uInt)prefixSize);
+    if (size) crc = crc32(crc, data, (uInt)size);
+    putBigEndian(tail, (uint32_t)crc);
+    return fwrite(head, 1, 8, file) == 8 && (!prefixSize || fwrite(prefix, 1, prefixSize, file) == prefixSize)
+        && (!size || fwrite(data, 1, size, file) == size) && fwrite(tail, 1, 4, file) == 4;
+}
+
+// pool null encodes on the calling thread alone
+static bool writeRecoloredPng(const RowSource& source, int width, int height, const RecolorParams& params, const std::string& path,
+    ThreadPool* pool)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::RECOLOR::OPEN_FAILED " << path << std::endl;
+        return false;
+    }
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    uint8_t ihdr[13];
+    putBigEndian(ihdr, (uint32_t)width);
+    putBigEndian(ihdr + 4, (uint32_t)height);
+    ihdr[8] = 8;   // bit depth
+    ihdr[9] = 2;   // RGB
+    ihdr[10] = 0;  // deflate
+    ihdr[11] = 0;  // adaptive filtering
+    ihdr[12] = 0;  // not interlaced
+    bool ok = fwrite(SIGNATURE, 1, 8, file) == 8 && writeChunk(file, "IHDR", nullptr, 0, ihdr, 13);
+
+    // one band per thread is encoded at a time; they are written in order once all are done
+    int bands = (height + RECOLOR_BAND_ROWS - 1) / RECOLOR_BAND_ROWS;
+    std::vector<Band> group(pool ? pool->size() : 1);
+    static const uint8_t ZLIB_HEADER[2] = { 0x78, 0x9c };
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (int b0 = 0; b0 < bands && ok; b0 += (int)group.size())
+    {
+        int count = std::min((int)group.size(), bands - b0);
+        auto encode = [&](size_t i) {
+            int b = b0 + (int)i;
+            int y0 = b * RECOLOR_BAND_ROWS, y1 = std::min(y0 + RECOLOR_BAND_ROWS, height);
+            encodeBand(source, params, width, y0, y1, b == bands - 1, group[i]);
+        };
+        if (pool)
+            pool->parallelFor(count, encode);
+        else
+            encode(0);
+        for (int i = 0; i < count && ok; ++i)
+        {
+            Band& band = group[i];
+            ok = band.ok && writeChunk(file, "IDAT", b0 + i == 0 ? ZLIB_HEADER : nullptr, b0 + i == 0 ? 2 : 0, band.deflated.data(),
+                band.deflated.size());
+            adler = adler32_combine(adler, band.adler, (z_off_t)band.filtered.size());
+        }
+    }
+    uint8_t trailer[4];
+    putBigEndian(trailer, (uint32_t)adler);
+    ok = ok && writeChunk(file, "IDAT", nullptr, 0, trailer, 4) && writeChunk(file, "IEND", nullptr, 0, nullptr, 0);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) std::cout << "ERROR::RECOLOR::WRITE_FAILED " << path << std::endl;
+    return ok;
+}
+
+bool exportRecolored(const ImagePyramid& image, const RecolorParams& params, const std::string& path)
+{
+    if (!image.isOpen() || image.rowsDone(0) < image.height())
+    {
+        std::cout << "ERROR::RECOLOR::IMAGE_NOT_READY" << std::endl;
+        return false;
+    }
+    // level 0 rows straight from the mapped tiles; bands never straddle a tile row
+    static_assert(PYRAMID_TILE_SIZE % RECOLOR_BAND_ROWS == 0, "export bands must not straddle tile rows");
+    const PyramidLevel& lv = image.level(0);
+    RowSource source = [&](int y, uint8_t* rgb) {
+        const int S = PYRAMID_TILE_SIZE;
+        for (uint32_t tx = 0; tx < lv.tilesX; ++tx)
+        {
+            int columns = std::min(S, (int)lv.width - (int)tx * S);
+            memcpy(rgb + (size_t)tx * S * 3, image.tile(0, tx, y / S) + (size_t)(y % S) * S * 3, (size_t)columns * 3);
+        }
+    };
+    return writeRecoloredPng(source, image.width(), image.height(), params, path, &sharedThreadPool());
+}
+
+// =======================================================
+// Benchmark
+// =======================================================
+
+// the same recolor written row by row through libpng, for comparison
+static bool writeWithLibpng(const RowSource& source, int width, int height, const RecolorParams& params, const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    std::vector<uint8_t> row((size_t)width * 3);
+    bool ok = png && info && !setjmp(png_jmpbuf(png));
+    if (ok)
+    {
+        png_init_io(png, file);
+        png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+            PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png, info);
+        for (int y = 0; y < height; ++y)
+        {
+            source(y, row.data());
+            recolorPixels(params, row.data(), row.data(), width);
+            png_write_row(png, row.data());
+        }
+        png_write_end(png, nullptr);
+    }
+    if (png) png_destroy_write_struct(&png, info ? &info : nullptr);
+    return fclose(file) == 0 && ok;
+}
+
+// hues across, lightness down, with some grain so it compresses like a photo
+static std::vector<uint8_t> syntheticImage(int width, int height)
+{
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    sharedThreadPool().parallelFor(height, [&](size_t y) {
+        uint32_t seed = (uint32_t)y * 2654435761u + 1;
+        for (int x = 0; x < width; ++x)
+        {
+            glm::vec3 c = HSVtoRGB(360.0f * x / width, 0.75f, 0.3f + 0.7f * (float)y / height);
+            for (int k = 0; k < 3; ++k)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                int v = (int)(c[k] * 255.0f + 0.5f) + (int)(seed >> 29) - 4;
+                rgb[((size_t)y * width + x) * 3 + k] = (uint8_t)std::min(std::max(v, 0), 255);
+            }
+        }
+    });
+    return rgb;
+}
+
+void benchmarkRecolor()
+{
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); };
+    RecolorParams params;
+    params.source = glm::vec3(0.9f, 0.2f, 0.2f);
+    params.target = glm::vec3(0.2f, 0.4f, 0.9f);
+    std::string path = (std::filesystem::temp_directory_path() / "rgbpick_bench_recolor.png").string();
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Recolor export, " << hardware << " hardware threads" << std::endl;
+    char line[160];
+
+    struct Size { const char* name; int width, height; };
+    const Size sizes[] = { { "4K 3840x2160", 3840, 2160 }, { "24MP 6000x4000", 6000, 4000 } };
+    for (const Size& size : sizes)
+    {
+        std::vector<uint8_t> image = syntheticImage(size.width, size.height);
+        size_t pixels = (size_t)size.width * size.height;
+        size_t stride = (size_t)size.width * 3;
+        RowSource source = [&](int y, uint8_t* rgb) { memcpy(rgb, &image[y * stride], stride); };
+
+        std::vector<uint8_t> out(image.size());
+        Clock::time_point t0 = Clock::now();
+        sharedThreadPool().parallelFor(size.height, [&](size_t y) {
+            recolorPixels(params, &image[y * stride], &out[y * stride], size.width);
+        });
+        double recolorTime = seconds(t0);
+        snprintf(line, sizeof(line), "  %-15s recolor only (%u threads) %8.1f ms  %6.1f Mpx/s", size.name, sharedThreadPool().size(),
+            recolorTime * 1e3, pixels / recolorTime * 1e-6);
+        std::cout << line << std::endl;
+
+        t0 = Clock::now();
+        writeWithLibpng(source, size.width, size.height, params, path);
+        double libpngTime = seconds(t0);
+        snprintf(line, sizeof(line), "  %-15s libpng, 1 thread          %8.1f ms  %6.1f Mpx/s  %6.1f MB", size.name, libpngTime * 1e3,
+            pixels / libpngTime * 1e-6, std::filesystem::file_size(path) / 1e6);
+        std::cout << line << std::endl;
+
+        std::vector<unsigned> threadCounts;
+        for (unsigned threads = 1; threads < hardware; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(hardware);
+        for (unsigned threads : threadCounts)
+        {
+            // a pool of threads - 1 workers plus the caller; one thread is the caller alone
+            std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+            t0 = Clock::now();
+            writeRecoloredPng(source, size.width, size.height, params, path, pool.get());
+            double time = seconds(t0);
+            snprintf(line, sizeof(line), "  %-15s banded, %2u threads         %8.1f ms  %6.1f Mpx/s  %6.1f MB", size.name, threads, time * 1e3,
+                pixels / time * 1e-6, std::filesystem::file_size(path) / 1e6);
+            std::cout << line << std::endl;
+        }
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "image_pyramid.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// =======================================================
+// Recoloring an image towards the picked color
+// =======================================================
+
+// rows per unit of export work: each band is recolored, filtered and compressed on its own
+#define RECOLOR_BAND_ROWS 64
+
+// Selects the pixels whose OKLCH hue lies near the source color's and moves them towards the
+// target: hue rotated by the difference between the two hues, chroma scaled by their ratio,
+// lightness kept, so shading and texture survive. Pixels within hueRange degrees of the source
+// hue are shifted fully, the shift fades out over the next feather degrees, and near-gray
+// pixels (whose hue means little) are left alone. A gray source selects nothing
+struct RecolorParams
+{
+    glm::vec3 source = glm::vec3(1.0f, 0.0f, 0.0f);  // sRGB
+    glm::vec3 target = glm::vec3(1.0f, 0.0f, 0.0f);  // sRGB, the picked color
+    float hueRange = 30.0f;
+    float feather = 20.0f;
+    float strength = 1.0f;  // 0 leaves the image as it is
+};
+
+// false when the source is too gray to have a hue, so nothing would change
+bool recolorSelectsHue(const RecolorParams& params);
+
+// GLSL prelude with vec3 recolor(vec3 srgb) and its uniforms, for fragment shaders that show
+// the image (the eyedropper's "image_recolor" program); same math as recolorPixels
+extern const char* recolor_glsl;
+// sets the prelude's uniforms on the program in use
+void setRecolorUniforms(GLuint program, const RecolorParams& params);
+
+// recolors n sRGB8 pixels; out may alias in
+void recolorPixels(const RecolorParams& params, const uint8_t* in, uint8_t* out, size_t n);
+
+// writes the full-resolution image, recolored, as an RGB8 PNG. Bands of RECOLOR_BAND_ROWS rows
+// are recolored, PNG-filtered and deflated independently on all cores (each band ends on a
+// byte boundary with a sync flush, so the pieces concatenate into one zlib stream), then
+// written in order; memory use is one band per thread whatever the image size. False (with an ERROR line) if the pyramid isn't complete or the file can't be written
+bool exportRecolored(const ImagePyramid& image, const RecolorParams& params, const std::string& path);
+
+// recolors and exports synthetic images at increasing thread counts, against libpng on one
+// thread (--bench-recolor)
+void benchmarkRecolor();
@@ -0,0 +1,165 @@
+#include "render_bench.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// =======================================================
+// Allocation counting
+// =======================================================
+
+static std::atomic<bool> countingAllocations(false);
+static std::atomic<size_t> allocationCount(0);
+
+// replaces the global operator new for the whole binary; off a timed run it costs one relaxed load
+void* operator new(std::size_t size)
+{
+    if (countingAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    for (;;)
+    {
+        if (void* p = malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+// kept out of line: inlined into this file's containers, it makes GCC pair free() with operator new
+// and warn (-Wmismatched-new-delete)
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+// =======================================================
+// Scenarios
+// =======================================================
+
+static const char* scenarioNames[] = { "static", "dragging", "resizing", "labels" };
+
+bool parseRenderScenario(const std::string& name, RenderScenario& scenario)
+{
+    for (int i = 0; i < 4; ++i)
+        if (name == scenarioNames[i])
+        {
+            scenario = (RenderScenario)i;
+            return true;
+        }
+    return false;
+}
+
+const char* renderScenarioName(RenderScenario scenario)
+{
+    return scenarioNames[(int)scenario];
+}
+
+// one turn of the drag or the resize takes this many frames
+static const int SCENARIO_PERIOD = 120;
+
+ScenarioFrame scenarioFrame(RenderScenario scenario, int frame, int width, int height)
+{
+    ScenarioFrame f;
+    float t = 2.0f * 3.1415926f * (frame % SCENARIO_PERIOD) / SCENARIO_PERIOD;
+    if (scenario == RenderScenario::Dragging)
+    {
+        // around the wheel's center (the middle of the window) at 20% to 80% of its radius,
+        // so hue and saturation both change every frame
+        float r = 0.3f + 0.18f * std::sin(3.0f * t);
+        f.move = true;
+        f.cursorX = width * 0.5 * (1.0 + r * std::cos(t));
+        f.cursorY = height * 0.5 * (1.0 - r * std::sin(t));
+        f.press = frame == 0;
+    }
+    else if (scenario == RenderScenario::Resizing)
+    {
+        // between 600 and 1000 pixels, the two sides out of step
+        f.width = 800 + (int)std::lround(200.0f * std::sin(t));
+        f.height = 800 + (int)std::lround(200.0f * std::cos(t));
+    }
+    return f;
+}
+
+static const int LABEL_COLUMNS = 8, LABEL_ROWS = 16;
+
+void scenarioLabels(int frame, float width, float height, std::vector<ScenarioLabel>& labels)
+{
+    labels.resize(LABEL_COLUMNS * LABEL_ROWS);
+    for (int i = 0; i < (int)labels.size(); ++i)
+    {
+        // every fourth label shows a new value each frame, so the text run cache keeps missing
+        // for some of them, as it does for live readouts
+        unsigned int value = (i % 4 == frame % 4) ? (i * 2654435761u + frame * 40503u) & 0xffffff : i * 0x020408u & 0xffffff;
+        char text[8];
+        snprintf(text, sizeof(text), "#%06x", value);
+        labels[i].text = text;
+        labels[i].x = (i % LABEL_COLUMNS + 0.1f) * width / LABEL_COLUMNS;
+        labels[i].y = (i / LABEL_COLUMNS + 1.0f) * height / (LABEL_ROWS + 1);
+    }
+}
+
+// =======================================================
+// Timed runs
+// =======================================================
+
+void RenderBenchRun::begin(int count)
+{
+    frames = count;
+    frameTimes.clear();
+    frameTimes.reserve(count);
+    lastFrame = glfwGetTime();
+    allocationsAtStart = allocationCount.load();
+    countingAllocations = true;
+}
+
+void RenderBenchRun::frameDone()
+{
+    if (done()) return;
+    double now = glfwGetTime();
+    frameTimes.push_back(now - lastFrame);
+    lastFrame = now;
+    if (done())
+    {
+        countingAllocations = false;
+        allocations = allocationCount.load() - allocationsAtStart;
+    }
+}
+
+void RenderBenchRun::report() const
+{
+    if (frameTimes.empty()) return;
+    double total = 0.0;
+    for (double t : frameTimes) total += t;
+    std::vector<double> sorted(frameTimes);
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    printf("  %.1f fps, %.3f ms/frame (median %.3f, p99 %.3f, max %.3f) over %zu frames\n", n / total, total * 1000.0 / n,
+        sorted[n / 2] * 1000.0, sorted[std::min(n - 1, n * 99 / 100)] * 1000.0, sorted[n - 1] * 1000.0, n);
+    printf("  %.2f allocations per frame (%zu in all)\n", (double)allocations / n, allocations);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// =======================================================
+// Render benchmark (--bench-render): scripted frame loop
+// =======================================================
+
+// what the window goes through while the frame loop is timed
+enum class RenderScenario
+{
+    Static,    // nothing changes between frames
+    Dragging,  // the left button held on the wheel, circling its center
+    Resizing,  // the window grows and shrinks a little every frame
+    Labels,    // a screenful of extra text labels, a quarter of them new every frame
+};
+
+// "static", "dragging", "resizing" or "labels"
+bool parseRenderScenario(const std::string& name, RenderScenario& scenario);
+const char* renderScenarioName(RenderScenario scenario);
+
+// the input of one scripted frame, in window pixels; the frame loop feeds it through the app's
+// callbacks, so picking and layout run exactly as for real events
+struct ScenarioFrame
+{
+    bool press = false;    // left button
+    bool move = false;
+    double cursorX = 0.0, cursorY = 0.0;
+    int width = 0, height = 0;  // new window size, 0 keeps it
+};
+// frame counts from 0 at the first frame; width and height are the current window size
+ScenarioFrame scenarioFrame(RenderScenario scenario, int frame, int width, int height);
+
+// extra text drawn by the Labels scenario, in UI units
+struct ScenarioLabel
+{
+    std::string text;
+    float x, y;
+};
+// fills labels for a frame of a width x height (UI units) window, reusing their storage
+void scenarioLabels(int frame, float width, float height, std::vector<ScenarioLabel>& labels);
+
+// Frame times and allocations of one timed run. Allocations are operator new calls on any thread
+// (the binary's global operator new counts them while a run is open); what drivers allocate
+// with malloc isn't seen
+class RenderBenchRun
+{
+public:
+    void begin(int frames);
+    // call once a frame has been swapped
+    void frameDone();
+    bool done() const { return (int)frameTimes.size() >= frames; }
+    // fps, frame time percentiles and allocations per frame
+    void report() const;
+
+private:
+    int frames = 0;
+    std::vector<double> frameTimes;
+    double lastFrame = 0.0;
+    size_t allocationsAtStart = 0, allocations = 0;
+};
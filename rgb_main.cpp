@@ -1,430 +1,1402 @@
-#include <glad/glad.h>
-#include<GLFW/glfw3.h>
-#include<glm/glm.hpp>
-#include<stdexcept>
-#include<iostream>
-#include<cmath>
-#include<vector>
-#include<string>
-#include "text_render.hpp"
-
-#define radius 0.6f
-//callback function to adjust the viewport when the window size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
-}
-//process all input and can be added more features later
-void processInput(GLFWwindow* window) {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, true);
-}
-//function to generate circle vertices
-std::vector<float> generateVerices_rgb_Circle(int num) {
-	std::vector<float> vertices;
-	vertices.push_back(0.0f); // Center vertex x
-	vertices.push_back(0.0f); // Center vertex y
-	vertices.push_back(0.0f); // Center vertex z
-	for(int i=0; i <= num; ++i) {
-		float angle = 2.0f * 3.1415926f * float(i) / float(num);
-		float x = radius*cosf(angle);
-		vertices.push_back(x);
-		float y = radius*sinf(angle);
-		vertices.push_back(y);
-		float z = 0.0f;
-		vertices.push_back(z);
-		// Store vertex positions
-	}
-	return vertices;
-}
-//function to check if the point is inside the circle
-bool is_inside_circle(float x, float y) {
-	return (x * x + y * y) <= (radius * radius);
-}
-//function to check if the point is inside the alpha box
-bool is_inside_alpha_box(float x, float y) {
-	return (x >= 0.8f && x <= 0.9f &&
-		y >= -0.8f && y <= 0.8f);
-}
-//function to convert screen coordinates to NDC
-void screenToNDC(GLFWwindow* window, double xpos, double ypos, float& ndcx, float& ndcy) {
-	int width, height;
-	glfwGetFramebufferSize(window, &width, &height);
-	ndcx = static_cast<float>((xpos / width) * 2.0 - 1.0);
-	ndcy = static_cast<float>(1.0 - (ypos / height) * 2.0);
-}
-//a global variable to store the triangle y offset
-float triangleYoffset = 0.0f;
-//function to calculate alpha value based on y position
-float calculateAlphaValue(float ypos) {
-	if (ypos < -0.8f) {
-		return 0.0f;
-	}
-	if (ypos > 0.8f) {
-		return 1.0f;
-	}
-	float a = (ypos + 0.8f) / 1.6f;
-	return a;
-}
-//a global variable to store the final color
-glm::vec4 finalColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-//HSV to RGB conversion function
-glm::vec3 HSVtoRGB(float H, float S, float V) {
-	float C = V * S;
-	float X = C * (1.0f - fabsf(fmodf(H / 60.0f, 2.0f) - 1.0f));
-	float m = V - C;
-	float r, g, b;
-	if (H >= 0 && H < 60) {
-		r = C; g = X; b = 0;
-	}
-	else if (H >= 60 && H < 120) {
-		r = X; g = C; b = 0;
-	}
-	else if (H >= 120 && H < 180) {
-		r = 0; g = C; b = X;
-	}
-	else if (H >= 180 && H < 240) {
-		r = 0; g = X; b = C;
-	}
-	else if (H >= 240 && H < 300) {
-		r = X; g = 0; b = C;
-	}
-	else {
-		r = C; g = 0; b = X;
-	}
-	return glm::vec3(r + m, g + m, b + m);
-}
-
-//call back function
-void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
-	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-		double sx, sy;
-		glfwGetCursorPos(window, &sx, &sy);
-		float x, y;
-		screenToNDC(window, sx, sy, x, y);
-		if (is_inside_alpha_box(x, y)) {
-			//std::cout << "Rectangle clicked!" << std::endl;
-			triangleYoffset = y;
-			float alphaValue = calculateAlphaValue(y);
-			finalColor.a = alphaValue;
-			//std::cout << "Alpha Value: " << alphaValue << std::endl;
-		}
-		if (is_inside_circle(x, y)) {
-			//std::cout << "Circle clicked!" << std::endl;
-			float angle = atan2(y, x);
-			float hue = (angle + 3.1415926f) / (2.0f * 3.1415926f);
-			float in_radius = sqrt(x * x + y * y);
-			float saturation = in_radius / radius;
-			saturation = std::min(std::max(saturation, 0.0f), 1.0f);
-			float value = 1.0f;
-			glm::vec3 rgb = HSVtoRGB(hue * 360.0f, saturation, value);
-			finalColor.r = rgb.r;
-			finalColor.g = rgb.g;
-			finalColor.b = rgb.b;
-		}
-	}
-}
-//shader sources
-const char* circle_vs_shader = "#version 330 core\n"
-"layout(location = 0) in vec3 aPos;\n"
-"out vec3 vPos;\n"
-"void main()\n"
-"{\n"
-"    vPos = aPos;\n"
-"    gl_Position = vec4(aPos, 1.0);\n"
-"}\n";
-
-const char* circle_fs_shader = "#version 330 core\n"
-"in vec3 vPos;\n"
-"out vec4 FragColor;\n"
-"vec3 hsv2rgb(vec3 c)\n"
-"{\n"
-"    vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);\n"
-"    vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);\n"
-"    return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);\n"
-"}\n"
-"void main()\n"
-"{\n"
-"    float radius = length(vPos.xy);\n"
-"	if (radius>0.6)discard;\n"
-"    float angle = atan(vPos.y, vPos.x);\n"
-"    float hue = (angle + 3.1415926) / (2.0 * 3.1415926);\n"
-"    float saturation = clamp(radius/0.6f,0.0f,1.0f);\n"
-"    float value = 1.0;\n"
-"    vec3 rgb = hsv2rgb(vec3(hue, saturation, value));\n"
-"    FragColor = vec4(rgb, 1.0);\n"
-"}\n";
-
-const char* ui_vs_shader = "#version 330 core\n"
-"layout(location = 0) in vec3 aPos;\n"
-"layout(location = 1) in vec3 aColor;\n"
-"uniform float offSetY;\n"
-"out vec3 vColor;\n"
-"void main()\n"
-"{\n"
-"    vColor = aColor;\n"
-"    vec3 pos = aPos;\n"
-"    pos.y += offSetY;\n"
-"    gl_Position = vec4(pos, 1.0);\n"
-"}\n";
-
-const char* ui_fs_shader = "#version 330 core\n"
-"in vec3 vColor;\n"
-"out vec4 FragColor;\n"
-"void main()\n"
-"{\n"	
-"    FragColor = vec4(vColor, 1.0f);\n"
-"}\n";
-
-const char* final_box_vs_shader = "#version 330 core\n"
-"layout(location = 0) in vec3 aPos;\n"
-"void main()\n"
-"{\n"
-"gl_Position = vec4(aPos, 1.0);\n"
-"}\n";
-
-const char* final_box_fs_shader = "#version 330 core\n"
-"out vec4 FragColor;\n"
-"uniform vec4 uColor;\n"
-"void main()\n"
-"{\n"
-"FragColor = uColor;\n"
-"}\n";	
-
-int main() {
-	std::cout << "A brief description of the project: \n";
-	std::cout << "A fully GPU-driven RGB color picker built using modern OpenGL, implementing an HSV color wheel, interactive alpha adjustment, and real-time RGBA visualization. \nThe project has shader programming, custom UI rendering, mouse input processing, coordinate transformations, alpha blending, and font rendering, all without relying on external UI libraries";
-	
-	if (!glfwInit()) {
-		throw std::runtime_error("Failed to initialize GLFW terminating it!");
-	}
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	GLFWwindow* window = glfwCreateWindow(800, 800, "RGB circle", NULL, NULL);
-	if (window == NULL) {
-		glfwTerminate();
-		throw std::runtime_error("Failed to create GLFW window");
-	}
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetMouseButtonCallback(window, mouse_button_callback);
-	if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress))) {
-		glfwTerminate();
-		throw std::runtime_error("Failed to initialize GLAD");
-	}
-	// enable blending
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	// generate circle vertices
-	std::vector<float> vertices=generateVerices_rgb_Circle(360);
-	// set up circle graphics pipeline
-	unsigned int circle_VBO, circle_VAO;
-	glGenVertexArrays(1, &circle_VAO);
-	glGenBuffers(1, &circle_VBO);
-	glBindVertexArray(circle_VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, circle_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	unsigned int circle_vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(circle_vertexShader, 1, &circle_vs_shader, NULL);
-	glCompileShader(circle_vertexShader);
-	int success;
-	char infoLog[1024];
-	glGetShaderiv(circle_vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(circle_vertexShader, 1024, NULL, infoLog);
-		std::cout << "ERROR::SHADER::CIRCLE_VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	unsigned int circle_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(circle_fragmentShader, 1, &circle_fs_shader, NULL);
-	glCompileShader(circle_fragmentShader);
-	glGetShaderiv(circle_fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(circle_fragmentShader, 1024, NULL, infoLog);
-		std::cout << "ERROR::SHADER::CIRCLE_FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	unsigned int circle_shaderProgram = glCreateProgram();
-	glAttachShader(circle_shaderProgram, circle_vertexShader);
-	glAttachShader(circle_shaderProgram, circle_fragmentShader);
-	glLinkProgram(circle_shaderProgram);
-	glGetProgramiv(circle_shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(circle_shaderProgram, 1024, NULL, infoLog);
-		std::cout << "ERROR::SHADER::CIRCLE_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-	}
-	glDeleteShader(circle_vertexShader);
-	glDeleteShader(circle_fragmentShader);
-	// set up alpha box graphics pipeline
-	std::vector<float> alpha_box_vertices = {
-		0.8f, 0.8f, 0.0f, 1.0f,1.0f,1.0f,
-		0.8f, -0.8f, 0.0f, 0.0f,0.0f,0.0f,
-		0.9f, -0.8f, 0.0f, 0.0f,0.0f,0.0f,
-		0.9f, 0.8f, 0.0f, 1.0f,1.0f,1.0f,
-	};
-	std::vector<unsigned int>indices={
-		0,1,2,
-		2,3,0
-	};
-	unsigned int alpha_box_VBO,alpha_box_VAO;
-	glGenVertexArrays(1, &alpha_box_VAO);
-	glGenBuffers(1, &alpha_box_VBO);
-	glBindVertexArray(alpha_box_VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, alpha_box_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * alpha_box_vertices.size(), alpha_box_vertices.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	unsigned int alpha_box_EBO;
-	glGenBuffers(1, &alpha_box_EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, alpha_box_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
-	unsigned int alpha_box_vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(alpha_box_vertexShader, 1, &ui_vs_shader, NULL);
-	glCompileShader(alpha_box_vertexShader);
-	glGetShaderiv(alpha_box_vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(alpha_box_vertexShader, 1024, NULL, infoLog);
-		std::cout << "ERROR::ALpha_box_SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	unsigned int alpha_box_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(alpha_box_fragmentShader, 1, &ui_fs_shader, NULL);
-	glCompileShader(alpha_box_fragmentShader);
-	glGetShaderiv(alpha_box_fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(alpha_box_fragmentShader, 1024, NULL, infoLog);
-		std::cout << "ERROR::ALPHA_BOX_SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	unsigned int ui_shaderProgram = glCreateProgram();
-	glAttachShader(ui_shaderProgram, alpha_box_vertexShader);
-	glAttachShader(ui_shaderProgram, alpha_box_fragmentShader);
-	glLinkProgram(ui_shaderProgram);
-	glGetProgramiv(ui_shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(ui_shaderProgram, 1024, NULL, infoLog);
-		std::cout << "ERROR::SHADER::ALPHA_BOX_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-	}
-	// set up alpha triangle graphics pipeline
-	std::vector<float>alpha_triangle = {
-		0.75f, 0.8f, 0.0f,  137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f,
-		0.75f, 0.7f, 0.0f,  137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f,
-		0.8f, 0.75f, 0.0f,   137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f
-	};
-	unsigned int alpha_triangle_VBO, alpha_triangle_VAO;
-	glGenVertexArrays(1, &alpha_triangle_VAO);
-	glGenBuffers(1, &alpha_triangle_VBO);
-	glBindVertexArray(alpha_triangle_VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, alpha_triangle_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * alpha_triangle.size(), alpha_triangle.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	// set up final output box graphics pipeline
-	std::vector<float> output_box_vertices = {
-		-0.5f, -0.8f, 0.0f,
-		-0.5f, -0.9f, 0.0f,
-		 0.5f, -0.9f, 0.0f,
-		 0.5f, -0.8f, 0.0f,
-	};
-	std::vector<unsigned int>output_indices = {
-		0,1,2,
-		2,3,0
-	};
-	unsigned int output_box_VBO, output_box_VAO;
-	glGenVertexArrays(1, &output_box_VAO);
-	glGenBuffers(1, &output_box_VBO);
-	glBindVertexArray(output_box_VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, output_box_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * output_box_vertices.size(), output_box_vertices.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	unsigned int output_box_EBO;
-	glGenBuffers(1, &output_box_EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, output_box_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)* output_indices.size(), output_indices.data(), GL_STATIC_DRAW);
-	unsigned int output_box_vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(output_box_vertexShader, 1, &final_box_vs_shader, NULL);
-	glCompileShader(output_box_vertexShader);
-	glGetShaderiv(output_box_vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(output_box_vertexShader, 1024, NULL, infoLog);
-		std::cout << "ERROR::OUTPUT_BOX_SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	unsigned int output_box_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(output_box_fragmentShader, 1, &final_box_fs_shader, NULL);
-	glCompileShader(output_box_fragmentShader);
-	glGetShaderiv(output_box_fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(output_box_fragmentShader, 1024, NULL, infoLog);
-		std::cout << "ERROR::OUTPUT_BOX_SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	unsigned int output_box_shaderProgram = glCreateProgram();
-	glAttachShader(output_box_shaderProgram, output_box_vertexShader);
-	glAttachShader(output_box_shaderProgram, output_box_fragmentShader);
-	glLinkProgram(output_box_shaderProgram);
-	glGetProgramiv(output_box_shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(output_box_shaderProgram, 1024, NULL, infoLog);
-		std::cout << "ERROR::SHADER::OUTPUT_BOX_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-	}
-	// clean up shaders
-	glDeleteShader(alpha_box_vertexShader);
-	glDeleteShader(alpha_box_fragmentShader);
-	glDeleteShader(output_box_vertexShader);
-	glDeleteShader(output_box_fragmentShader);
-	// initialize text rendering
-	int width, height;
-	glfwGetWindowSize(window, &width, &height);
-	initText(width,height) ;
-
-	// render
-	while (!glfwWindowShouldClose(window))
-	{
-		processInput(window);
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-		// draw circle
-		glUseProgram(circle_shaderProgram);
-		glBindVertexArray(circle_VAO);          
-		glDrawArrays(GL_TRIANGLE_FAN, 0, vertices.size() / 3);
-
-		// draw alpha box
-		glUseProgram(ui_shaderProgram);
-		GLuint offSetYLocation = glGetUniformLocation(ui_shaderProgram, "offSetY");
-		glUniform1f(offSetYLocation, 0.0f);
-		
-		glBindVertexArray(alpha_box_VAO);       
-		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-
-		// draw alpha triangle
-		glUniform1f(offSetYLocation, triangleYoffset-0.75f);
-		glBindVertexArray(alpha_triangle_VAO);
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(alpha_triangle.size() / 6));
-
-		// draw output box
-		glUseProgram(output_box_shaderProgram);
-		glUniform4f(
-			glGetUniformLocation(output_box_shaderProgram, "uColor"),
-			finalColor.r, finalColor.g, finalColor.b, finalColor.a
-		);
-
-		glBindVertexArray(output_box_VAO);
-		glDrawElements(GL_TRIANGLES, output_indices.size(), GL_UNSIGNED_INT, 0);
-		// render text
-		renderText("R:"+std::to_string(finalColor.r), 20, 20, 1.0f, 1.0f, 1.0f, 1.0f);
-		renderText("G:"+std::to_string(finalColor.g), 20, 40, 1.0f, 1.0f, 1.0f, 1.0f);
-		renderText("B:" + std::to_string(finalColor.b), 20, 60, 1.0f, 1.0f, 1.0f, 1.0f);
-		renderText("A:" + std::to_string(finalColor.a), 20, 80, 1.0f, 1.0f, 1.0f, 1.0f);
-		glfwSwapBuffers(window);
-		glfwPollEvents();
-	}
-	glfwTerminate();
-	// Free memory
-	std::vector<float>().swap(vertices); 
-	std::vector<float>().swap(alpha_box_vertices); 
-	std::vector<float>().swap(alpha_triangle); 
-	std::vector<float>().swap(output_box_vertices);
-	return 0;
-}
\ No newline at end of file
+#include <glad/glad.h>
+#include<GLFW/glfw3.h>
+#include<glm/glm.hpp>
+#include<stdexcept>
+#include<iostream>
+#include<cmath>
+#include<vector>
+#include<memory>
+#include<string>
+#include<cstdio>
+#include<cstdlib>
+#include "text_render.hpp"
+#include "shader_manager.hpp"
+#include "frame_stats.hpp"
+#include "wheel_cache.hpp"
+#include "fast_math.hpp"
+#include "color_transfer.hpp"
+#include "color_spaces.hpp"
+#include "oklch_wheel.hpp"
+#include "named_colors.hpp"
+#include "delta_e.hpp"
+#include "eyedropper.hpp"
+#include "palette_extract.hpp"
+#include "hue_histogram.hpp"
+#include "color_history.hpp"
+#include "palette_library.hpp"
+#include "recolor.hpp"
+#include "render_bench.hpp"
+#include "golden_test.hpp"
+#include "self_check.hpp"
+#include "frame_pacing.hpp"
+
+#define radius 0.6f
+//render-on-change pacing: callbacks that change what is shown ask for another frame
+bool redrawRequested = true;
+//callback function to adjust the viewport and text projection when the window size changes
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	redrawRequested = true;
+	glViewport(0, 0, width, height);
+	float xscale, yscale;
+	glfwGetWindowContentScale(window, &xscale, &yscale);
+	resizeText(width, height, xscale);
+}
+//callback function to re-rasterize text when the window moves to a monitor with a different pixel density
+void content_scale_callback(GLFWwindow* window, float xscale, float yscale) {
+	redrawRequested = true;
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	resizeText(width, height, xscale);
+}
+//callback function to redraw a window the system uncovered or restored, for render-on-change pacing
+void window_refresh_callback(GLFWwindow* window) {
+	redrawRequested = true;
+}
+//use the polynomial atan2 / rsqrt approximations for picking and in the wheel shader
+bool useFastMath = false;
+//render the wheel once into a texture and blit it, instead of shading it every frame
+bool useWheelCache = false;
+//blend and store in linear light: shaders decode their sRGB output and GL_FRAMEBUFFER_SRGB re-encodes on write
+bool useSrgbPipeline = false;
+//lay the wheel out in OKLCH (perceptual hue/chroma at the value bar's lightness) instead of HSV
+bool useOklchWheel = false;
+//difference readout: R takes the current color as the reference, E cycles the formula
+bool referenceRequested = false;
+DeltaE deltaEFormula = DeltaE::CIEDE2000;
+//eyedropper: pick from a loaded image shown in place of the wheel (I toggles; --image or drop a file to load);
+//scroll zooms, right-drag pans, H fits the image again
+TiledImage eyedropperImage;
+bool eyedropperMode = false;
+bool imagePanning = false;
+float panLastX, panLastY;
+//dominant colors of the eyedropper image, shown as swatches above the output box (P: k-means, Shift+P: median cut)
+std::vector<PaletteColor> imagePalette;
+PaletteOptions paletteOptions;
+bool paletteRequested = false;
+//where the eyedropper image's colors fall on the wheel, as a heatmap over it (D toggles)
+HueHistogram imageHistogram;
+bool showHistogram = false;
+//picked colors: Ctrl+Z undoes a pick, Ctrl+Y or Ctrl+Shift+Z redoes it; the most recent ones are shown below the output box
+ColorHistory colorHistory;
+bool historyPick = false;
+int historyStep = 0;
+//recolor (X toggles): the image's pixels near a source hue are shifted towards the picked color, previewed beside the wheel
+//(or in place of it in eyedropper mode) as the wheel is dragged; clicking the image chooses the source, [ and ] narrow or
+//widen the hue range, Ctrl+S writes the full-resolution result
+RecolorParams recolorParams;
+bool recolorMode = false;
+bool recolorTextStale = true;
+bool recolorExportRequested = false;
+std::string recolorOutputPath = "recolored.png";
+//hue and saturation follow the cursor while the left button is held after a press on the wheel
+bool wheelDragging = false;
+//callback function for key toggles
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (action != GLFW_PRESS)
+		return;
+	redrawRequested = true;
+	if (key == GLFW_KEY_C) {
+		useWheelCache = !useWheelCache;
+		if (!useWheelCache)
+			releaseWheelCache();
+		std::cout << "wheel cache " << (useWheelCache ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_F) {
+		useFastMath = !useFastMath;
+		std::cout << "fast math " << (useFastMath ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_L) {
+		useSrgbPipeline = !useSrgbPipeline;
+		std::cout << "sRGB pipeline " << (useSrgbPipeline ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_O) {
+		useOklchWheel = !useOklchWheel;
+		std::cout << (useOklchWheel ? "OKLCH" : "HSV") << " wheel" << std::endl;
+	}
+	if (key == GLFW_KEY_R)
+		referenceRequested = true;
+	if (key == GLFW_KEY_E) {
+		deltaEFormula = deltaEFormula == DeltaE::CIE76 ? DeltaE::CIE94 : deltaEFormula == DeltaE::CIE94 ? DeltaE::CIEDE2000 : DeltaE::CIE76;
+	}
+	if (key == GLFW_KEY_I) {
+		if (eyedropperImage.loaded()) {
+			eyedropperMode = !eyedropperMode;
+			std::cout << "eyedropper " << (eyedropperMode ? "on" : "off") << std::endl;
+		}
+		else
+			std::cout << "no image loaded (--image <file> or drop one on the window)" << std::endl;
+	}
+	if (key == GLFW_KEY_H && eyedropperMode)
+		eyedropperImage.resetView();
+	if (key == GLFW_KEY_P) {
+		paletteOptions.method = (mods & GLFW_MOD_SHIFT) ? PaletteMethod::MedianCut : PaletteMethod::KMeans;
+		paletteRequested = true;
+	}
+	if (key == GLFW_KEY_D) {
+		showHistogram = !showHistogram;
+		std::cout << "hue histogram " << (showHistogram ? "on" : "off") << " (" << (imageHistogram.gpu() ? "GPU" : "CPU") << ")" << std::endl;
+		if (showHistogram && !eyedropperImage.loaded())
+			std::cout << "no image loaded (--image <file> or drop one on the window)" << std::endl;
+	}
+	if (key == GLFW_KEY_Z && (mods & GLFW_MOD_CONTROL))
+		historyStep = (mods & GLFW_MOD_SHIFT) ? 1 : -1;
+	if (key == GLFW_KEY_Y && (mods & GLFW_MOD_CONTROL))
+		historyStep = 1;
+	if (key == GLFW_KEY_X) {
+		if (eyedropperImage.loaded()) {
+			recolorMode = !recolorMode;
+			recolorTextStale = true;
+			std::cout << "recolor " << (recolorMode ? "on" : "off") << std::endl;
+		}
+		else
+			std::cout << "no image loaded (--image <file> or drop one on the window)" << std::endl;
+	}
+	if ((key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET) && recolorMode) {
+		float step = key == GLFW_KEY_LEFT_BRACKET ? -5.0f : 5.0f;
+		recolorParams.hueRange = std::min(std::max(recolorParams.hueRange + step, 0.0f), 180.0f);
+		recolorTextStale = true;
+	}
+	if (key == GLFW_KEY_S && (mods & GLFW_MOD_CONTROL))
+		recolorExportRequested = true;
+	if (key == GLFW_KEY_T) {
+		setFrameStatsEnabled(!frameStatsEnabled());
+		std::cout << "pass timings " << (frameStatsEnabled() ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_V) {
+		setPacingMode((PacingMode)(((int)pacingMode() + 1) % (int)PacingMode::Count));
+		std::cout << "frame pacing: " << pacingModeName(pacingMode());
+		if (pacingMode() == PacingMode::Cap)
+			std::cout << " " << fpsCap() << " fps";
+		std::cout << std::endl;
+	}
+}
+//callback function to load the first file dropped on the window as the eyedropper image
+void drop_callback(GLFWwindow* window, int count, const char** paths) {
+	redrawRequested = true;
+	if (count > 0 && eyedropperImage.load(paths[0])) {
+		eyedropperMode = true;
+		imageHistogram.reset();
+		std::cout << "eyedropper image " << paths[0] << " (" << eyedropperImage.width() << "x" << eyedropperImage.height() << ")" << std::endl;
+	}
+}
+//process all input and can be added more features later
+void processInput(GLFWwindow* window) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+}
+//function to generate circle vertices
+std::vector<float> generateVerices_rgb_Circle(int num) {
+	std::vector<float> vertices;
+	vertices.push_back(0.0f); // Center vertex x
+	vertices.push_back(0.0f); // Center vertex y
+	vertices.push_back(0.0f); // Center vertex z
+	for(int i=0; i <= num; ++i) {
+		float angle = 2.0f * 3.1415926f * float(i) / float(num);
+		float x = radius*cosf(angle);
+		vertices.push_back(x);
+		float y = radius*sinf(angle);
+		vertices.push_back(y);
+		float z = 0.0f;
+		vertices.push_back(z);
+		// Store vertex positions
+	}
+	return vertices;
+}
+//function to check if the point is inside the circle
+bool is_inside_circle(float x, float y) {
+	return (x * x + y * y) <= (radius * radius);
+}
+//function to check if the point is inside the alpha box
+bool is_inside_alpha_box(float x, float y) {
+	return (x >= 0.8f && x <= 0.9f &&
+		y >= -0.8f && y <= 0.8f);
+}
+//vertical extent of the value (brightness) bar; it stops below the text readout
+#define value_bar_bottom -0.8f
+#define value_bar_top 0.4f
+//function to check if the point is inside the value box
+bool is_inside_value_box(float x, float y) {
+	return (x >= -0.9f && x <= -0.8f &&
+		y >= value_bar_bottom && y <= value_bar_top);
+}
+//palette swatches: one row above the output box, split evenly between the colors
+#define swatch_row_bottom -0.78f
+#define swatch_row_top -0.7f
+glm::vec4 swatchRect(int index, int count) {
+	float width = 1.0f / count;
+	return glm::vec4(-0.5f + index * width, swatch_row_bottom, -0.5f + (index + 1) * width - 0.01f, swatch_row_top);
+}
+//function to find the swatch under a point, -1 when there is none
+int swatchAt(float x, float y) {
+	int count = (int)imagePalette.size();
+	if (count == 0 || x < -0.5f || x >= 0.5f || y < swatch_row_bottom || y > swatch_row_top)
+		return -1;
+	int index = std::min((int)((x + 0.5f) * count), count - 1);
+	return x <= swatchRect(index, count).z ? index : -1;
+}
+//history strip: the most recent picks below the output box, the current one on the left
+#define history_row_bottom -0.985f
+#define history_row_top -0.915f
+#define history_slots 16
+glm::vec4 historyRect(int index) {
+	float width = 1.0f / history_slots;
+	return glm::vec4(-0.5f + index * width, history_row_bottom, -0.5f + (index + 1) * width - 0.01f, history_row_top);
+}
+//function to find the history entry under a point (0 is the current one), -1 when there is none
+int historyAt(float x, float y) {
+	int count = std::min(colorHistory.depth(), history_slots);
+	if (count == 0 || x < -0.5f || x >= 0.5f || y < history_row_bottom || y > history_row_top)
+		return -1;
+	int index = std::min((int)((x + 0.5f) * history_slots), history_slots - 1);
+	return index < count && x <= historyRect(index).z ? index : -1;
+}
+//where the image is shown: in place of the wheel, or as the recolor preview in the corner beside it
+glm::vec4 imageViewRect() {
+	if (eyedropperMode)
+		return glm::vec4(-radius, -radius, radius, radius);
+	return glm::vec4(0.4f, 0.62f, 0.74f, 0.98f);
+}
+//function to convert screen coordinates to NDC
+void screenToNDC(GLFWwindow* window, double xpos, double ypos, float& ndcx, float& ndcy) {
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	ndcx = static_cast<float>((xpos / width) * 2.0 - 1.0);
+	ndcy = static_cast<float>(1.0 - (ypos / height) * 2.0);
+}
+//startup timeline: labelled glfwGetTime() stamps, printed once the first frame is on screen
+std::vector<std::pair<const char*, double>> startupTimeline;
+void markStartup(const char* label) {
+	startupTimeline.push_back({ label, glfwGetTime() });
+}
+void printStartupTimeline() {
+	std::cout << "\nStartup timeline (ms since glfwInit):\n";
+	double prev = 0.0;
+	for (auto& mark : startupTimeline) {
+		printf("  %8.2f  (+%7.2f)  %s\n", mark.second * 1000.0, (mark.second - prev) * 1000.0, mark.first);
+		prev = mark.second;
+	}
+	printf("  blocked on shader compile/link: %.2f ms (parallel compile %s)\n",
+		shaderWaitTime() * 1000.0, parallelShaderCompile() ? "on" : "unavailable");
+}
+//a global variable to store the triangle y offset
+float triangleYoffset = 0.0f;
+//function to calculate alpha value based on y position
+float calculateAlphaValue(float ypos) {
+	if (ypos < -0.8f) {
+		return 0.0f;
+	}
+	if (ypos > 0.8f) {
+		return 1.0f;
+	}
+	float a = (ypos + 0.8f) / 1.6f;
+	return a;
+}
+//function to calculate the value (brightness) based on y position
+float calculateBrightnessValue(float ypos) {
+	if (ypos < value_bar_bottom) {
+		return 0.0f;
+	}
+	if (ypos > value_bar_top) {
+		return 1.0f;
+	}
+	return (ypos - value_bar_bottom) / (value_bar_top - value_bar_bottom);
+}
+//the picked color is held as HSV plus alpha; finalColor is derived from it
+struct PickerState {
+	float hue;        // [0,1)
+	float saturation; // [0,1]
+	float value;      // [0,1]
+	float alpha;      // [0,1]
+};
+PickerState picker = { 0.0f, 0.0f, 1.0f, 1.0f };
+//which components changed since the last frame, so only the widgets depending on them are updated
+enum PickerDirty {
+	DIRTY_HUE_SAT = 1,
+	DIRTY_VALUE = 2,
+	DIRTY_ALPHA = 4,
+	DIRTY_ALL = 7
+};
+unsigned int pickerDirty = DIRTY_ALL;
+//a global variable to store the final color
+glm::vec4 finalColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+//color at a picker position (hue [0,1), saturation, value): HSV, or gamut-mapped OKLCH when the OKLCH wheel is shown
+glm::vec3 pickerToRGB(float hue, float saturation, float value) {
+	if (useOklchWheel)
+		return oklchWheelToRgb(hue, saturation, value);
+	return HSVtoRGB(hue * 360.0f, saturation, value);
+}
+//picker position (hue [0,1), saturation, value) of an sRGB color on the current wheel, the inverse of pickerToRGB
+void rgbToPicker(glm::vec3 rgb, float& hue, float& saturation, float& value) {
+	if (useOklchWheel) {
+		glm::vec3 lch = convertColor(ColorSpace::SRGB, ColorSpace::OKLCh, rgb);
+		value = std::min(std::max(lch.x, 0.0f), 1.0f);
+		saturation = std::min(lch.y / OKLCH_MAX_CHROMA, 1.0f);
+		hue = lch.z / 360.0f;
+		return;
+	}
+	glm::vec3 hsv = srgbToHsv(rgb);
+	hue = hsv.x / 360.0f;
+	saturation = hsv.y;
+	value = hsv.z;
+}
+//function to set hue and saturation from a point on the wheel; beyond its edge (while dragging) saturation stays full
+void pickOnWheel(float x, float y) {
+	float angle = useFastMath ? fastAtan2(y, x) : atan2(y, x);
+	float hue = (angle + 3.1415926f) / (2.0f * 3.1415926f);
+	float in_radius = useFastMath ? fastSqrt(x * x + y * y) : sqrt(x * x + y * y);
+	float saturation = in_radius / radius;
+	saturation = std::min(std::max(saturation, 0.0f), 1.0f);
+	picker.hue = hue;
+	picker.saturation = saturation;
+	pickerDirty |= DIRTY_HUE_SAT;
+}
+//cursor position as the callbacks see it; scripted input (the render benchmark) sets it directly,
+//since GLFW only moves the cursor of a window that has input focus
+bool cursorScripted = false;
+double scriptedCursorX, scriptedCursorY;
+void getCursorPos(GLFWwindow* window, double* sx, double* sy) {
+	if (cursorScripted) {
+		*sx = scriptedCursorX;
+		*sy = scriptedCursorY;
+	}
+	else
+		glfwGetCursorPos(window, sx, sy);
+}
+void setScriptedCursor(double sx, double sy) {
+	cursorScripted = true;
+	scriptedCursorX = sx;
+	scriptedCursorY = sy;
+}
+//call back function
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+	redrawRequested = true;
+	if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+		imagePanning = eyedropperMode && action == GLFW_PRESS;
+		double sx, sy;
+		getCursorPos(window, &sx, &sy);
+		screenToNDC(window, sx, sy, panLastX, panLastY);
+	}
+	//a drag on the wheel is recorded once, where it ends
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE && wheelDragging) {
+		wheelDragging = false;
+		historyPick = true;
+	}
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+		double sx, sy;
+		getCursorPos(window, &sx, &sy);
+		float x, y;
+		screenToNDC(window, sx, sy, x, y);
+		//only what this click changes is recorded, once the frame has derived the new color
+		unsigned int dirtyBefore = pickerDirty;
+		pickerDirty = 0;
+		if (is_inside_alpha_box(x, y)) {
+			//std::cout << "Rectangle clicked!" << std::endl;
+			triangleYoffset = y;
+			float alphaValue = calculateAlphaValue(y);
+			picker.alpha = alphaValue;
+			pickerDirty |= DIRTY_ALPHA;
+			//std::cout << "Alpha Value: " << alphaValue << std::endl;
+		}
+		if (is_inside_value_box(x, y)) {
+			picker.value = calculateBrightnessValue(y);
+			pickerDirty |= DIRTY_VALUE;
+		}
+		int px, py;
+		glm::vec3 rgb;
+		int swatch = swatchAt(x, y);
+		int recent = historyAt(x, y);
+		if (swatch >= 0) {
+			rgbToPicker(imagePalette[swatch].rgb, picker.hue, picker.saturation, picker.value);
+			pickerDirty |= DIRTY_HUE_SAT | DIRTY_VALUE;
+		}
+		else if (recent >= 0) {
+			glm::vec4 color = colorHistory.recent(recent).color;
+			rgbToPicker(glm::vec3(color), picker.hue, picker.saturation, picker.value);
+			picker.alpha = color.a;
+			triangleYoffset = color.a * 1.6f - 0.8f;
+			pickerDirty |= DIRTY_ALL;
+		}
+		else if (recolorMode && eyedropperImage.pixelAt(x, y, px, py)) {
+			// with recolor on, the image chooses the hue to shift rather than the color
+			if (eyedropperImage.pixel(px, py, rgb)) {
+				recolorParams.source = rgb;
+				recolorTextStale = true;
+			}
+		}
+		else if (eyedropperMode) {
+			// pixels whose rows haven't been decoded yet are ignored
+			if (eyedropperImage.pixelAt(x, y, px, py) && eyedropperImage.pixel(px, py, rgb)) {
+				rgbToPicker(rgb, picker.hue, picker.saturation, picker.value);
+				pickerDirty |= DIRTY_HUE_SAT | DIRTY_VALUE;
+			}
+		}
+		else if (is_inside_circle(x, y)) {
+			//std::cout << "Circle clicked!" << std::endl;
+			pickOnWheel(x, y);
+			wheelDragging = true;
+		}
+		historyPick = historyPick || (pickerDirty != 0 && !wheelDragging);
+		pickerDirty |= dirtyBefore;
+	}
+}
+//callback function to pan the eyedropper image while the right button is held, and to follow a drag on the wheel
+void cursor_pos_callback(GLFWwindow* window, double sx, double sy) {
+	if (!imagePanning && !wheelDragging)
+		return;
+	redrawRequested = true;
+	float x, y;
+	screenToNDC(window, sx, sy, x, y);
+	if (wheelDragging)
+		pickOnWheel(x, y);
+	if (imagePanning) {
+		eyedropperImage.pan(x - panLastX, y - panLastY);
+		panLastX = x;
+		panLastY = y;
+	}
+}
+//callback function to zoom the eyedropper image around the cursor
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+	if (!eyedropperMode)
+		return;
+	redrawRequested = true;
+	double sx, sy;
+	getCursorPos(window, &sx, &sy);
+	float x, y;
+	screenToNDC(window, sx, sy, x, y);
+	eyedropperImage.zoom(std::pow(1.25f, (float)yoffset), x, y);
+}
+//shader sources
+const char* circle_vs_shader = "#version 330 core\n"
+"layout(location = 0) in vec3 aPos;\n"
+"out vec3 vPos;\n"
+"void main()\n"
+"{\n"
+"    vPos = aPos;\n"
+"    gl_Position = vec4(aPos, 1.0);\n"
+"}\n";
+
+const char* circle_fs_shader = "#version 330 core\n"
+"in vec3 vPos;\n"
+"out vec4 FragColor;\n"
+"uniform float uValue;\n"
+"uniform bool uLinearOutput;\n"
+"vec3 srgb_to_linear(vec3 c)\n"
+"{\n"
+"    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));\n"
+"}\n"
+"vec3 hsv2rgb(vec3 c)\n"
+"{\n"
+"    vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);\n"
+"    vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);\n"
+"    return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);\n"
+"}\n"
+"void main()\n"
+"{\n"
+"#ifdef FAST_MATH\n"
+"    float d2 = dot(vPos.xy, vPos.xy);\n"
+"    if (d2 > 0.36) discard;\n"
+"    float radius = d2 * fast_rsqrt(max(d2, 1e-30));\n"
+"    float angle = fast_atan2(vPos.y, vPos.x);\n"
+"#else\n"
+"    float radius = length(vPos.xy);\n"
+"	if (radius>0.6)discard;\n"
+"    float angle = atan(vPos.y, vPos.x);\n"
+"#endif\n"
+"    float hue = (angle + 3.1415926) / (2.0 * 3.1415926);\n"
+"    float saturation = clamp(radius/0.6f,0.0f,1.0f);\n"
+"    float value = uValue;\n"
+"#ifdef OKLCH_WHEEL\n"
+"    vec3 rgb = oklch_wheel(hue, saturation, value);\n"
+"#else\n"
+"    vec3 rgb = hsv2rgb(vec3(hue, saturation, value));\n"
+"#endif\n"
+"    if (uLinearOutput) rgb = srgb_to_linear(rgb);\n"
+"    FragColor = vec4(rgb, 1.0);\n"
+"}\n";
+
+const char* ui_vs_shader = "#version 330 core\n"
+"layout(location = 0) in vec3 aPos;\n"
+"layout(location = 1) in vec3 aColor;\n"
+"uniform float offSetY;\n"
+"out vec3 vColor;\n"
+"void main()\n"
+"{\n"
+"    vColor = aColor;\n"
+"    vec3 pos = aPos;\n"
+"    pos.y += offSetY;\n"
+"    gl_Position = vec4(pos, 1.0);\n"
+"}\n";
+
+const char* ui_fs_shader = "#version 330 core\n"
+"in vec3 vColor;\n"
+"out vec4 FragColor;\n"
+"uniform bool uLinearOutput;\n"
+"vec3 srgb_to_linear(vec3 c)\n"
+"{\n"
+"    return mix(c / 12.92, pow((c + 0.055) / 1.055, vec3(2.4)), greaterThan(c, vec3(0.04045)));\n"
+"}\n"
+"void main()\n"
+"{\n"	
+"    vec3 rgb = uLinearOutput ? srgb_to_linear(vColor) : vColor;\n"
+"    FragColor = vec4(rgb, 1.0f);\n"
+"}\n";
+
+const char* final_box_vs_shader = "#version 330 core\n"
+"layout(location = 0) in vec3 aPos;\n"
+"void main()\n"
+"{\n"
+"gl_Position = vec4(aPos, 1.0);\n"
+"}\n";
+
+const char* swatch_vs_shader = "#version 330 core\n"
+"layout(location = 0) in vec2 corner;\n"
+"uniform vec4 uRect;\n"
+"void main()\n"
+"{\n"
+"gl_Position = vec4(mix(uRect.xy, uRect.zw, corner), 0.0, 1.0);\n"
+"}\n";
+
+const char* final_box_fs_shader = "#version 330 core\n"
+"out vec4 FragColor;\n"
+"uniform vec4 uColor;\n"
+"void main()\n"
+"{\n"
+"FragColor = uColor;\n"
+"}\n";	
+
+//tools/rgbpick_bench.cpp builds this file with RGBPICK_NO_MAIN to benchmark the functions above
+#ifndef RGBPICK_NO_MAIN
+int main(int argc, char** argv) {
+	// --bench-color-spaces / --bench-named-colors / --bench-delta-e / --bench-palette / --bench-palette-library / --bench-recolor:
+	// print throughput and exit (--bench-color-spaces and --bench-delta-e exit with 1 if their accuracy checks fail),
+	// --check-fast-math: compare the fast atan2/rsqrt with libm and exit (1 beyond the documented error);
+	// checks end in finishCheck, which prints the outcome and gives the exit status,
+	// --convert-palette <in> <out>: write a CSV/GPL/ASE palette as a .rgbpal library and exit; no window needed
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--bench-color-spaces")
+			return finishCheck("color-spaces", benchmarkColorSpaces());
+		if (std::string(argv[i]) == "--bench-named-colors") {
+			benchmarkNamedColors();
+			return 0;
+		}
+		if (std::string(argv[i]) == "--bench-delta-e")
+			return finishCheck("delta-e", benchmarkDeltaE());
+		if (std::string(argv[i]) == "--bench-palette") {
+			benchmarkPalette();
+			return 0;
+		}
+		if (std::string(argv[i]) == "--bench-palette-library") {
+			benchmarkPaletteLibrary();
+			return 0;
+		}
+		if (std::string(argv[i]) == "--bench-recolor") {
+			benchmarkRecolor();
+			return 0;
+		}
+		if (std::string(argv[i]) == "--check-fast-math")
+			return finishCheck("fast-math", checkFastMath());
+		if (std::string(argv[i]) == "--convert-palette" && i + 2 < argc)
+			return convertPaletteLibrary(argv[i + 1], argv[i + 2]) ? 0 : 1;
+	}
+	// --bench-render <static|dragging|resizing|labels>: time the frame loop on a hidden window with vsync off and exit,
+	// --bench-frames <n>: frames per timed run (600), --software-gl: Mesa's software rasterizer even where a GPU exists,
+	// --golden <dir>: render the golden states on a hidden window, compare them with <dir>/<state>.png and exit (1 if any differ),
+	// --golden-update: write the frames as the goldens instead, --golden-tolerance <dE00>: per-pixel tolerance (1.0),
+	// --golden-max-pixels <n>: pixels beyond it a state may have (0)
+	bool renderBench = false;
+	RenderScenario renderScenario = RenderScenario::Static;
+	int renderBenchFrames = 600;
+	bool goldenTest = false;
+	GoldenOptions goldenOptions;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--bench-render" && i + 1 < argc) {
+			renderBench = parseRenderScenario(argv[++i], renderScenario);
+			if (!renderBench) {
+				std::cout << "ERROR::BENCH_RENDER::UNKNOWN_SCENARIO " << argv[i] << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "--bench-frames" && i + 1 < argc)
+			renderBenchFrames = std::max(atoi(argv[++i]), 1);
+		else if (arg == "--software-gl")
+			setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+		else if (arg == "--golden" && i + 1 < argc) {
+			goldenTest = true;
+			goldenOptions.dir = argv[++i];
+		}
+		else if (arg == "--golden-update")
+			goldenOptions.update = true;
+		else if (arg == "--golden-tolerance" && i + 1 < argc)
+			goldenOptions.tolerance = (float)atof(argv[++i]);
+		else if (arg == "--golden-max-pixels" && i + 1 < argc)
+			goldenOptions.maxPixels = strtoull(argv[++i], nullptr, 10);
+	}
+	//no one watches these runs
+	bool headless = renderBench || goldenTest;
+	std::cout << "A brief description of the project: \n";
+	std::cout << "A fully GPU-driven RGB color picker built using modern OpenGL, implementing an HSV color wheel, interactive alpha adjustment, and real-time RGBA visualization. \nThe project has shader programming, custom UI rendering, mouse input processing, coordinate transformations, alpha blending, and font rendering, all without relying on external UI libraries";
+	
+	if (!glfwInit()) {
+		throw std::runtime_error("Failed to initialize GLFW terminating it!");
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_TRUE);
+	glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
+	glfwWindowHint(GLFW_VISIBLE, headless ? GLFW_FALSE : GLFW_TRUE);
+	GLFWwindow* window = glfwCreateWindow(800, 800, "RGB circle", NULL, NULL);
+	if (window == NULL) {
+		glfwTerminate();
+		throw std::runtime_error("Failed to create GLFW window");
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetWindowContentScaleCallback(window, content_scale_callback);
+	glfwSetWindowRefreshCallback(window, window_refresh_callback);
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	glfwSetKeyCallback(window, key_callback);
+	glfwSetDropCallback(window, drop_callback);
+	glfwSetCursorPosCallback(window, cursor_pos_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+	if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress))) {
+		glfwTerminate();
+		throw std::runtime_error("Failed to initialize GLAD");
+	}
+	markStartup("context + GL loader");
+	// --shader-dir <dir>: load the GLSL from files and recompile when they change
+	// --wheel-cache: start with the render-once wheel texture, --pass-stats: print per-pass timings,
+	// --fast-math: polynomial atan2/rsqrt for picking and the wheel shader,
+	// --srgb: sRGB-correct blending (linear light framebuffer writes), --oklch: OKLCH wheel,
+	// --palette <file>: named colors for the nearest-name readout instead of the CSS names (.rgbpal, CSV, GPL or ASE),
+	// --reference #rrggbb: starting reference for the color difference readout,
+	// --image <file>: start in eyedropper mode on a PNG/JPEG/PPM image,
+	// --image-cache <dir>: where image pyramids are kept between runs ("" keeps them in memory only),
+	// --palette-colors <n>: colors extracted by P (up to 32), --palette-samples <n>: pixels used at most (0: all),
+	// --histogram: start with the image's hue histogram over the wheel, --histogram-cpu: bin it on the CPU,
+	// --history <file>: where picked colors are kept between runs ("color_history.bin"; "" keeps them in memory only),
+	// --recolor: start with recolor on (with --image), --recolor-output <file>: where Ctrl+S writes the recolored image ("recolored.png"),
+	// --pacing <vsync|adaptive|cap|on-change|uncapped>: how frames are paced (vsync; V cycles), --fps-cap <n>: frame rate of cap (60)
+	std::string palettePath;
+	std::string referenceArg;
+	std::string imagePath;
+	bool histogramOnCpu = false;
+	std::string historyPath = "color_history.bin";
+	PacingMode pacing = PacingMode::Vsync;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--shader-dir" && i + 1 < argc)
+			enableShaderHotReload(argv[++i]);
+		else if (arg == "--wheel-cache")
+			useWheelCache = true;
+		else if (arg == "--pass-stats")
+			setFrameStatsEnabled(true);
+		else if (arg == "--pass-stats-sync") {
+			setFrameStatsEnabled(true);
+			setFrameStatsSync(true);
+		}
+		else if (arg == "--fast-math")
+			useFastMath = true;
+		else if (arg == "--srgb")
+			useSrgbPipeline = true;
+		else if (arg == "--oklch")
+			useOklchWheel = true;
+		else if (arg == "--palette" && i + 1 < argc)
+			palettePath = argv[++i];
+		else if (arg == "--reference" && i + 1 < argc)
+			referenceArg = argv[++i];
+		else if (arg == "--image" && i + 1 < argc)
+			imagePath = argv[++i];
+		else if (arg == "--image-cache" && i + 1 < argc)
+			setImageCacheDir(argv[++i]);
+		else if (arg == "--palette-colors" && i + 1 < argc)
+			paletteOptions.colors = std::min(std::max(atoi(argv[++i]), 1), PALETTE_MAX_COLORS);
+		else if (arg == "--palette-samples" && i + 1 < argc)
+			paletteOptions.maxSamples = strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--histogram")
+			showHistogram = true;
+		else if (arg == "--histogram-cpu")
+			histogramOnCpu = true;
+		else if (arg == "--history" && i + 1 < argc)
+			historyPath = argv[++i];
+		else if (arg == "--recolor")
+			recolorMode = true;
+		else if (arg == "--recolor-output" && i + 1 < argc)
+			recolorOutputPath = argv[++i];
+		else if (arg == "--pacing" && i + 1 < argc) {
+			if (!parsePacingMode(argv[++i], pacing))
+				std::cout << "ERROR::PACING::UNKNOWN_MODE " << argv[i] << std::endl;
+		}
+		else if (arg == "--fps-cap" && i + 1 < argc)
+			setFpsCap(atof(argv[++i]));
+	}
+	//the driver's default swap interval varies, so it is always set; benchmarks and golden runs go as fast as they can
+	setPacingMode(headless ? PacingMode::Uncapped : pacing);
+	//the render benchmark times passes in its own run
+	if (renderBench)
+		setFrameStatsEnabled(false);
+	//golden frames show no recent picks but their own
+	if (goldenTest)
+		historyPath = "";
+	if (!imagePath.empty())
+		eyedropperMode = eyedropperImage.load(imagePath);
+	recolorMode = recolorMode && eyedropperImage.loaded();
+	colorHistory.open(historyPath);
+	// issue every shader compile/link up front; status is only checked when a program is first used,
+	// so the driver compiles (in parallel where supported) while the geometry and font are set up
+	unsigned int circle_shaderProgram = createProgram("circle", circle_vs_shader, circle_fs_shader);
+	std::string circle_fast_fs = withPrelude(circle_fs_shader, std::string("#define FAST_MATH\n") + fast_math_glsl);
+	unsigned int circle_fast_shaderProgram = createProgram("circle_fast", circle_vs_shader, circle_fast_fs.c_str());
+	std::string circle_oklch_fs = withPrelude(circle_fs_shader, std::string("#define OKLCH_WHEEL\n") + oklch_wheel_glsl);
+	unsigned int circle_oklch_shaderProgram = createProgram("circle_oklch", circle_vs_shader, circle_oklch_fs.c_str());
+	std::string circle_oklch_fast_fs = withPrelude(circle_fs_shader,
+		std::string("#define FAST_MATH\n#define OKLCH_WHEEL\n") + fast_math_glsl + oklch_wheel_glsl);
+	unsigned int circle_oklch_fast_shaderProgram = createProgram("circle_oklch_fast", circle_vs_shader, circle_oklch_fast_fs.c_str());
+	//wheel programs by [useOklchWheel][useFastMath]
+	unsigned int circlePrograms[2][2] = {
+		{ circle_shaderProgram, circle_fast_shaderProgram },
+		{ circle_oklch_shaderProgram, circle_oklch_fast_shaderProgram }
+	};
+	unsigned int ui_shaderProgram = createProgram("ui", ui_vs_shader, ui_fs_shader);
+	unsigned int output_box_shaderProgram = createProgram("output_box", final_box_vs_shader, final_box_fs_shader);
+	unsigned int swatch_shaderProgram = createProgram("swatch", swatch_vs_shader, final_box_fs_shader);
+	markStartup("shader programs issued");
+	initFrameStats();
+	initWheelCache();
+	initImageView();
+	imageHistogram.init(histogramOnCpu);
+	// enable blending
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	// generate circle vertices
+	std::vector<float> vertices=generateVerices_rgb_Circle(360);
+	// set up circle graphics pipeline
+	unsigned int circle_VBO, circle_VAO;
+	glGenVertexArrays(1, &circle_VAO);
+	glGenBuffers(1, &circle_VBO);
+	glBindVertexArray(circle_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, circle_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	// set up alpha box graphics pipeline
+	std::vector<float> alpha_box_vertices = {
+		0.8f, 0.8f, 0.0f, 1.0f,1.0f,1.0f,
+		0.8f, -0.8f, 0.0f, 0.0f,0.0f,0.0f,
+		0.9f, -0.8f, 0.0f, 0.0f,0.0f,0.0f,
+		0.9f, 0.8f, 0.0f, 1.0f,1.0f,1.0f,
+	};
+	std::vector<unsigned int>indices={
+		0,1,2,
+		2,3,0
+	};
+	unsigned int alpha_box_VBO,alpha_box_VAO;
+	glGenVertexArrays(1, &alpha_box_VAO);
+	glGenBuffers(1, &alpha_box_VBO);
+	glBindVertexArray(alpha_box_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, alpha_box_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * alpha_box_vertices.size(), alpha_box_vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	unsigned int alpha_box_EBO;
+	glGenBuffers(1, &alpha_box_EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, alpha_box_EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	// set up alpha triangle graphics pipeline
+	std::vector<float>alpha_triangle = {
+		0.75f, 0.8f, 0.0f,  137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f,
+		0.75f, 0.7f, 0.0f,  137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f,
+		0.8f, 0.75f, 0.0f,   137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f
+	};
+	unsigned int alpha_triangle_VBO, alpha_triangle_VAO;
+	glGenVertexArrays(1, &alpha_triangle_VAO);
+	glGenBuffers(1, &alpha_triangle_VBO);
+	glBindVertexArray(alpha_triangle_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, alpha_triangle_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * alpha_triangle.size(), alpha_triangle.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	// set up value bar graphics pipeline; its top color follows hue/saturation, so the buffer is dynamic
+	std::vector<float> value_box_vertices = {
+		-0.9f, value_bar_top, 0.0f, 1.0f,1.0f,1.0f,
+		-0.9f, value_bar_bottom, 0.0f, 0.0f,0.0f,0.0f,
+		-0.8f, value_bar_bottom, 0.0f, 0.0f,0.0f,0.0f,
+		-0.8f, value_bar_top, 0.0f, 1.0f,1.0f,1.0f,
+	};
+	unsigned int value_box_VBO, value_box_VAO;
+	glGenVertexArrays(1, &value_box_VAO);
+	glGenBuffers(1, &value_box_VBO);
+	glBindVertexArray(value_box_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, value_box_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * value_box_vertices.size(), value_box_vertices.data(), GL_DYNAMIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	// same index pattern as the alpha box
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, alpha_box_EBO);
+	// set up value triangle graphics pipeline (points left at the bar, centered on y = 0)
+	std::vector<float>value_triangle = {
+		-0.75f, 0.05f, 0.0f,  137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f,
+		-0.75f, -0.05f, 0.0f,  137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f,
+		-0.8f, 0.0f, 0.0f,   137.0f / 255.0f, 137.0f / 255.0f, 137.0f / 255.0f
+	};
+	unsigned int value_triangle_VBO, value_triangle_VAO;
+	glGenVertexArrays(1, &value_triangle_VAO);
+	glGenBuffers(1, &value_triangle_VBO);
+	glBindVertexArray(value_triangle_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, value_triangle_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * value_triangle.size(), value_triangle.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	// set up final output box graphics pipeline
+	std::vector<float> output_box_vertices = {
+		-0.5f, -0.8f, 0.0f,
+		-0.5f, -0.9f, 0.0f,
+		 0.5f, -0.9f, 0.0f,
+		 0.5f, -0.8f, 0.0f,
+	};
+	std::vector<unsigned int>output_indices = {
+		0,1,2,
+		2,3,0
+	};
+	unsigned int output_box_VBO, output_box_VAO;
+	glGenVertexArrays(1, &output_box_VAO);
+	glGenBuffers(1, &output_box_VBO);
+	glBindVertexArray(output_box_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, output_box_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * output_box_vertices.size(), output_box_vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	unsigned int output_box_EBO;
+	glGenBuffers(1, &output_box_EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, output_box_EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int)* output_indices.size(), output_indices.data(), GL_STATIC_DRAW);
+	// set up palette swatch pipeline: a unit square placed by uRect for each swatch
+	std::vector<float> swatch_vertices = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f };
+	unsigned int swatch_VBO, swatch_VAO;
+	glGenVertexArrays(1, &swatch_VAO);
+	glGenBuffers(1, &swatch_VBO);
+	glBindVertexArray(swatch_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, swatch_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * swatch_vertices.size(), swatch_vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	markStartup("geometry uploaded");
+	// initialize text rendering
+	int width, height;
+	float xscale, yscale;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwGetWindowContentScale(window, &xscale, &yscale);
+	initText(width, height, xscale);
+	// readout layout: labels at the margin, values right-aligned in a column wide enough for "0.000000"
+	const char* readoutLabels[4] = { "R:", "G:", "B:", "A:" };
+	const float textMargin = 20.0f;
+	const float valueColumnRight = textMargin + measureText("A: ") + measureText("0.000000");
+	std::string readoutValues[4];
+	markStartup("text initialized");
+	// nearest named color, shown under the readout and looked up whenever the picked color changes;
+	// a .rgbpal library is queried where it is mapped, other palettes are indexed here
+	PaletteLibrary paletteLibrary;
+	std::vector<NamedColor> palette;
+	if (!palettePath.empty()) {
+		if (isPaletteLibrary(palettePath))
+			paletteLibrary.open(palettePath);
+		else
+			readPaletteSource(palettePath, palette);
+	}
+	if (palette.empty() && !paletteLibrary.isOpen())
+		palette = cssNamedColors();
+	NamedColorIndex namedColors;
+	namedColors.build(palette);
+	std::string nearestName;
+	markStartup("named color index built");
+	// color difference to a reference, kept in Lab; shown once a reference is set
+	bool hasReference = false;
+	glm::vec3 referenceLab(0.0f, 0.0f, 0.0f);
+	std::string referenceHex;
+	std::string deltaEText;
+	if (!referenceArg.empty()) {
+		unsigned int referenceValue;
+		if (sscanf(referenceArg.c_str(), " #%6x", &referenceValue) == 1) {
+			glm::vec3 rgb((referenceValue >> 16 & 255) / 255.0f, (referenceValue >> 8 & 255) / 255.0f, (referenceValue & 255) / 255.0f);
+			referenceLab = convertColor(ColorSpace::SRGB, ColorSpace::Lab, rgb);
+			referenceHex = referenceArg;
+			hasReference = true;
+		}
+		else
+			std::cout << "ERROR::REFERENCE::EXPECTED_#RRGGBB " << referenceArg << std::endl;
+	}
+	DeltaE deltaEFormulaShown = deltaEFormula;
+	// eyedropper image size, build progress and zoom, shown under the readout
+	std::string imageStatusText;
+	// recolor source and hue range, shown under that
+	std::string recolorText;
+	bool recolorShown = false;
+	int imagePercentShown = -1;
+	float imageZoomShown = 0.0f;
+	bool firstFrame = true;
+	// the wheel layout the derived colors were computed for
+	bool oklchWheelShown = useOklchWheel;
+	// frame-time counter shown in the window title
+	double frameTimeStart = glfwGetTime();
+	int frameTimeCount = 0;
+	// render-on-change pacing keeps rendering this long after a change, so what follows from it (a re-baked
+	// font atlas, tiles coming in) is shown without another event
+	const double changeSettleTime = 0.25;
+	double changeSettledAt = 0.0;
+	// render benchmark: warm-up frames (shader compiles, first uploads), a run timed as it is, then one with every pass timed
+	const int renderBenchWarmup = 30;
+	int benchFrame = 0;
+	int benchPhase = 0;
+	RenderBenchRun benchRun;
+	std::vector<ScenarioLabel> benchLabels;
+	// golden-image check: each state is held until the framebuffer has its size (or a few frames have passed), then read back
+	std::vector<GoldenState> goldenList = goldenStates();
+	size_t goldenIndex = 0;
+	int goldenWaitFrames = 0;
+	int goldenFailures = 0;
+	std::unique_ptr<GoldenRun> goldenRun;
+	if (goldenTest)
+		goldenRun.reset(new GoldenRun(goldenOptions));
+
+	// render
+	while (!glfwWindowShouldClose(window))
+	{
+		// scripted input goes through the callbacks, as events from glfwPollEvents would
+		if (renderBench) {
+			int windowWidth, windowHeight;
+			glfwGetWindowSize(window, &windowWidth, &windowHeight);
+			ScenarioFrame input = scenarioFrame(renderScenario, benchFrame, windowWidth, windowHeight);
+			if (input.width)
+				glfwSetWindowSize(window, input.width, input.height);
+			if (input.move) {
+				setScriptedCursor(input.cursorX, input.cursorY);
+				cursor_pos_callback(window, input.cursorX, input.cursorY);
+			}
+			if (input.press)
+				mouse_button_callback(window, GLFW_MOUSE_BUTTON_LEFT, GLFW_PRESS, 0);
+		}
+		if (goldenTest) {
+			const GoldenState& state = goldenList[goldenIndex];
+			int windowWidth, windowHeight;
+			glfwGetWindowSize(window, &windowWidth, &windowHeight);
+			if (windowWidth != state.width || windowHeight != state.height)
+				glfwSetWindowSize(window, state.width, state.height);
+			picker.hue = state.hue;
+			picker.saturation = state.saturation;
+			picker.value = state.value;
+			picker.alpha = state.alpha;
+			triangleYoffset = state.alpha * 1.6f - 0.8f;
+			pickerDirty = DIRTY_ALL;
+		}
+		processInput(window);
+		//background work still changing what is shown, which render-on-change pacing doesn't wait on
+		bool frameBusy = pollShaderReload();
+		// in sRGB mode every color handed to GL is linear; the framebuffer encodes on write
+		if (useSrgbPipeline) {
+			glEnable(GL_FRAMEBUFFER_SRGB);
+			glClearColor(srgbToLinear(0.2f), srgbToLinear(0.3f), srgbToLinear(0.3f), 1.0f);
+		}
+		else {
+			glDisable(GL_FRAMEBUFFER_SRGB);
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		}
+		glClear(GL_COLOR_BUFFER_BIT);
+		// derive what depends on the components that changed
+		// the same picker position means a different color on the other wheel
+		if (useOklchWheel != oklchWheelShown) {
+			oklchWheelShown = useOklchWheel;
+			pickerDirty = DIRTY_ALL;
+		}
+		// dominant colors of the eyedropper image; the frame waits for it, spread over all cores
+		if (paletteRequested) {
+			paletteRequested = false;
+			PaletteSamples samples;
+			if (!eyedropperImage.loaded())
+				std::cout << "no image loaded (--image <file> or drop one on the window)" << std::endl;
+			else if (!samplePyramid(eyedropperImage.source(), paletteOptions.maxSamples, samples))
+				std::cout << "image still loading, extract the palette once it is done" << std::endl;
+			else {
+				double paletteStart = glfwGetTime();
+				imagePalette = extractPalette(samples, paletteOptions);
+				printf("palette: %d colors (%s) from %zu samples in %.1f ms\n", (int)imagePalette.size(),
+					paletteOptions.method == PaletteMethod::KMeans ? "k-means" : "median cut", samples.count(),
+					(glfwGetTime() - paletteStart) * 1000.0);
+			}
+		}
+		// undo/redo go back to a recorded pick, which is not recorded again
+		if (historyStep != 0) {
+			const HistoryEntry* entry = historyStep < 0 ? colorHistory.undo() : colorHistory.redo();
+			historyStep = 0;
+			if (entry) {
+				rgbToPicker(glm::vec3(entry->color), picker.hue, picker.saturation, picker.value);
+				picker.alpha = entry->color.a;
+				triangleYoffset = entry->color.a * 1.6f - 0.8f;
+				pickerDirty = DIRTY_ALL;
+			}
+		}
+		if (pickerDirty & (DIRTY_HUE_SAT | DIRTY_VALUE)) {
+			glm::vec3 rgb = pickerToRGB(picker.hue, picker.saturation, picker.value);
+			finalColor.r = rgb.r;
+			finalColor.g = rgb.g;
+			finalColor.b = rgb.b;
+			if (paletteLibrary.isOpen())
+				nearestName = paletteLibrary.name(paletteLibrary.nearest(rgb));
+			else
+				nearestName = namedColors.name(namedColors.nearest(rgb));
+		}
+		bool referenceChanged = referenceRequested;
+		if (referenceRequested) {
+			referenceRequested = false;
+			glm::vec3 rgb(finalColor.r, finalColor.g, finalColor.b);
+			referenceLab = convertColor(ColorSpace::SRGB, ColorSpace::Lab, rgb);
+			char hex[8];
+			snprintf(hex, sizeof(hex), "#%02x%02x%02x", (int)std::lround(rgb.r * 255.0f), (int)std::lround(rgb.g * 255.0f), (int)std::lround(rgb.b * 255.0f));
+			referenceHex = hex;
+			hasReference = true;
+		}
+		if (hasReference && (referenceChanged || deltaEFormula != deltaEFormulaShown || (pickerDirty & (DIRTY_HUE_SAT | DIRTY_VALUE)))) {
+			deltaEFormulaShown = deltaEFormula;
+			glm::vec3 lab = convertColor(ColorSpace::SRGB, ColorSpace::Lab, glm::vec3(finalColor.r, finalColor.g, finalColor.b));
+			const char* formulaNames[] = { "dE76", "dE94", "dE00" };
+			char line[64];
+			snprintf(line, sizeof(line), "%s %.2f to %s", formulaNames[(int)deltaEFormula], deltaE(deltaEFormula, referenceLab, lab), referenceHex.c_str());
+			deltaEText = line;
+		}
+		if (pickerDirty & DIRTY_ALPHA)
+			finalColor.a = picker.alpha;
+		if (pickerDirty & DIRTY_HUE_SAT) {
+			// top of the value bar shows the picked hue/saturation at full brightness; OKLCH lightness 1 is white
+			// for every hue, so there it shows the hue at its most colorful lightness
+			glm::vec3 top = useOklchWheel ? oklchCuspToRgb(picker.hue, picker.saturation)
+				: pickerToRGB(picker.hue, picker.saturation, 1.0f);
+			for (int v : { 0, 3 }) {
+				value_box_vertices[v * 6 + 3] = top.r;
+				value_box_vertices[v * 6 + 4] = top.g;
+				value_box_vertices[v * 6 + 5] = top.b;
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, value_box_VBO);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * value_box_vertices.size(), value_box_vertices.data());
+		}
+		if (historyPick) {
+			historyPick = false;
+			colorHistory.push(finalColor);
+		}
+		// turning recolor on starts from the color picked last, typically off the image, so the wheel then moves it;
+		// the preview is drawn with the color derived this frame
+		if (recolorMode && !recolorShown)
+			recolorParams.source = glm::vec3(finalColor);
+		recolorShown = recolorMode;
+		recolorParams.target = glm::vec3(finalColor);
+		// the full-resolution recolored image; the frame waits for it, spread over all cores
+		if (recolorExportRequested) {
+			recolorExportRequested = false;
+			if (!recolorMode)
+				std::cout << "recolor is off (X turns it on)" << std::endl;
+			else if (eyedropperImage.source().rowsDone(0) < eyedropperImage.height())
+				std::cout << "image still loading, export once it is done" << std::endl;
+			else {
+				double exportStart = glfwGetTime();
+				if (exportRecolored(eyedropperImage.source(), recolorParams, recolorOutputPath))
+					printf("recolored %dx%d image written to %s in %.1f ms\n", eyedropperImage.width(), eyedropperImage.height(),
+						recolorOutputPath.c_str(), (glfwGetTime() - exportStart) * 1000.0);
+			}
+		}
+		if (pickerDirty) {
+			float values[4] = { finalColor.r, finalColor.g, finalColor.b, finalColor.a };
+			for (int i = 0; i < 4; ++i)
+				readoutValues[i] = std::to_string(values[i]);
+		}
+		pickerDirty = 0;
+		// draw the eyedropper image in place of the wheel, or the recolor preview beside it, making the tiles in view resident first
+		if (eyedropperMode || recolorMode) {
+			beginPass(PASS_IMAGE);
+			int fbWidth, fbHeight;
+			glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+			eyedropperImage.setViewport(imageViewRect(), fbWidth, fbHeight);
+			if (eyedropperImage.uploadTiles(0.004) > 0 || eyedropperImage.progress() < 1.0f)
+				frameBusy = true;
+			eyedropperImage.draw(useSrgbPipeline, recolorMode ? &recolorParams : nullptr);
+			endPass(PASS_IMAGE);
+		}
+		if (!eyedropperMode) {
+			// draw circle
+			GLuint circleProgram = finishProgram(circlePrograms[useOklchWheel][useFastMath]);
+			if (useWheelCache) {
+				int fbWidth, fbHeight;
+				glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+				WheelCacheKey wheelKey = { fbWidth, fbHeight, circleProgram, picker.value, useSrgbPipeline };
+				if (wheelCacheStale(wheelKey)) {
+					beginPass(PASS_WHEEL_CACHE);
+					beginWheelCacheUpdate(wheelKey);
+					glUseProgram(circleProgram);
+					glUniform1f(glGetUniformLocation(circleProgram, "uValue"), picker.value);
+					glUniform1i(glGetUniformLocation(circleProgram, "uLinearOutput"), useSrgbPipeline);
+					if (useOklchWheel) {
+						bindOklchGamutTable(picker.value, 1);
+						glUniform1i(glGetUniformLocation(circleProgram, "uGamutTable"), 1);
+					}
+					glBindVertexArray(circle_VAO);
+					glDrawArrays(GL_TRIANGLE_FAN, 0, vertices.size() / 3);
+					endWheelCacheUpdate();
+					endPass(PASS_WHEEL_CACHE);
+				}
+				beginPass(PASS_WHEEL_BLIT);
+				blitWheelCache(radius);
+				endPass(PASS_WHEEL_BLIT);
+			}
+			else {
+				beginPass(PASS_WHEEL);
+				glUseProgram(circleProgram);
+				glUniform1f(glGetUniformLocation(circleProgram, "uValue"), picker.value);
+				glUniform1i(glGetUniformLocation(circleProgram, "uLinearOutput"), useSrgbPipeline);
+				if (useOklchWheel) {
+					bindOklchGamutTable(picker.value, 1);
+					glUniform1i(glGetUniformLocation(circleProgram, "uGamutTable"), 1);
+				}
+				glBindVertexArray(circle_VAO);
+				glDrawArrays(GL_TRIANGLE_FAN, 0, vertices.size() / 3);
+				endPass(PASS_WHEEL);
+			}
+		}
+		// bin the image rows finished since the last frame, then show the heatmap over the wheel
+		if (showHistogram && eyedropperImage.loaded()) {
+			beginPass(PASS_HISTOGRAM);
+			int fbWidth, fbHeight;
+			glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+			if (imageHistogram.update(eyedropperImage.source(), useOklchWheel, fbWidth, fbHeight, 0.002) > 0)
+				frameBusy = true;
+			if (!eyedropperMode)
+				imageHistogram.draw(radius, useSrgbPipeline);
+			endPass(PASS_HISTOGRAM);
+		}
+
+		// draw alpha box
+		beginPass(PASS_ALPHA_BAR);
+		GLuint uiProgram = finishProgram(ui_shaderProgram);
+		glUseProgram(uiProgram);
+		GLuint offSetYLocation = glGetUniformLocation(uiProgram, "offSetY");
+		glUniform1i(glGetUniformLocation(uiProgram, "uLinearOutput"), useSrgbPipeline);
+		glUniform1f(offSetYLocation, 0.0f);
+		
+		glBindVertexArray(alpha_box_VAO);       
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+
+		// draw alpha triangle
+		glUniform1f(offSetYLocation, triangleYoffset-0.75f);
+		glBindVertexArray(alpha_triangle_VAO);
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(alpha_triangle.size() / 6));
+		endPass(PASS_ALPHA_BAR);
+
+		// draw value box and its triangle
+		beginPass(PASS_VALUE_BAR);
+		glUniform1f(offSetYLocation, 0.0f);
+		glBindVertexArray(value_box_VAO);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+		glUniform1f(offSetYLocation, value_bar_bottom + picker.value * (value_bar_top - value_bar_bottom));
+		glBindVertexArray(value_triangle_VAO);
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(value_triangle.size() / 6));
+		endPass(PASS_VALUE_BAR);
+
+		// draw output box
+		beginPass(PASS_OUTPUT_BOX);
+		GLuint outputBoxProgram = finishProgram(output_box_shaderProgram);
+		glUseProgram(outputBoxProgram);
+		// alpha stays linear coverage either way; only the color channels are decoded
+		if (useSrgbPipeline)
+			glUniform4f(
+				glGetUniformLocation(outputBoxProgram, "uColor"),
+				srgbToLinear(finalColor.r), srgbToLinear(finalColor.g), srgbToLinear(finalColor.b), finalColor.a
+			);
+		else
+			glUniform4f(
+				glGetUniformLocation(outputBoxProgram, "uColor"),
+				finalColor.r, finalColor.g, finalColor.b, finalColor.a
+			);
+
+		glBindVertexArray(output_box_VAO);
+		glDrawElements(GL_TRIANGLES, output_indices.size(), GL_UNSIGNED_INT, 0);
+		// palette swatches, opaque
+		if (!imagePalette.empty()) {
+			GLuint swatchProgram = finishProgram(swatch_shaderProgram);
+			glUseProgram(swatchProgram);
+			GLint rectLocation = glGetUniformLocation(swatchProgram, "uRect");
+			GLint colorLocation = glGetUniformLocation(swatchProgram, "uColor");
+			glBindVertexArray(swatch_VAO);
+			for (int i = 0; i < (int)imagePalette.size(); ++i) {
+				glm::vec4 rect = swatchRect(i, (int)imagePalette.size());
+				glm::vec3 rgb = imagePalette[i].rgb;
+				glUniform4f(rectLocation, rect.x, rect.y, rect.z, rect.w);
+				if (useSrgbPipeline)
+					glUniform4f(colorLocation, srgbToLinear(rgb.r), srgbToLinear(rgb.g), srgbToLinear(rgb.b), 1.0f);
+				else
+					glUniform4f(colorLocation, rgb.r, rgb.g, rgb.b, 1.0f);
+				glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+			}
+		}
+		// recent picks, with their alpha
+		if (colorHistory.depth() > 0) {
+			GLuint swatchProgram = finishProgram(swatch_shaderProgram);
+			glUseProgram(swatchProgram);
+			GLint rectLocation = glGetUniformLocation(swatchProgram, "uRect");
+			GLint colorLocation = glGetUniformLocation(swatchProgram, "uColor");
+			glBindVertexArray(swatch_VAO);
+			for (int i = 0; i < std::min(colorHistory.depth(), history_slots); ++i) {
+				glm::vec4 rect = historyRect(i);
+				glm::vec4 color = colorHistory.recent(i).color;
+				glUniform4f(rectLocation, rect.x, rect.y, rect.z, rect.w);
+				if (useSrgbPipeline)
+					glUniform4f(colorLocation, srgbToLinear(color.r), srgbToLinear(color.g), srgbToLinear(color.b), color.a);
+				else
+					glUniform4f(colorLocation, color.r, color.g, color.b, color.a);
+				glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+			}
+		}
+		endPass(PASS_OUTPUT_BOX);
+		// render text
+		beginPass(PASS_TEXT);
+		float lineY = textMargin + textAscent();
+		for (int i = 0; i < 4; ++i) {
+			renderText(readoutLabels[i], textMargin, lineY, 1.0f, 1.0f, 1.0f, 1.0f);
+			renderText(readoutValues[i], valueColumnRight, lineY, 1.0f, 1.0f, 1.0f, 1.0f, TextAlign::Right);
+			lineY += textLineHeight();
+		}
+		renderText(nearestName, textMargin, lineY, 1.0f, 1.0f, 1.0f, 1.0f);
+		if (hasReference) {
+			lineY += textLineHeight();
+			renderText(deltaEText, textMargin, lineY, 1.0f, 1.0f, 1.0f, 1.0f);
+		}
+		if (eyedropperMode) {
+			// rebuilt only when the built percentage or the zoom changes
+			int percent = (int)(eyedropperImage.progress() * 100.0f);
+			if (percent != imagePercentShown || eyedropperImage.zoomLevel() != imageZoomShown) {
+				imagePercentShown = percent;
+				imageZoomShown = eyedropperImage.zoomLevel();
+				char line[96];
+				snprintf(line, sizeof(line), "image %dx%d  %d%%  zoom %.3gx", eyedropperImage.width(), eyedropperImage.height(), percent,
+					imageZoomShown);
+				imageStatusText = line;
+			}
+			lineY += textLineHeight();
+			renderText(imageStatusText, textMargin, lineY, 1.0f, 1.0f, 1.0f, 1.0f);
+		}
+		if (recolorMode) {
+			if (recolorTextStale) {
+				recolorTextStale = false;
+				glm::vec3 lch = convertColor(ColorSpace::SRGB, ColorSpace::OKLCh, recolorParams.source);
+				char line[96];
+				if (recolorSelectsHue(recolorParams))
+					snprintf(line, sizeof(line), "recolor hue %.0f +/- %.0f (click the image to change)", lch.z, recolorParams.hueRange);
+				else
+					snprintf(line, sizeof(line), "recolor: click a colored pixel of the image");
+				recolorText = line;
+			}
+			lineY += textLineHeight();
+			renderText(recolorText, textMargin, lineY, 1.0f, 1.0f, 1.0f, 1.0f);
+		}
+		if (renderBench && renderScenario == RenderScenario::Labels) {
+			int fbWidth, fbHeight;
+			glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+			float xscale, yscale;
+			glfwGetWindowContentScale(window, &xscale, &yscale);
+			scenarioLabels(benchFrame, fbWidth / xscale, fbHeight / yscale, benchLabels);
+			for (const ScenarioLabel& label : benchLabels)
+				renderText(label.text, label.x, label.y, 1.0f, 1.0f, 1.0f, 1.0f);
+		}
+		//a font atlas baking in the background is swapped in by a later frame
+		if (textAtlasPending())
+			frameBusy = true;
+		endPass(PASS_TEXT);
+		endFrameStats(renderBench ? 1e9 : 2.0);
+		if (goldenTest) {
+			int fbWidth, fbHeight;
+			glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+			const GoldenState& state = goldenList[goldenIndex];
+			if ((fbWidth == state.width && fbHeight == state.height) || ++goldenWaitFrames >= 10) {
+				goldenRun->capture(state, fbWidth, fbHeight);
+				goldenWaitFrames = 0;
+				if (++goldenIndex == goldenList.size()) {
+					goldenFailures = goldenRun->finish();
+					break;
+				}
+			}
+		}
+		if (firstFrame) markStartup("first frame submitted");
+		glfwSwapBuffers(window);
+		if (firstFrame) {
+			markStartup("first frame presented");
+			printStartupTimeline();
+			firstFrame = false;
+		}
+		paceFrame();
+		if (renderBench) {
+			++benchFrame;
+			if (benchPhase > 0)
+				benchRun.frameDone();
+			if (benchPhase == 0 ? benchFrame == renderBenchWarmup : benchRun.done()) {
+				if (benchPhase == 2) {
+					printFrameStats();
+					break;
+				}
+				if (benchPhase == 0)
+					printf("\nRender benchmark: %s, %d frames per run, vsync off, %s\n", renderScenarioName(renderScenario),
+						renderBenchFrames, (const char*)glGetString(GL_RENDERER));
+				else {
+					benchRun.report();
+					setFrameStatsEnabled(true);
+					setFrameStatsSync(true);
+				}
+				benchRun.begin(renderBenchFrames);
+				++benchPhase;
+			}
+		}
+		++frameTimeCount;
+		double frameTimeNow = glfwGetTime();
+		if (frameTimeNow - frameTimeStart >= 0.5) {
+			char title[64];
+			snprintf(title, sizeof(title), "RGB circle - %.2f ms/frame (%s)", (frameTimeNow - frameTimeStart) * 1000.0 / frameTimeCount,
+				pacingModeName(pacingMode()));
+			glfwSetWindowTitle(window, title);
+			frameTimeStart = frameTimeNow;
+			frameTimeCount = 0;
+		}
+		//render-on-change: once nothing is left to show, sleep until an event asks for a frame (or a shader file changes)
+		if (pacingMode() == PacingMode::OnChange && !frameBusy && !redrawRequested && frameTimeNow >= changeSettledAt) {
+			while (!redrawRequested && !glfwWindowShouldClose(window)) {
+				glfwWaitEvents();
+				if (pollShaderReload())
+					break;
+			}
+			restartFramePacing();
+			frameTimeStart = glfwGetTime();
+			frameTimeCount = 0;
+		}
+		else
+			glfwPollEvents();
+		if (redrawRequested) {
+			redrawRequested = false;
+			changeSettledAt = glfwGetTime() + changeSettleTime;
+		}
+	}
+	//stop a pyramid build that is still running before the process exits
+	eyedropperImage.close();
+	glfwTerminate();
+	// Free memory
+	std::vector<float>().swap(vertices); 
+	std::vector<float>().swap(alpha_box_vertices); 
+	std::vector<float>().swap(alpha_triangle); 
+	std::vector<float>().swap(value_box_vertices);
+	std::vector<float>().swap(value_triangle);
+	std::vector<float>().swap(output_box_vertices);
+	std::vector<float>().swap(swatch_vertices);
+	return goldenTest ? finishCheck("golden", goldenFailures == 0) : 0;
+}
+#endif
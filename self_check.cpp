@@ -0,0 +1,12 @@
+#include "self_check.hpp"
+
+#include <iostream>
+
+int finishCheck(const char* name, bool passed)
+{
+    if (passed)
+        std::cout << "check " << name << ": passed" << std::endl;
+    else
+        std::cout << "ERROR::CHECK::FAILED " << name << std::endl;
+    return passed ? 0 : 1;
+}
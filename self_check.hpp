@@ -0,0 +1,11 @@
+#pragma once
+
+// =======================================================
+// Command-line checks
+// =======================================================
+
+// The end of every check run from the command line (--check-fast-math, the accuracy checks
+// --bench-color-spaces and --bench-delta-e start with, --golden). Each check prints its own
+// details first; this adds one summary line and returns the process exit status, 0 if the
+// check passed and 1 if it failed
+int finishCheck(const char* name, bool passed);
@@ -0,0 +1,526 @@
+#include "shader_manager.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// =======================================================
+// Program binary entry points
+// =======================================================
+
+// program binaries are core only from GL 4.1 (or ARB_get_program_binary), so the entry
+// points are looked up at runtime instead of relying on the loader being generated for them
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+// KHR_parallel_shader_compile (same values as the ARB variant)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRY* GetProgramBinaryFn)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+typedef void (APIENTRY* ProgramBinaryFn)(GLuint, GLenum, const void*, GLsizei);
+typedef void (APIENTRY* ProgramParameteriFn)(GLuint, GLenum, GLint);
+typedef void (APIENTRY* MaxShaderCompilerThreadsFn)(GLuint);
+
+static GetProgramBinaryFn pGetProgramBinary;
+static ProgramBinaryFn pProgramBinary;
+static ProgramParameteriFn pProgramParameteri;
+
+static std::string cacheDir = "shader_cache";
+static bool parallelChecked = false;
+static bool parallelSupported = false;
+static double waitSeconds = 0.0;
+static bool binariesChecked = false;
+static bool binariesSupported = false;
+
+static bool programBinariesSupported()
+{
+    if (binariesChecked) return binariesSupported;
+    binariesChecked = true;
+
+    pGetProgramBinary = (GetProgramBinaryFn)glfwGetProcAddress("glGetProgramBinary");
+    pProgramBinary = (ProgramBinaryFn)glfwGetProcAddress("glProgramBinary");
+    pProgramParameteri = (ProgramParameteriFn)glfwGetProcAddress("glProgramParameteri");
+
+    GLint formats = 0;
+    if (pGetProgramBinary && pProgramBinary && pProgramParameteri)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    // an unsupported query leaves an error behind, don't let it leak to the caller
+    while (glGetError() != GL_NO_ERROR) {}
+
+    binariesSupported = formats > 0;
+    return binariesSupported;
+}
+
+// lets the driver compile on its own threads; without the extension compiles still
+// overlap with our CPU work on drivers that defer them, we just can't poll for completion
+static bool enableParallelCompile()
+{
+    if (parallelChecked) return parallelSupported;
+    parallelChecked = true;
+
+    const char* names[2][2] = {
+        { "GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR" },
+        { "GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB" }
+    };
+    for (auto& n : names)
+    {
+        if (!glfwExtensionSupported(n[0])) continue;
+        MaxShaderCompilerThreadsFn maxThreads = (MaxShaderCompilerThreadsFn)glfwGetProcAddress(n[1]);
+        if (!maxThreads) continue;
+        // 0xFFFFFFFF asks for an implementation-chosen number of threads
+        maxThreads(0xFFFFFFFFu);
+        parallelSupported = true;
+        break;
+    }
+    return parallelSupported;
+}
+
+// =======================================================
+// Cache files
+// =======================================================
+
+// header written in front of every cached binary
+struct ProgramCacheHeader
+{
+    char magic[4];
+    uint32_t format;
+    uint32_t length;
+};
+
+static uint64_t fnv1a(uint64_t h, const char* data)
+{
+    if (!data) return h;
+    for (const unsigned char* p = (const unsigned char*)data; *p; ++p)
+    {
+        h ^= *p;
+        h *= 1099511628211ull;
+    }
+    // separator so "ab"+"c" and "a"+"bc" hash differently
+    h ^= 0xff;
+    h *= 1099511628211ull;
+    return h;
+}
+
+// binaries are only valid for the exact driver that produced them, so the driver
+// identity is part of the key alongside the sources
+static std::string cachePath(const char* name, const char* vs_src, const char* fs_src)
+{
+    uint64_t h = 14695981039346656037ull;
+    h = fnv1a(h, (const char*)glGetString(GL_VENDOR));
+    h = fnv1a(h, (const char*)glGetString(GL_RENDERER));
+    h = fnv1a(h, (const char*)glGetString(GL_VERSION));
+    h = fnv1a(h, vs_src);
+    h = fnv1a(h, fs_src);
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h);
+    return cacheDir + "/" + name + "-" + hex + ".bin";
+}
+
+static bool loadProgramBinary(GLuint program, const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    ProgramCacheHeader header;
+    if (!file.read((char*)&header, sizeof(header)) || memcmp(header.magic, "RGBP", 4) != 0)
+        return false;
+
+    // the length comes from the file, so it has to match what is left of it before anything is allocated
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - start;
+    file.seekg(start);
+    if (header.length == 0 || remaining != (std::streamoff)header.length)
+        return false;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+        return false;
+
+    pProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // a driver update can reject an old binary; the caller then falls back to compiling
+    int ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    while (glGetError() != GL_NO_ERROR) {}
+    return ok != 0;
+}
+
+static void saveProgramBinary(GLuint program, const std::string& path)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    pGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "shader cache: cannot write " << path << std::endl;
+        return;
+    }
+    ProgramCacheHeader header = { { 'R', 'G', 'B', 'P' }, format, static_cast<uint32_t>(length) };
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), binary.size());
+}
+
+// =======================================================
+
+// a program whose compile and link were issued but whose status hasn't been checked yet
+struct PendingProgram
+{
+    GLuint program, vs, fs;
+    std::string name;
+    std::string cachePath;
+};
+
+static std::vector<PendingProgram> pending;
+
+static GLuint issueShader(GLenum type, const char* src)
+{
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+    return s;
+}
+
+static void printShaderLog(GLuint s, const char* name, const char* stage)
+{
+    int ok;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (ok) return;
+    char log[1024];
+    glGetShaderInfoLog(s, 1024, nullptr, log);
+    std::cout << "ERROR::SHADER::" << name << "_" << stage << "::COMPILATION_FAILED\n" << log << std::endl;
+}
+
+// hot reload state: programs by name, and handle -> live program once a reload swapped one in
+static std::string reloadDir;
+static std::map<std::string, GLuint> programsByName;
+static std::unordered_map<GLuint, GLuint> liveProgram;
+
+static bool readFile(const std::string& path, std::string& out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// in hot reload mode sources come from <dir>/<name>.vert/.frag; missing files are seeded
+// with the built-in source so there is always something to edit
+static const char* reloadSource(const char* name, const char* ext, const char* builtin, std::string& storage)
+{
+    std::string path = reloadDir + "/" + name + ext;
+    if (readFile(path, storage))
+        return storage.c_str();
+    std::ofstream file(path, std::ios::binary);
+    file << builtin;
+    return builtin;
+}
+
+GLuint createProgram(const char* name, const char* vs_src, const char* fs_src)
+{
+    enableParallelCompile();
+    GLuint program = glCreateProgram();
+
+    std::string vsFile, fsFile;
+    if (!reloadDir.empty())
+    {
+        vs_src = reloadSource(name, ".vert", vs_src, vsFile);
+        fs_src = reloadSource(name, ".frag", fs_src, fsFile);
+        programsByName[name] = program;
+    }
+
+    bool useCache = !cacheDir.empty() && programBinariesSupported();
+    std::string path;
+    if (useCache)
+    {
+        path = cachePath(name, vs_src, fs_src);
+        if (loadProgramBinary(program, path))
+            return program;
+    }
+
+    // compile and link are only issued here; the status queries that would block on
+    // the driver are deferred to finishProgram, when the program is first needed
+    GLuint vs = issueShader(GL_VERTEX_SHADER, vs_src);
+    GLuint fs = issueShader(GL_FRAGMENT_SHADER, fs_src);
+
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    if (useCache)
+        pProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+
+    pending.push_back({ program, vs, fs, name, path });
+    return program;
+}
+
+GLuint finishProgram(GLuint program)
+{
+    if (!liveProgram.empty())
+    {
+        auto live = liveProgram.find(program);
+        if (live != liveProgram.end()) return live->second;
+    }
+    if (pending.empty()) return program;
+    auto it = std::find_if(pending.begin(), pending.end(),
+        [program](const PendingProgram& p) { return p.program == program; });
+    if (it == pending.end()) return program;
+
+    double start = glfwGetTime();
+    int ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        printShaderLog(it->vs, it->name.c_str(), "VERTEX");
+        printShaderLog(it->fs, it->name.c_str(), "FRAGMENT");
+        char log[1024];
+        glGetProgramInfoLog(program, 1024, nullptr, log);
+        std::cout << "ERROR::SHADER::" << it->name << "_PROGRAM::LINKING_FAILED\n" << log << std::endl;
+    }
+    waitSeconds += glfwGetTime() - start;
+
+    if (ok && !it->cachePath.empty())
+        saveProgramBinary(program, it->cachePath);
+
+    glDetachShader(program, it->vs);
+    glDetachShader(program, it->fs);
+    glDeleteShader(it->vs);
+    glDeleteShader(it->fs);
+    pending.erase(it);
+    return program;
+}
+
+double shaderWaitTime()
+{
+    return waitSeconds;
+}
+
+bool parallelShaderCompile()
+{
+    return parallelSupported;
+}
+
+std::string withPrelude(const char* src, const std::string& prelude)
+{
+    std::string out = src;
+    // #version has to stay the first line (raw string sources start after a blank one)
+    size_t version = out.find_first_not_of(" \t\r\n");
+    size_t lineEnd = out.find('\n', version);
+    if (version != std::string::npos && out.compare(version, 8, "#version") == 0 && lineEnd != std::string::npos)
+        out.insert(lineEnd + 1, prelude);
+    else
+        out.insert(0, prelude);
+    return out;
+}
+
+void setShaderCacheDir(const std::string& dir)
+{
+    cacheDir = dir;
+}
+
+// =======================================================
+// Hot reload
+// =======================================================
+
+// sources read by the watcher thread, handed to the GL thread through the queue
+struct ReloadSources
+{
+    std::string name, vs, fs;
+};
+
+// a replacement program being compiled; swapped in once it links
+struct ReloadingProgram
+{
+    GLuint handle, program, vs, fs;
+    std::string name;
+};
+
+static std::mutex reloadMutex;
+static std::vector<ReloadSources> reloadQueue;
+static std::vector<ReloadingProgram> reloading;
+
+// the watcher thread is stopped and joined at exit
+static struct ShaderWatcher
+{
+    std::thread thread;
+    std::atomic<bool> stop{ false };
+    ~ShaderWatcher()
+    {
+        stop = true;
+        if (thread.joinable()) thread.join();
+    }
+} watcher;
+
+static void queueReload(const std::string& dir, const std::string& name)
+{
+    ReloadSources src;
+    src.name = name;
+    // editors may save one stage while the other is mid-write; the next event retries
+    if (!readFile(dir + "/" + name + ".vert", src.vs) || !readFile(dir + "/" + name + ".frag", src.fs))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        reloadQueue.push_back(std::move(src));
+    }
+    glfwPostEmptyEvent();
+}
+
+#ifdef __linux__
+static void watchShaderDir(std::string dir)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        std::cout << "shader reload: cannot watch " << dir << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buf[4096];
+    while (!watcher.stop)
+    {
+        // wake up regularly to notice the stop flag
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) continue;
+
+        // a save usually produces several events; reload each program once
+        std::set<std::string> changed;
+        for (char* p = buf; p < buf + len; )
+        {
+            const inotify_event* ev = (const inotify_event*)p;
+            if (ev->len)
+            {
+                std::string file = ev->name;
+                size_t dot = file.rfind('.');
+                if (dot != std::string::npos &&
+                    (file.compare(dot, std::string::npos, ".vert") == 0 ||
+                     file.compare(dot, std::string::npos, ".frag") == 0))
+                    changed.insert(file.substr(0, dot));
+            }
+            p += sizeof(inotify_event) + ev->len;
+        }
+        for (const std::string& name : changed)
+            queueReload(dir, name);
+    }
+    close(fd);
+}
+#endif
+
+bool enableShaderHotReload(const std::string& dir)
+{
+#ifdef __linux__
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    reloadDir = dir;
+    watcher.thread = std::thread(watchShaderDir, dir);
+    std::cout << "shader reload: watching " << dir << std::endl;
+    return true;
+#else
+    std::cout << "shader reload: not supported on this platform" << std::endl;
+    return false;
+#endif
+}
+
+bool pollShaderReload()
+{
+    if (reloadDir.empty()) return false;
+
+    std::vector<ReloadSources> queued;
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        queued.swap(reloadQueue);
+    }
+
+    // issue the new compiles; they don't replace anything until they have linked
+    for (const ReloadSources& src : queued)
+    {
+        auto named = programsByName.find(src.name);
+        if (named == programsByName.end()) continue;
+
+        GLuint program = glCreateProgram();
+        GLuint vs = issueShader(GL_VERTEX_SHADER, src.vs.c_str());
+        GLuint fs = issueShader(GL_FRAGMENT_SHADER, src.fs.c_str());
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        glLinkProgram(program);
+        reloading.push_back({ named->second, program, vs, fs, src.name });
+    }
+
+    bool swapped = false;
+    for (auto it = reloading.begin(); it != reloading.end(); )
+    {
+        // with parallel compile we wait for the driver; without it the status query
+        // blocks once, on the frame after the file was saved
+        if (parallelSupported)
+        {
+            int done = 0;
+            glGetProgramiv(it->program, GL_COMPLETION_STATUS_KHR, &done);
+            if (!done) { ++it; continue; }
+        }
+
+        int ok;
+        glGetProgramiv(it->program, GL_LINK_STATUS, &ok);
+        if (ok)
+        {
+            // the original handle stays alive so its name is never reused by GL
+            GLuint previous = finishProgram(it->handle);
+            if (previous != it->handle) glDeleteProgram(previous);
+            liveProgram[it->handle] = it->program;
+            swapped = true;
+            std::cout << "shader reload: " << it->name << " swapped in" << std::endl;
+        }
+        else
+        {
+            printShaderLog(it->vs, it->name.c_str(), "VERTEX");
+            printShaderLog(it->fs, it->name.c_str(), "FRAGMENT");
+            char log[1024];
+            glGetProgramInfoLog(it->program, 1024, nullptr, log);
+            std::cout << "ERROR::SHADER::" << it->name << "_PROGRAM::LINKING_FAILED (keeping the previous program)\n"
+                << log << std::endl;
+            glDeleteProgram(it->program);
+        }
+        glDeleteShader(it->vs);
+        glDeleteShader(it->fs);
+        it = reloading.erase(it);
+    }
+    return swapped || !reloading.empty();
+}
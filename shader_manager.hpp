@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <glad/glad.h>
+
+// issues the compile and link of a program from vertex and fragment sources without waiting
+// for them; the name is used in error messages and cache file names. Linked programs are
+// stored in the binary cache and reloaded from it on later runs when the driver, its version
+// and the sources are unchanged
+GLuint createProgram(const char* name, const char* vs_src, const char* fs_src);
+// completes a program the first time it is needed: checks its status, prints the logs and
+// stores the binary; cheap for programs that are already complete. Returns the GL program to
+// use, which differs from the handle returned by createProgram once a hot reload replaced it
+GLuint finishProgram(GLuint program);
+// total seconds spent blocked in finishProgram waiting for the driver
+double shaderWaitTime();
+// whether the driver compiles on background threads (GL_KHR_parallel_shader_compile)
+bool parallelShaderCompile();
+// returns the source with the prelude (defines, helper functions) inserted after its #version line
+std::string withPrelude(const char* src, const std::string& prelude);
+// directory for the binary program cache, "shader_cache" by default; empty disables the cache
+void setShaderCacheDir(const std::string& dir);
+// loads program sources from <dir>/<name>.vert and .frag (seeding missing files with the
+// built-in sources) and watches the directory; call before creating programs (Linux only)
+bool enableShaderHotReload(const std::string& dir);
+// issues recompiles for changed files and swaps in programs that linked successfully;
+// call once per frame between frames. A failed link keeps the previous program. True while
+// recompiles are in flight or when a program was swapped in, i.e. when another frame is due.
+// The watcher posts an empty event for every change, so a loop waiting on events wakes up
+bool pollShaderReload();
@@ -0,0 +1,197 @@
+#pragma once
+
+// =======================================================
+// SSE2 building blocks shared by the batch color kernels
+// =======================================================
+//
+// Float-accurate log/exp/atan/sincos after the Cephes single precision routines (range
+// reduction plus minimax polynomials, about 1 ulp on their own), and the SSE2 versions of the
+// fast_math.hpp approximations. Only included by translation units that check RGBPICK_SSE2 first.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define RGBPICK_SSE2 1
+#include <emmintrin.h>
+
+// floor for |x| < 2^31
+static inline __m128 floor_ps(__m128 x)
+{
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    // truncation rounded negative values up; step those back down
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+// natural log, x > 0
+static inline __m128 log_ps(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i xi = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(xi, 23), _mm_set1_epi32(126)));
+    // mantissa in [0.5, 1)
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(xi, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3f000000)));
+
+    // move m into [sqrt(0.5), sqrt(2)) - 1
+    __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+    e = _mm_sub_ps(e, _mm_and_ps(one, small));
+    m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(m, small)), one);
+
+    __m128 z = _mm_mul_ps(m, m);
+    __m128 y = _mm_set1_ps(7.0376836292E-2f);
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174E-1f));
+    y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+// natural exp, result flushes to 0 / saturates outside about [-87, 88]
+static inline __m128 exp_ps(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.3f)), _mm_set1_ps(88.3f));
+    __m128 fx = floor_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(1.9875691500E-4f);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507E-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073E-3f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894E-2f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201E-1f));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), _mm_set1_ps(1.0f));
+
+    // scale by 2^fx through the exponent bits
+    __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+}
+
+// x^p for x >= 0 (0 maps to 0)
+static inline __m128 pow_ps(__m128 x, float p)
+{
+    __m128 positive = _mm_cmpgt_ps(x, _mm_setzero_ps());
+    __m128 safe = _mm_max_ps(x, _mm_set1_ps(1e-30f));
+    return _mm_and_ps(positive, exp_ps(_mm_mul_ps(log_ps(safe), _mm_set1_ps(p))));
+}
+
+static inline __m128 clamp01_ps(__m128 x)
+{
+    return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+// picks a where mask is set, b elsewhere
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 abs_ps(__m128 x)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+}
+
+// cube root keeping the sign, for the Lab / OKLab nonlinearities
+static inline __m128 cbrt_ps(__m128 x)
+{
+    __m128 sign = _mm_and_ps(x, _mm_set1_ps(-0.0f));
+    return _mm_or_ps(pow_ps(abs_ps(x), 1.0f / 3.0f), sign);
+}
+
+// atan2 in [-pi, pi] (Cephes atanf polynomial on the octant-reduced ratio, about 1e-7 rad);
+// atan2(0, 0) is 0
+static inline __m128 atan2_ps(__m128 y, __m128 x)
+{
+    __m128 ax = abs_ps(x), ay = abs_ps(y);
+    __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    __m128 t = _mm_div_ps(mn, _mm_max_ps(mx, _mm_set1_ps(1e-30f)));
+
+    // t in [0, 1]; above tan(pi/8) use atan(t) = pi/4 + atan((t - 1) / (t + 1))
+    __m128 big = _mm_cmpgt_ps(t, _mm_set1_ps(0.4142135623730950f));
+    __m128 tr = select_ps(big, _mm_div_ps(_mm_sub_ps(t, _mm_set1_ps(1.0f)), _mm_add_ps(t, _mm_set1_ps(1.0f))), t);
+    __m128 z = _mm_mul_ps(tr, tr);
+    __m128 p = _mm_set1_ps(8.05374449538e-2f);
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-1.38776856032e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.99777106478e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(-3.33329491539e-1f));
+    __m128 a = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), tr), tr);
+    a = _mm_add_ps(a, _mm_and_ps(big, _mm_set1_ps(0.78539816339744831f)));
+
+    // undo the octant and quadrant folding
+    a = select_ps(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(1.57079632679489662f), a), a);
+    a = select_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(3.14159265358979324f), a), a);
+    return _mm_or_ps(a, _mm_and_ps(y, _mm_set1_ps(-0.0f)));
+}
+
+// fastAtan2 (fast_math.hpp) on four lanes: the same A&S 4.4.49 polynomial and octant reduction,
+// about 1.2e-5 rad, for picking where atan2_ps's precision isn't needed; atan2(0, 0) is 0
+static inline __m128 fastAtan2_ps(__m128 y, __m128 x)
+{
+    __m128 ax = abs_ps(x), ay = abs_ps(y);
+    __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    // 0/0 lanes are masked to 0
+    __m128 a = _mm_and_ps(_mm_div_ps(mn, mx), _mm_cmpgt_ps(mx, _mm_setzero_ps()));
+    __m128 s = _mm_mul_ps(a, a);
+    __m128 r = _mm_set1_ps(0.0208351f);
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.0851330f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.1801410f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.3302995f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.9998660f));
+    r = _mm_mul_ps(r, a);
+
+    r = select_ps(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(1.57079632679489662f), r), r);
+    r = select_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(3.14159265358979324f), r), r);
+    // the sign of y carries over
+    return _mm_xor_ps(r, _mm_and_ps(y, _mm_set1_ps(-0.0f)));
+}
+
+// fastRsqrt on four lanes: rsqrtps plus one Newton step, about 4.4e-6 relative
+static inline __m128 fastRsqrt_ps(__m128 v)
+{
+    __m128 r = _mm_rsqrt_ps(v);
+    // r * (1.5 - 0.5 * v * r * r)
+    __m128 h = _mm_mul_ps(_mm_set1_ps(0.5f), v);
+    return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(h, _mm_mul_ps(r, r))));
+}
+
+// sine and cosine together (Cephes sinf/cosf), accurate to about 1 ulp for |x| < 8192
+static inline void sincos_ps(__m128 x, __m128* s, __m128* c)
+{
+    __m128 signSin = _mm_and_ps(x, _mm_set1_ps(-0.0f));
+    x = abs_ps(x);
+
+    // octant index rounded up to even, so the reduced argument is in [-pi/4, pi/4]
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+    signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+    __m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+    __m128 sinPoly = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 pc = _mm_set1_ps(2.443315711809948e-5f);
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(-1.388731625493765e-3f));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(4.166664568298827e-2f));
+    pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+    pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    __m128 ps = _mm_set1_ps(-1.9515295891e-4f);
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(8.3321608736e-3f));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(-1.6666654611e-1f));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+
+    *s = _mm_xor_ps(select_ps(sinPoly, ps, pc), signSin);
+    *c = _mm_xor_ps(select_ps(sinPoly, pc, ps), signCos);
+}
+
+#endif
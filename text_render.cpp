@@ -1,216 +1,393 @@
-#define STB_TRUETYPE_IMPLEMENTATION
-#include "stb_truetype.h"
-
-#include "text_render.hpp"
-
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <cmath>
-
-// =======================================================
-// Simple shaders for text
-// =======================================================
-
-const char* text_vs = R"(
-#version 330 core
-layout (location = 0) in vec4 vertex; // x,y,u,v
-out vec2 TexCoord;
-
-uniform mat4 projection;
-
-void main()
-{
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-    TexCoord = vertex.zw;
-}
-)";
-
-const char* text_fs = R"(
-#version 330 core
-in vec2 TexCoord;
-out vec4 FragColor;
-
-uniform sampler2D fontTex;
-uniform vec4 textColor;
-
-void main()
-{
-    float alpha = texture(fontTex, TexCoord).r;
-    FragColor = vec4(textColor.rgb, textColor.a * alpha);
-}
-)";
-
-// =======================================================
-
-GLuint compileShader(GLenum type, const char* src)
-{
-    GLuint s = glCreateShader(type);
-    glShaderSource(s, 1, &src, nullptr);
-    glCompileShader(s);
-
-    int ok;
-    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-    if (!ok)
-    {
-        char log[1024];
-        glGetShaderInfoLog(s, 1024, nullptr, log);
-        std::cout << log << std::endl;
-    }
-    return s;
-}
-
-// =======================================================
-// Global font data
-// =======================================================
-
-stbtt_bakedchar cdata[96]; // ASCII 32..126
-GLuint fontTex;
-GLuint VAO, VBO;
-GLuint shader;
-GLuint projectionLoc, colorLoc;
-
-// =======================================================
-
-void initText(int window_w,int window_h)
-{
-    // ---- load font file
-    std::ifstream file("Arial.ttf", std::ios::binary);
-    if (!file)
-    {
-        std::cout << "Arial.ttf not found\n";
-        exit(1);
-    }
-
-    std::vector<unsigned char> ttf((std::istreambuf_iterator<char>(file)),
-        std::istreambuf_iterator<char>());
-
-    // ---- bake font
-    const int TEX_W = 512;
-    const int TEX_H = 512;
-    std::vector<unsigned char> bitmap(TEX_W * TEX_H);
-
-    stbtt_BakeFontBitmap(
-        ttf.data(), 0,
-        32.0f,
-        bitmap.data(), TEX_W, TEX_H,
-        32, 96, cdata
-    );
-
-    // ---- upload texture
-    glGenTextures(1, &fontTex);
-    glBindTexture(GL_TEXTURE_2D, fontTex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, TEX_W, TEX_H, 0, GL_RED, GL_UNSIGNED_BYTE, bitmap.data());
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // ---- shader
-    GLuint vs = compileShader(GL_VERTEX_SHADER, text_vs);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, text_fs);
-
-    shader = glCreateProgram();
-    glAttachShader(shader, vs);
-    glAttachShader(shader, fs);
-    glLinkProgram(shader);
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    // ---- buffers
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // ---- projection
-    float ortho[16] = {
-        2.0f / window_w, 0, 0, 0,
-        0, -2.0f / window_h, 0, 0,
-        0, 0, -1, 0,
-        -1, 1, 0, 1
-    };
-
-    glUseProgram(shader);
-    projectionLoc = glGetUniformLocation(shader, "projection");
-    colorLoc = glGetUniformLocation(shader, "textColor");
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, ortho);
-}
-
-// =======================================================
-
-void renderText(const std::string& text, float x, float y, float r, float g, float b, float a)
-{
-    glUseProgram(shader);
-    glUniform4f(colorLoc, r, g, b, a);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, fontTex);
-    glBindVertexArray(VAO);
-
-    for (char c : text)
-    {
-        if (c < 32 || c > 126) continue;
-
-        stbtt_aligned_quad q;
-        stbtt_GetBakedQuad(cdata, 512, 512, c - 32, &x, &y, &q, 1);
-
-        float verts[6][4] = {
-            { q.x0, q.y0, q.s0, q.t0 },
-            { q.x1, q.y0, q.s1, q.t0 },
-            { q.x1, q.y1, q.s1, q.t1 },
-
-            { q.x0, q.y0, q.s0, q.t0 },
-            { q.x1, q.y1, q.s1, q.t1 },
-            { q.x0, q.y1, q.s0, q.t1 }
-        };
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-    }
-}
-
-// =======================================================
-
-//int main()
-//{
-//    glfwInit();
-//    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-//    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-//    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-//
-//    GLFWwindow* window = glfwCreateWindow(WINDOW_W, WINDOW_H, "Text Rendering", nullptr, nullptr);
-//    glfwMakeContextCurrent(window);
-//    gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-//
-//    glEnable(GL_BLEND);
-//    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-//
-//    initText();
-//
-//    while (!glfwWindowShouldClose(window))
-//    {
-//        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-//        glClear(GL_COLOR_BUFFER_BIT);
-//
-//        renderText("R: 255", 20, 50, 1, 0, 0, 1);
-//        renderText("G: 128", 20, 80, 0, 1, 0, 1);
-//        renderText("B: 64", 20, 110, 0, 0, 1, 1);
-//        renderText("A: 200", 20, 140, 1, 1, 1, 1);
-//
-//        glfwSwapBuffers(window);
-//        glfwPollEvents();
-//    }
-//
-//    glfwTerminate();
-//    return 0;
-//}
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#include "text_render.hpp"
+#include "shader_manager.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <unordered_map>
+#include <future>
+#include <chrono>
+#include <cmath>
+
+// =======================================================
+// Simple shaders for text
+// =======================================================
+
+const char* text_vs = R"(
+#version 330 core
+layout (location = 0) in vec4 vertex; // x,y,u,v
+out vec2 TexCoord;
+
+uniform mat4 projection;
+uniform vec2 offset;
+
+void main()
+{
+    gl_Position = projection * vec4(vertex.xy + offset, 0.0, 1.0);
+    TexCoord = vertex.zw;
+}
+)";
+
+const char* text_fs = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D fontTex;
+uniform vec4 textColor;
+
+void main()
+{
+    float alpha = texture(fontTex, TexCoord).r;
+    FragColor = vec4(textColor.rgb, textColor.a * alpha);
+}
+)";
+
+// =======================================================
+
+// =======================================================
+// Global font data
+// =======================================================
+
+// base pixel height of the font, in UI units (device pixels at content scale 1)
+const float FONT_PX = 32.0f;
+
+stbtt_bakedchar cdata[96]; // ASCII 32..126
+GLuint fontTex;
+GLuint VAO, VBO;
+GLuint shader;
+static GLuint liveShader;
+GLuint projectionLoc, colorLoc, offsetLoc;
+
+// font file and metrics kept around for kerning lookups during layout
+static std::vector<unsigned char> ttf;
+static stbtt_fontinfo fontInfo;
+static int glyphIndex[96];
+static float fontAscent, fontDescent, fontLineGap;
+
+// the atlas is rasterized at FONT_PX * atlasScale device pixels;
+// fontScale converts font units to those device pixels
+static float atlasScale = 1.0f;
+static int atlasW = 512, atlasH = 512;
+static float fontScale;
+
+// view size in UI units and whether the projection uniform needs refreshing
+static float viewW, viewH;
+static bool projectionDirty = true;
+
+// =======================================================
+// Atlas baking (CPU only, safe to run off the GL thread)
+// =======================================================
+
+struct BakedAtlas
+{
+    float scale;
+    int w, h;
+    std::vector<unsigned char> bitmap;
+    stbtt_bakedchar chars[96];
+};
+
+static BakedAtlas bakeAtlas(float scale)
+{
+    BakedAtlas atlas;
+    atlas.scale = scale;
+    // 512x512 holds the printable ASCII range at 32px, grow it with the pixel density
+    int grow = static_cast<int>(std::ceil(scale));
+    atlas.w = 512 * grow;
+    atlas.h = 512 * grow;
+    atlas.bitmap.resize(static_cast<size_t>(atlas.w) * atlas.h);
+
+    stbtt_BakeFontBitmap(
+        ttf.data(), 0,
+        FONT_PX * scale,
+        atlas.bitmap.data(), atlas.w, atlas.h,
+        32, 96, atlas.chars
+    );
+    return atlas;
+}
+
+// scale the atlas should be at, and the bake in flight (if any)
+static float wantedScale = 1.0f;
+static std::future<BakedAtlas> pendingAtlas;
+
+static void uploadAtlas(const BakedAtlas& atlas)
+{
+    glBindTexture(GL_TEXTURE_2D, fontTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas.w, atlas.h, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.bitmap.data());
+
+    std::copy(atlas.chars, atlas.chars + 96, cdata);
+    atlasScale = atlas.scale;
+    atlasW = atlas.w;
+    atlasH = atlas.h;
+    fontScale = stbtt_ScaleForPixelHeight(&fontInfo, FONT_PX * atlasScale);
+}
+
+// =======================================================
+// Laid out glyph runs
+// =======================================================
+
+// a laid out string: two triangles (x,y,u,v) per glyph in UI units, pen starting at (0,0)
+struct TextRun
+{
+    std::vector<float> verts;
+    float width;
+};
+
+// runs are keyed by their text, so drawing an unchanged string skips layout entirely;
+// the cache is simply dropped when it grows past the limit (readouts churn through values)
+// and whenever the atlas is re-baked
+static std::unordered_map<std::string, TextRun> runCache;
+static const size_t RUN_CACHE_LIMIT = 256;
+
+static const TextRun& layoutText(const std::string& text)
+{
+    auto it = runCache.find(text);
+    if (it != runCache.end())
+        return it->second;
+
+    if (runCache.size() >= RUN_CACHE_LIMIT)
+        runCache.clear();
+
+    TextRun run;
+    run.verts.reserve(text.size() * 6 * 4);
+
+    // pen runs in atlas (device) pixels so the baked quads snap to the device grid
+    float x = 0.0f, y = 0.0f;
+    float toUnits = 1.0f / atlasScale;
+    int prevGlyph = 0;
+    for (char c : text)
+    {
+        if (c < 32 || c > 126) continue;
+
+        // kern against the previous glyph (kern table or GPOS pair adjustment)
+        int glyph = glyphIndex[c - 32];
+        if (prevGlyph)
+            x += fontScale * stbtt_GetGlyphKernAdvance(&fontInfo, prevGlyph, glyph);
+        prevGlyph = glyph;
+
+        stbtt_aligned_quad q;
+        stbtt_GetBakedQuad(cdata, atlasW, atlasH, c - 32, &x, &y, &q, 1);
+        q.x0 *= toUnits; q.x1 *= toUnits;
+        q.y0 *= toUnits; q.y1 *= toUnits;
+
+        float verts[6][4] = {
+            { q.x0, q.y0, q.s0, q.t0 },
+            { q.x1, q.y0, q.s1, q.t0 },
+            { q.x1, q.y1, q.s1, q.t1 },
+
+            { q.x0, q.y0, q.s0, q.t0 },
+            { q.x1, q.y1, q.s1, q.t1 },
+            { q.x0, q.y1, q.s0, q.t1 }
+        };
+        run.verts.insert(run.verts.end(), &verts[0][0], &verts[0][0] + 24);
+    }
+    run.width = x * toUnits;
+
+    return runCache.emplace(text, std::move(run)).first->second;
+}
+
+// =======================================================
+
+void initText(int framebuffer_w, int framebuffer_h, float content_scale)
+{
+    // ---- shader (issued first so the driver compiles it while the font is baked)
+    shader = createProgram("text", text_vs, text_fs);
+
+    // ---- load font file
+    std::ifstream file("Arial.ttf", std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Arial.ttf not found\n";
+        exit(1);
+    }
+
+    ttf.assign((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+
+    if (!stbtt_InitFont(&fontInfo, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0)))
+    {
+        std::cout << "Arial.ttf could not be parsed\n";
+        exit(1);
+    }
+
+    // ---- metrics for layout, in UI units so they don't move when the atlas is re-baked
+    float unitScale = stbtt_ScaleForPixelHeight(&fontInfo, FONT_PX);
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(&fontInfo, &ascent, &descent, &lineGap);
+    fontAscent = ascent * unitScale;
+    fontDescent = descent * unitScale;
+    fontLineGap = lineGap * unitScale;
+    for (int i = 0; i < 96; ++i)
+        glyphIndex[i] = stbtt_FindGlyphIndex(&fontInfo, 32 + i);
+
+    // ---- bake font and upload texture (the first bake is synchronous)
+    glGenTextures(1, &fontTex);
+    glBindTexture(GL_TEXTURE_2D, fontTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    wantedScale = content_scale > 0.0f ? content_scale : 1.0f;
+    uploadAtlas(bakeAtlas(wantedScale));
+
+    // ---- buffers
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4 * 64, nullptr, GL_DYNAMIC_DRAW);
+
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // uniform locations are looked up on first draw so the link can finish in the background
+    resizeText(framebuffer_w, framebuffer_h, wantedScale);
+}
+
+// =======================================================
+
+void resizeText(int framebuffer_w, int framebuffer_h, float content_scale)
+{
+    if (content_scale <= 0.0f) content_scale = 1.0f;
+    // UI units are device pixels divided by the content scale
+    viewW = framebuffer_w / content_scale;
+    viewH = framebuffer_h / content_scale;
+    projectionDirty = true;
+    wantedScale = content_scale;
+}
+
+bool textAtlasPending()
+{
+    return pendingAtlas.valid() || wantedScale != atlasScale;
+}
+
+// applies pending resize/scale changes; cheap when nothing changed
+static void updateText()
+{
+    // the live program changes after a shader hot reload; its uniforms start from scratch
+    GLuint program = finishProgram(shader);
+    if (program != liveShader)
+    {
+        liveShader = program;
+        projectionLoc = glGetUniformLocation(liveShader, "projection");
+        colorLoc = glGetUniformLocation(liveShader, "textColor");
+        offsetLoc = glGetUniformLocation(liveShader, "offset");
+        projectionDirty = true;
+    }
+
+    if (projectionDirty && viewW > 0.0f && viewH > 0.0f)
+    {
+        float ortho[16] = {
+            2.0f / viewW, 0, 0, 0,
+            0, -2.0f / viewH, 0, 0,
+            0, 0, -1, 0,
+            -1, 1, 0, 1
+        };
+        glUseProgram(liveShader);
+        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, ortho);
+        projectionDirty = false;
+    }
+
+    // a finished bake is swapped in between draws; until then the old atlas is simply stretched
+    if (pendingAtlas.valid() &&
+        pendingAtlas.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        uploadAtlas(pendingAtlas.get());
+        runCache.clear();
+    }
+
+    // content scale only changes when moving between monitors, so plain resizes never re-rasterize
+    if (!pendingAtlas.valid() && wantedScale != atlasScale)
+        pendingAtlas = std::async(std::launch::async, bakeAtlas, wantedScale);
+}
+
+// =======================================================
+
+float measureText(const std::string& text)
+{
+    return layoutText(text).width;
+}
+
+float textAscent()
+{
+    return fontAscent;
+}
+
+float textLineHeight()
+{
+    return fontAscent - fontDescent + fontLineGap;
+}
+
+// =======================================================
+
+void renderText(const std::string& text, float x, float y, float r, float g, float b, float a, TextAlign align)
+{
+    updateText();
+
+    const TextRun& run = layoutText(text);
+    if (run.verts.empty()) return;
+
+    if (align == TextAlign::Right) x -= run.width;
+    else if (align == TextAlign::Center) x -= run.width * 0.5f;
+
+    glUseProgram(liveShader);
+    glUniform4f(colorLoc, r, g, b, a);
+    // whole device pixels keep the baked glyphs crisp, the run was laid out at the origin
+    glUniform2f(offsetLoc,
+        floorf(x * atlasScale + 0.5f) / atlasScale,
+        floorf(y * atlasScale + 0.5f) / atlasScale);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, fontTex);
+    glBindVertexArray(VAO);
+
+    // one upload and one draw call for the whole run
+    GLsizeiptr bytes = sizeof(float) * run.verts.size();
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, run.verts.data());
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(run.verts.size() / 4));
+}
+
+// =======================================================
+
+//int main()
+//{
+//    glfwInit();
+//    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+//    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+//    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+//
+//    GLFWwindow* window = glfwCreateWindow(WINDOW_W, WINDOW_H, "Text Rendering", nullptr, nullptr);
+//    glfwMakeContextCurrent(window);
+//    gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+//
+//    glEnable(GL_BLEND);
+//    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+//
+//    initText();
+//
+//    while (!glfwWindowShouldClose(window))
+//    {
+//        glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+//        glClear(GL_COLOR_BUFFER_BIT);
+//
+//        renderText("R: 255", 20, 50, 1, 0, 0, 1);
+//        renderText("G: 128", 20, 80, 0, 1, 0, 1);
+//        renderText("B: 64", 20, 110, 0, 0, 1, 1);
+//        renderText("A: 200", 20, 140, 1, 1, 1, 1);
+//
+//        glfwSwapBuffers(window);
+//        glfwPollEvents();
+//    }
+//
+//    glfwTerminate();
+//    return 0;
+//}
@@ -1,14 +1,28 @@
-#pragma once
-
-#include <string>
-#include <glad/glad.h>
-
-GLuint compileShader(GLenum type, const char* src);
-// initializes text rendering system with given window dimensions
-void initText(int window_w, int window_h);
-// renders the given text at specified position with given color
-void renderText(
-    const std::string& text,
-    float x, float y,
-    float r, float g, float b, float a
-);
+#pragma once
+
+#include <string>
+#include <glad/glad.h>
+
+// initializes text rendering system for the given framebuffer size and content scale;
+// text positions are in UI units (framebuffer pixels divided by the content scale)
+void initText(int framebuffer_w, int framebuffer_h, float content_scale = 1.0f);
+// updates the projection after a resize; a content scale change re-bakes the font atlas
+// at the new pixel density in the background and swaps it in once ready
+void resizeText(int framebuffer_w, int framebuffer_h, float content_scale = 1.0f);
+// true while an atlas for a new content scale is baking or waiting to be swapped in by a draw
+bool textAtlasPending();
+// horizontal anchor of the x position passed to renderText
+enum class TextAlign { Left, Center, Right };
+// width in pixels of the laid out (kerned) text
+float measureText(const std::string& text);
+// distance from the top of a line to its baseline, in pixels
+float textAscent();
+// baseline to baseline distance, in pixels
+float textLineHeight();
+// renders the given text with its baseline at the specified position with given color
+void renderText(
+    const std::string& text,
+    float x, float y,
+    float r, float g, float b, float a,
+    TextAlign align = TextAlign::Left
+);
@@ -0,0 +1,96 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+// =======================================================
+// Workers
+// =======================================================
+
+// set on pool workers, and on a caller while it runs its share of a loop
+static thread_local bool inLoop = false;
+
+ThreadPool& sharedThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& w : workers) w.join();
+}
+
+void ThreadPool::runItems(const std::function<void(size_t)>& fn, size_t n)
+{
+    size_t i;
+    while ((i = next.fetch_add(1)) < n)
+        fn(i);
+}
+
+void ThreadPool::workerLoop()
+{
+    inLoop = true;
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;)
+    {
+        wake.wait(guard, [&]() { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        // the loop may already be over when this worker gets to it
+        if (!job) continue;
+        // copied under the lock: the caller clears job as soon as its own share is done
+        const std::function<void(size_t)>& fn = *job;
+        size_t n = count;
+        ++busy;
+        guard.unlock();
+        runItems(fn, n);
+        guard.lock();
+        if (--busy == 0) finished.notify_all();
+    }
+}
+
+// =======================================================
+// Parallel loop
+// =======================================================
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t)>& fn)
+{
+    if (n == 0) return;
+    // the workers may all be busy with the outer loop, waiting on this one
+    if (inLoop)
+    {
+        for (size_t i = 0; i < n; ++i)
+            fn(i);
+        return;
+    }
+    std::lock_guard<std::mutex> loopGuard(loopLock);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &fn;
+        count = n;
+        next = 0;
+        ++generation;
+    }
+    if (n > 1) wake.notify_all();
+    inLoop = true;
+    runItems(fn, n);
+    inLoop = false;
+    // no new workers join once job is cleared; wait for the ones still running items
+    std::unique_lock<std::mutex> guard(lock);
+    job = nullptr;
+    finished.wait(guard, [&]() { return busy == 0; });
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =======================================================
+// Persistent worker threads for parallel loops
+// =======================================================
+
+// A fixed set of worker threads that help run parallel loops. No threads are started per
+// call, so it suits many small loops, e.g. one per decoded band of an image. Items are
+// handed out one index at a time.
+class ThreadPool
+{
+public:
+    // threads = 0: one per hardware thread besides the caller
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    // calls fn(i) for every i in [0, n) on the workers and the calling thread, returning once
+    // all calls are done. Loops from different threads take turns; a loop started from inside
+    // another one (on any pool) runs on the calling thread alone
+    void parallelFor(size_t n, const std::function<void(size_t)>& fn);
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+private:
+    void workerLoop();
+    void runItems(const std::function<void(size_t)>& fn, size_t n);
+
+    std::vector<std::thread> workers;
+    std::mutex loopLock;  // one loop at a time
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    const std::function<void(size_t)>* job = nullptr;
+    std::atomic<size_t> next{ 0 };
+    size_t count = 0;
+    unsigned busy = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+};
+
+// the pool the app's parallel loops share, one worker per hardware thread besides the caller
+ThreadPool& sharedThreadPool();
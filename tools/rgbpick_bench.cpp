@@ -0,0 +1,257 @@
+// rgbpick-bench: micro-benchmarks (Google Benchmark) of the picker's per-pick math and input
+// handling: HSV conversion, the bar mappings, screen -> NDC, the hit tests and the whole mouse
+// button callback. Each benchmark runs over a batch of varied inputs per iteration, for batch
+// sizes 8 to 32768, and reports items per second.
+//
+//   rgbpick-bench [--benchmark_filter=REGEX] [--benchmark_repetitions=N]
+//                 [--benchmark_format=json] [--benchmark_out=FILE --benchmark_out_format=json]
+//
+// JSON output is Google Benchmark's, so runs can be compared with its tools/compare.py.
+// Functions of rgb_main.cpp are reached by building it with RGBPICK_NO_MAIN; a hidden GLFW
+// window stands in for the app's, and the benchmarks that need one are skipped without it.
+// Build: g++ -std=c++17 -O2 -DRGBPICK_NO_MAIN -I. tools/rgbpick_bench.cpp *.cpp glad.c -o rgbpick-bench
+//            -lbenchmark -lglfw -lGL -lpng -ljpeg -lz -lpthread
+#include "color_spaces.hpp"
+#include "simd_math.hpp"
+
+#include <benchmark/benchmark.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// rgb_main.cpp
+float calculateAlphaValue(float ypos);
+float calculateBrightnessValue(float ypos);
+void screenToNDC(GLFWwindow* window, double xpos, double ypos, float& ndcx, float& ndcy);
+bool is_inside_circle(float x, float y);
+bool is_inside_alpha_box(float x, float y);
+bool is_inside_value_box(float x, float y);
+glm::vec3 pickerToRGB(float hue, float saturation, float value);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void setScriptedCursor(double sx, double sy);
+
+static GLFWwindow* benchWindow = nullptr;
+static const int WINDOW_SIZE = 800;
+
+// inputs are drawn from a fixed sequence, so every run and batch size sees the same values
+static std::vector<float> uniformValues(size_t n, float lo, float hi, uint32_t seed)
+{
+    std::vector<float> v(n);
+    for (float& x : v)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        x = lo + (hi - lo) * ((seed >> 8) * (1.0f / 16777216.0f));
+    }
+    return v;
+}
+
+static void batchSizes(benchmark::internal::Benchmark* b)
+{
+    b->RangeMultiplier(8)->Range(8, 32768);
+}
+
+// =======================================================
+// Color math
+// =======================================================
+
+static void BM_HSVtoRGB(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> h = uniformValues(n, 0.0f, 360.0f, 1), s = uniformValues(n, 0.0f, 1.0f, 2), v = uniformValues(n, 0.0f, 1.0f, 3);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+        {
+            glm::vec3 rgb = HSVtoRGB(h[i], s[i], v[i]);
+            benchmark::DoNotOptimize(rgb);
+        }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_HSVtoRGB)->Apply(batchSizes);
+
+// the SIMD batch path of the same conversion, for comparison
+static void BM_HSVtoRGB_Batch(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> h = uniformValues(n, 0.0f, 360.0f, 1), s = uniformValues(n, 0.0f, 1.0f, 2), v = uniformValues(n, 0.0f, 1.0f, 3);
+    std::vector<float> in(n * 3), out(n * 3);
+    for (size_t i = 0; i < n; ++i)
+    {
+        in[i * 3] = h[i];
+        in[i * 3 + 1] = s[i];
+        in[i * 3 + 2] = v[i];
+    }
+    for (auto _ : state)
+    {
+        convertColorsInterleaved(ColorSpace::HSV, ColorSpace::SRGB, in.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_HSVtoRGB_Batch)->Apply(batchSizes);
+
+static void BM_pickerToRGB(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> h = uniformValues(n, 0.0f, 1.0f, 4), s = uniformValues(n, 0.0f, 1.0f, 5), v = uniformValues(n, 0.0f, 1.0f, 6);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+        {
+            glm::vec3 rgb = pickerToRGB(h[i], s[i], v[i]);
+            benchmark::DoNotOptimize(rgb);
+        }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_pickerToRGB)->Apply(batchSizes);
+
+// =======================================================
+// Bars and coordinates
+// =======================================================
+
+static void BM_calculateAlphaValue(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    // a little beyond the bar at both ends, so the clamping branches are taken too
+    std::vector<float> y = uniformValues(n, -1.0f, 1.0f, 7);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+            benchmark::DoNotOptimize(calculateAlphaValue(y[i]));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_calculateAlphaValue)->Apply(batchSizes);
+
+static void BM_calculateBrightnessValue(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> y = uniformValues(n, -1.0f, 1.0f, 8);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+            benchmark::DoNotOptimize(calculateBrightnessValue(y[i]));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_calculateBrightnessValue)->Apply(batchSizes);
+
+// queries the framebuffer size from GLFW on every call, as the callbacks do
+static void BM_screenToNDC(benchmark::State& state)
+{
+    if (!benchWindow)
+    {
+        state.SkipWithError("no GLFW window");
+        return;
+    }
+    size_t n = state.range(0);
+    std::vector<float> x = uniformValues(n, 0.0f, (float)WINDOW_SIZE, 9), y = uniformValues(n, 0.0f, (float)WINDOW_SIZE, 10);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+        {
+            float ndcx, ndcy;
+            screenToNDC(benchWindow, x[i], y[i], ndcx, ndcy);
+            benchmark::DoNotOptimize(ndcx);
+            benchmark::DoNotOptimize(ndcy);
+        }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_screenToNDC)->Apply(batchSizes);
+
+// =======================================================
+// Hit tests
+// =======================================================
+
+static void BM_is_inside_circle(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> x = uniformValues(n, -1.0f, 1.0f, 11), y = uniformValues(n, -1.0f, 1.0f, 12);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+            benchmark::DoNotOptimize(is_inside_circle(x[i], y[i]));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_is_inside_circle)->Apply(batchSizes);
+
+static void BM_is_inside_alpha_box(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> x = uniformValues(n, -1.0f, 1.0f, 13), y = uniformValues(n, -1.0f, 1.0f, 14);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+            benchmark::DoNotOptimize(is_inside_alpha_box(x[i], y[i]));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_is_inside_alpha_box)->Apply(batchSizes);
+
+static void BM_is_inside_value_box(benchmark::State& state)
+{
+    size_t n = state.range(0);
+    std::vector<float> x = uniformValues(n, -1.0f, 1.0f, 15), y = uniformValues(n, -1.0f, 1.0f, 16);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+            benchmark::DoNotOptimize(is_inside_value_box(x[i], y[i]));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_is_inside_value_box)->Apply(batchSizes);
+
+// =======================================================
+// The pick path
+// =======================================================
+
+// where the cursor is for BM_PickPath's first argument (window pixels)
+enum PickTarget
+{
+    PICK_WHEEL,
+    PICK_ALPHA_BAR,
+    PICK_VALUE_BAR,
+    PICK_NOTHING,
+    PICK_TARGET_COUNT
+};
+static const char* PICK_TARGET_NAMES[PICK_TARGET_COUNT] = { "wheel", "alpha_bar", "value_bar", "nothing" };
+static const double PICK_TARGET_POSITIONS[PICK_TARGET_COUNT][2] = { { 500, 300 }, { 740, 400 }, { 60, 400 }, { 780, 20 } };
+
+// a whole click as GLFW delivers it: press and release through mouse_button_callback, which
+// reads the cursor, converts it to NDC, runs the hit tests and updates the picker
+static void BM_PickPath(benchmark::State& state)
+{
+    if (!benchWindow)
+    {
+        state.SkipWithError("no GLFW window");
+        return;
+    }
+    int target = (int)state.range(0);
+    size_t n = state.range(1);
+    // GLFW won't move the cursor of a hidden window, so the callback is handed the position
+    setScriptedCursor(PICK_TARGET_POSITIONS[target][0], PICK_TARGET_POSITIONS[target][1]);
+    state.SetLabel(PICK_TARGET_NAMES[target]);
+    for (auto _ : state)
+        for (size_t i = 0; i < n; ++i)
+        {
+            mouse_button_callback(benchWindow, GLFW_MOUSE_BUTTON_LEFT, GLFW_PRESS, 0);
+            mouse_button_callback(benchWindow, GLFW_MOUSE_BUTTON_LEFT, GLFW_RELEASE, 0);
+        }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_PickPath)->ArgNames({ "target", "batch" })->ArgsProduct({ { PICK_WHEEL, PICK_ALPHA_BAR, PICK_VALUE_BAR, PICK_NOTHING }, { 8, 512, 32768 } });
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+#ifdef RGBPICK_SSE2
+    benchmark::AddCustomContext("rgbpick_simd", "sse2");
+#else
+    benchmark::AddCustomContext("rgbpick_simd", "scalar");
+#endif
+    // a hidden window of the app's default size for screenToNDC and the pick path
+    if (glfwInit())
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        benchWindow = glfwCreateWindow(WINDOW_SIZE, WINDOW_SIZE, "rgbpick-bench", NULL, NULL);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    glfwTerminate();
+    return 0;
+}
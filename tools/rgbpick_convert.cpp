@@ -0,0 +1,92 @@
+// rgbpick-convert: converts streams of colors between formats and color spaces with the
+// picker's own conversions (color_spaces.hpp), without a window or GL context.
+//
+//   rgbpick-convert [--from SPACE] [--to SPACE] [--in-format FMT] [--out-format FMT]
+//                   [--threads N] [--chunk COLORS] [--precision DIGITS] [input [output]]
+//
+// SPACE: srgb, linear, xyz, lab, lch, oklab, oklch, hsl, hsv (default srgb)
+// FMT:   csv, hex, f32, rgb8 (default csv); input and output default to stdin / stdout ("-")
+// Build: g++ -std=c++17 -O2 -I. tools/rgbpick_convert.cpp color_stream.cpp color_spaces.cpp -o rgbpick-convert -lpthread
+#include "color_stream.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static int usage()
+{
+    std::cerr << "usage: rgbpick-convert [--from SPACE] [--to SPACE] [--in-format FMT] [--out-format FMT]\n"
+                 "                       [--threads N] [--chunk COLORS] [--precision DIGITS] [input [output]]\n"
+                 "  SPACE: srgb linear xyz lab lch oklab oklch hsl hsv    FMT: csv hex f32 rgb8" << std::endl;
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    StreamOptions options;
+    std::string inputPath = "-", outputPath = "-";
+    int positional = 0;
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--from" && hasValue)
+        {
+            if (!parseColorSpace(argv[++i], options.from)) return usage();
+        }
+        else if (arg == "--to" && hasValue)
+        {
+            if (!parseColorSpace(argv[++i], options.to)) return usage();
+        }
+        else if (arg == "--in-format" && hasValue)
+        {
+            if (!parseStreamFormat(argv[++i], options.input)) return usage();
+        }
+        else if (arg == "--out-format" && hasValue)
+        {
+            if (!parseStreamFormat(argv[++i], options.output)) return usage();
+        }
+        else if (arg == "--threads" && hasValue)
+            options.threads = (unsigned)atoi(argv[++i]);
+        else if (arg == "--chunk" && hasValue)
+            options.chunkColors = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--precision" && hasValue)
+            options.precision = std::min(std::max(atoi(argv[++i]), 1), 9);
+        else if (arg == "--quiet")
+            quiet = true;
+        else if (arg.size() > 1 && arg[0] == '-' && arg != "-")
+            return usage();
+        else if (positional == 0)
+            inputPath = arg, ++positional;
+        else if (positional == 1)
+            outputPath = arg, ++positional;
+        else
+            return usage();
+    }
+
+    FILE* in = inputPath == "-" ? stdin : fopen(inputPath.c_str(), "rb");
+    if (!in)
+    {
+        std::cerr << "ERROR::CONVERT::CANNOT_OPEN " << inputPath << std::endl;
+        return 1;
+    }
+    FILE* out = outputPath == "-" ? stdout : fopen(outputPath.c_str(), "wb");
+    if (!out)
+    {
+        std::cerr << "ERROR::CONVERT::CANNOT_OPEN " << outputPath << std::endl;
+        return 1;
+    }
+
+    StreamStats stats;
+    bool ok = convertStream(in, out, options, stats);
+    if (in != stdin) fclose(in);
+    if (out != stdout && fclose(out) != 0) ok = false;
+    if (!quiet)
+        fprintf(stderr, "%zu colors %s -> %s in %.3f s (%.1f M colors/s, %zu chunks), %zu bad lines\n", stats.colors,
+            colorSpaceName(options.from), colorSpaceName(options.to), stats.seconds, stats.colors / stats.seconds * 1e-6,
+            stats.chunks, stats.badLines);
+    return ok ? 0 : 1;
+}
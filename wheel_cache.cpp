@@ -0,0 +1,84 @@
+#include "wheel_cache.hpp"
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+// =======================================================
+// Render-once wheel texture
+// =======================================================
+
+// the wheel is drawn first on a freshly cleared screen, so the cached copy is cleared with
+// the same color and its whole bounding rectangle can be blitted without blending
+static GLuint fbo;
+static GLuint colorTex;
+static WheelCacheKey cached;
+static bool cacheValid = false;
+
+void initWheelCache()
+{
+    glGenFramebuffers(1, &fbo);
+}
+
+bool wheelCacheStale(const WheelCacheKey& key)
+{
+    return !cacheValid ||
+        key.width != cached.width || key.height != cached.height ||
+        key.program != cached.program || key.value != cached.value || key.srgb != cached.srgb;
+}
+
+void beginWheelCacheUpdate(const WheelCacheKey& key)
+{
+    // the texture is only reallocated when the framebuffer size or format changes; in sRGB
+    // mode the wheel is written through GL_FRAMEBUFFER_SRGB into an sRGB texture, so the blit
+    // to the (also sRGB) default framebuffer is a plain copy of encoded values
+    if (!colorTex || key.width != cached.width || key.height != cached.height || key.srgb != cached.srgb)
+    {
+        if (!colorTex) glGenTextures(1, &colorTex);
+        glBindTexture(GL_TEXTURE_2D, colorTex);
+        glTexImage2D(GL_TEXTURE_2D, 0, key.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, key.width, key.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::WHEEL_CACHE::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, key.width, key.height);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    cached = key;
+    cacheValid = true;
+}
+
+void endWheelCacheUpdate()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, cached.width, cached.height);
+}
+
+void blitWheelCache(float extent)
+{
+    // bounding rectangle of [-extent, extent] in pixels, padded a pixel for rasterization rounding
+    int x0 = std::max(0, (int)std::floor((1.0f - extent) * 0.5f * cached.width) - 1);
+    int y0 = std::max(0, (int)std::floor((1.0f - extent) * 0.5f * cached.height) - 1);
+    int x1 = std::min(cached.width, (int)std::ceil((1.0f + extent) * 0.5f * cached.width) + 1);
+    int y1 = std::min(cached.height, (int)std::ceil((1.0f + extent) * 0.5f * cached.height) + 1);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(x0, y0, x1, y1, x0, y0, x1, y1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void releaseWheelCache()
+{
+    if (colorTex) glDeleteTextures(1, &colorTex);
+    colorTex = 0;
+    cacheValid = false;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// everything the cached wheel image depends on; any change triggers a re-render
+struct WheelCacheKey
+{
+    int width, height;  // framebuffer size
+    GLuint program;     // live wheel program (changes on shader hot reload)
+    float value;        // brightness the wheel is shaded at
+    bool srgb;          // stored as GL_SRGB8_ALPHA8 (sRGB pipeline) instead of GL_RGBA8
+};
+
+// creates the offscreen framebuffer; call once with a current GL context
+void initWheelCache();
+// true when the cached image doesn't match the key and has to be rendered again
+bool wheelCacheStale(const WheelCacheKey& key);
+// binds the offscreen framebuffer (resized to the key) and clears it; draw the wheel
+// in between begin and end exactly as it would be drawn on screen
+void beginWheelCacheUpdate(const WheelCacheKey& key);
+void endWheelCacheUpdate();
+// copies the cached wheel's bounding rectangle (NDC half extent `extent`) to the screen
+void blitWheelCache(float extent);
+// frees the offscreen texture, e.g. when caching is switched off
+void releaseWheelCache();